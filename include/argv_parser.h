@@ -29,12 +29,22 @@ extern "C" {
  * @param print_instructions: whether the instructions of the program should be
  * printed
  * @param print_bytecode: whether the bytecode of the program should be printed
+ * @param print_op_pairs: whether the pairs and triplets of instructions that
+ * are executed most often should be printed when the program ends
  * @param force_execution: whether to execute the program when `print_tokens`,
  * `print_ast` or `print_bytecode` are true
  * @param encoding: the encoding of the file to open, ignored if it is passed
  * through the command
  * @param no_default: whether to initialize the program with default variables
  * such as `true`, `false`, `Int`, `Str` etc...
+ * @param no_tail_calls: whether calls in tail position should create a new
+ * frame instead of replacing the one of the caller
+ * @param profile_path: the file where the call stacks sampled by the profiler
+ * are written, `NULL` when the program is not profiled
+ * @param print_gc_stats: whether a histogram of the pauses of the garbage
+ * collector should be printed when the program ends
+ * @param gc_step: the maximum number of objects and references of the old
+ * generation visited each time the garbage collector runs, `0` for no limit
  * @param opt_level: the optimization level of the program 0 through 3
  * @param command: the code to execute passed as a command line argument
  * @param filename: the file to execute
@@ -42,8 +52,13 @@ extern "C" {
  */
 NstEXP typedef struct _Nst_CLArgs {
     bool print_tokens, print_ast, print_instructions, print_bytecode;
+    bool print_op_pairs;
     bool force_execution;
     bool no_default;
+    bool no_tail_calls;
+    char *profile_path;
+    bool print_gc_stats;
+    usize gc_step;
     u8 opt_level;
     Nst_EncodingID encoding;
     i32 args_start;
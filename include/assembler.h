@@ -11,14 +11,23 @@
 
 #include "error.h"
 
-#define Nst_OP_CODE(op) ((Nst_OpCode)(((op) & 0xFF00) >> 8))
-#define Nst_OP_ARG(op) ((u8)((op) & 0x00FF))
+#define Nst_OP_CODE(op) ((Nst_OpCode)(((op) & 0xFF000000) >> 24))
+#define Nst_OP_ARG(op) ((u32)((op) & 0x00FFFFFF))
+/* The largest argument that fits in an instruction without extending it. */
+#define Nst_OP_ARG_MAX 0xFFFFFF
 
 #ifdef __cplusplus
 extern "C" {
 #endif // !__cplusplus
 
-/* Instruction IDs in the Nest virtual machine. */
+/**
+ * Instruction IDs in the Nest virtual machine.
+ *
+ * @brief The opcodes after `Nst_OP_JUMPIF_IEND` are never emitted by the
+ * assembler, the interpreter rewrites `Nst_OP_EXTRACT`, `Nst_OP_SET_CONT_VAL`
+ * and `Nst_OP_SET_CONT_LOC` into them when they are executed with a container
+ * and an index of a type they are specialized for.
+ */
 NstEXP typedef enum _Nst_OpCode {
     Nst_OP_POP_VAL,
     Nst_OP_FOR_START,
@@ -28,12 +37,12 @@ NstEXP typedef enum _Nst_OpCode {
     Nst_OP_SET_VAL_LOC,
     Nst_OP_SET_CONT_LOC,
     Nst_OP_THROW_ERR,
-    Nst_OP_POP_CATCH,
     Nst_OP_SET_VAL,
     Nst_OP_GET_VAL,
     Nst_OP_PUSH_VAL,
     Nst_OP_SET_CONT_VAL,
     Nst_OP_CALL,
+    Nst_OP_TAIL_CALL,
     Nst_OP_SEQ_CALL,
     Nst_OP_CAST,
     Nst_OP_RANGE,
@@ -54,17 +63,47 @@ NstEXP typedef enum _Nst_OpCode {
     Nst_OP_MAKE_FUNC,
     Nst_OP_SAVE_ERROR,
     Nst_OP_UNPACK_SEQ,
+    Nst_OP_PUSH_STACK_OP,
+    Nst_OP_GET_STACK_OP,
     Nst_OP_EXTEND_ARG,
     Nst_OP_JUMP,
     Nst_OP_JUMPIF_T,
     Nst_OP_JUMPIF_F,
     Nst_OP_JUMPIF_ZERO,
     Nst_OP_JUMPIF_IEND,
-    Nst_OP_PUSH_CATCH
+    Nst_OP_EXTRACT_SEQ_INT,
+    Nst_OP_EXTRACT_MAP,
+    Nst_OP_EXTRACT_STR_INT,
+    Nst_OP_SET_CONT_SEQ_INT,
+    Nst_OP_SET_CONT_MAP,
+    Nst_OP_SET_CONT_LOC_SEQ_INT,
+    Nst_OP_SET_CONT_LOC_MAP
 } Nst_OpCode;
 
-/* A bytecode instruction. */
-NstEXP typedef u16 Nst_Op;
+/**
+ * A bytecode instruction. The highest 8 bits are the opcode and the other 24
+ * are the argument. Larger arguments are preceded by an `Nst_OP_EXTEND_ARG`
+ * instruction that holds their upper bits.
+ */
+NstEXP typedef u32 Nst_Op;
+
+/**
+ * An entry of the exception table of some bytecode. An error raised by an
+ * instruction in the range [`start`, `end`) is caught by the `catch` block
+ * that begins at `handler`.
+ *
+ * @param start: the index of the first instruction covered by the entry
+ * @param end: the index after the last instruction covered by the entry
+ * @param handler: the index of the first instruction of the `catch` block
+ * @param stack_depth: the number of values of the function on the value stack
+ * when the `catch` block starts, the ones above are removed
+ */
+NstEXP typedef struct _Nst_ExceptionEntry {
+    usize start;
+    usize end;
+    usize handler;
+    usize stack_depth;
+} Nst_ExceptionEntry;
 
 /**
  * The structure representing Nest bytecode.
@@ -75,6 +114,9 @@ NstEXP typedef u16 Nst_Op;
  * @param positions: the positions of the instructions
  * @param obj_count: the number of objects in `objects`
  * @param objects: the array of objects used by the bytecode
+ * @param handler_len: the number of entries in `handlers`
+ * @param handlers: the exception table, its entries do not overlap and are
+ * sorted by their `start` field
  */
 NstEXP typedef struct _Nst_Bytecode {
     usize copy_count;
@@ -83,6 +125,8 @@ NstEXP typedef struct _Nst_Bytecode {
     Nst_Span *positions;
     usize obj_len;
     Nst_ObjRef **objects;
+    usize handler_len;
+    Nst_ExceptionEntry *handlers;
 } Nst_Bytecode;
 
 /**
@@ -99,8 +143,18 @@ NstEXP Nst_Bytecode *NstC Nst_bc_copy(Nst_Bytecode *bc);
  * copy made.
  */
 NstEXP void NstC Nst_bc_destroy(Nst_Bytecode *bc);
+/**
+ * Find the entry of the exception table of `bc` that covers the instruction at
+ * index `idx`.
+ *
+ * @return The entry or `NULL` if the instruction is outside any `try` block.
+ */
+NstEXP Nst_ExceptionEntry *NstC Nst_bc_find_handler(Nst_Bytecode *bc,
+                                                    usize idx);
 /* Print the bytecode to the standard output. */
 NstEXP void NstC Nst_bc_print(Nst_Bytecode *bc);
+/* @return The short name of an opcode used when printing the bytecode. */
+NstEXP const char *NstC Nst_op_name(Nst_OpCode op);
 
 #ifdef __cplusplus
 }
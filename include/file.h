@@ -252,7 +252,8 @@ NstEXP typedef enum _Nst_IOFileFlag {
     Nst_FLAG_IOFILE_CAN_WRITE = Nst_FLAG(3),
     Nst_FLAG_IOFILE_CAN_READ  = Nst_FLAG(4),
     Nst_FLAG_IOFILE_CAN_SEEK  = Nst_FLAG(5),
-    Nst_FLAG_IOFILE_IS_TTY    = Nst_FLAG(6)
+    Nst_FLAG_IOFILE_IS_TTY    = Nst_FLAG(6),
+    Nst_FLAG_IOFILE_CHECK_BOM = Nst_FLAG(7)
 } Nst_IOFileFlag;
 
 /**
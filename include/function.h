@@ -22,6 +22,7 @@ extern "C" {
 Nst_ObjRef *_Nst_func_new(Nst_Obj **arg_names, usize arg_num, Nst_Bytecode *bc);
 Nst_ObjRef *_Nst_func_new_outer_vars(Nst_Obj *func, Nst_Obj *vars);
 void _Nst_func_set_mod_globals(Nst_Obj *func, Nst_Obj *globals);
+void _Nst_func_set_outer_names(Nst_Obj *func, Nst_Obj *names);
 
 /**
  * Create a new function object with a C function body.
@@ -56,9 +57,19 @@ NstEXP Nst_Bytecode *NstC Nst_func_nest_body(Nst_Obj *func);
  */
 NstEXP Nst_Obj *NstC Nst_func_mod_globals(Nst_Obj *func);
 /**
- * @return The outer variables that the function can access when defined.
+ * @return The names of the variables of the enclosing function that the
+ * function captures. No reference is added. It is `NULL` for functions that
+ * capture every variable because they access `_vars_`, until a closure is
+ * created, and for functions with a C body.
  */
-NstEXP Nst_Obj *NstC Nst_func_outer_vars(Nst_Obj *func);
+NstEXP Nst_Obj *NstC Nst_func_outer_names(Nst_Obj *func);
+/**
+ * @return The values of the captured variables, in the same order as the
+ * names returned by `Nst_func_outer_names`. No reference is added. A slot is
+ * `NULL` when the variable was not defined in the enclosing function. It is
+ * `NULL` if the function is not a closure.
+ */
+NstEXP Nst_Obj **NstC Nst_func_outer_vals(Nst_Obj *func);
 
 /* `Nst_ObjTrav` function for `Func` objects. */
 NstEXP void NstC _Nst_func_traverse(Nst_Obj *func);
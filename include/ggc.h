@@ -19,6 +19,11 @@
 #define _Nst_GEN3_MAX 10
 /* The minimum size of the old generation needed to collect it. */
 #define _Nst_OLD_GEN_MIN 100
+/**
+ * The default number of objects and references of the old generation visited
+ * each time the garbage collector runs.
+ */
+#define _Nst_OLD_GEN_STEP 10000
 
 /**
  * The macro to add support to the GGC to an object structure.
@@ -27,16 +32,16 @@
  */
 #define Nst_GGC_HEAD                                                          \
     isize ggc_ref_count;                                                      \
-    Nst_Obj *p_prev;                                                          \
-    struct _Nst_GGCList *ggc_list
+    u32 ggc_idx;                                                              \
+    u32 ggc_gen
 
 /**
  * Initializes the fields of a `Nst_GGCObj`. Should be called after having
  * initialized all the other fields of the object.
  */
 #define Nst_GGC_OBJ_INIT(obj) do {                                            \
-    obj->p_prev = NULL;                                                       \
-    obj->ggc_list = NULL;                                                     \
+    obj->ggc_idx = 0;                                                         \
+    obj->ggc_gen = 0;                                                         \
     obj->ggc_ref_count = 0;                                                   \
     Nst_SET_FLAG(obj, Nst_FLAG_GGC_IS_SUPPORTED);                             \
     Nst_ggc_track_obj((Nst_GGCObj *)(obj));                                   \
@@ -46,8 +51,6 @@
 extern "C" {
 #endif // !__cplusplus
 
-struct _Nst_GGCList;
-
 /* The struct representing a garbage collector object. */
 NstEXP typedef struct _Nst_GGCObj {
     Nst_OBJ_HEAD;
@@ -57,14 +60,17 @@ NstEXP typedef struct _Nst_GGCObj {
 /**
  * The structure representing a generation of the garbage collector.
  *
- * @param head: the first object in the generation
- * @param tail: the last object in the generation
+ * @brief Each object stores its index in `objs` in `ggc_idx` and the
+ * generation it belongs to in `ggc_gen`.
+ *
+ * @param objs: the objects in the generation
  * @param len: the total number of objects in the generation
+ * @param cap: the capacity of `objs`
  */
 NstEXP typedef struct _Nst_GGCList {
-    Nst_GGCObj *head;
-    Nst_GGCObj *tail;
+    Nst_GGCObj **objs;
     usize len;
+    usize cap;
 } Nst_GGCList;
 
 /* Runs a general collection, that collects generations as needed. */
@@ -73,9 +79,22 @@ NstEXP void NstC Nst_ggc_collect(void);
 NstEXP void NstC Nst_ggc_track_obj(Nst_GGCObj *obj);
 /* Sets an `Nst_Obj` as reachable for the garbage collector. */
 NstEXP void NstC Nst_ggc_obj_reachable(Nst_Obj *obj);
+/**
+ * Sets the maximum number of objects and references of the old generation
+ * that are visited each time the garbage collector runs. The old generation is
+ * collected over multiple runs to keep the pauses short, `0` collects it all
+ * at once.
+ */
+NstEXP void NstC Nst_ggc_set_step(usize step);
+/* Sets whether the duration of each collection is recorded. */
+NstEXP void NstC Nst_ggc_record_pauses(bool record);
+/* Prints a histogram of the durations recorded by the garbage collector. */
+NstEXP void NstC Nst_ggc_print_pauses(void);
 
 void _Nst_ggc_quit(void);
 void _Nst_ggc_init(void);
+/* Removes an object that is being freed from its generation. */
+void _Nst_ggc_untrack_obj(Nst_GGCObj *obj);
 
 /* The flags of a garbage collector object. */
 NstEXP typedef enum _Nst_GGCFlags {
@@ -43,6 +43,9 @@ NstEXP typedef struct _Nst_StrConsts {
     Nst_ObjRef *t_Byte;
     Nst_ObjRef *t_IOFile;
     Nst_ObjRef *t_IEnd;
+    Nst_ObjRef *t_IntArray;
+    Nst_ObjRef *t_RealArray;
+    Nst_ObjRef *t_ByteArray;
 
     // Constant strings
 
@@ -89,6 +92,9 @@ NstEXP typedef struct _Nst_TypeObjs {
     Nst_ObjRef *Byte;
     Nst_ObjRef *IOFile;
     Nst_ObjRef *IEnd;
+    Nst_ObjRef *IntArray;
+    Nst_ObjRef *RealArray;
+    Nst_ObjRef *ByteArray;
 } Nst_TypeObjs;
 
 /**
@@ -137,6 +143,9 @@ typedef struct _Nst_IterFunctions {
 
     Nst_ObjRef *map_start;
     Nst_ObjRef *map_next;
+
+    Nst_ObjRef *typed_array_start;
+    Nst_ObjRef *typed_array_next;
 } Nst_IterFunctions;
 
 /**
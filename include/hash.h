@@ -27,6 +27,17 @@ extern "C" {
  */
 NstEXP i32 NstC Nst_obj_hash(Nst_Obj *obj);
 
+/**
+ * @return The seed used to hash strings. It is set by `Nst_init` from the
+ * `NEST_HASHSEED` environment variable: when it is not set the seed is `0`,
+ * when it is `random` a different seed is chosen for each process and
+ * otherwise the variable is read as an unsigned integer. Any other value makes
+ * `Nst_init` fail.
+ */
+NstEXP u64 NstC Nst_hash_seed(void);
+
+bool _Nst_hash_init(void);
+
 #ifdef __cplusplus
 }
 #endif // !__cplusplus
@@ -28,12 +28,12 @@ NstEXP typedef enum _Nst_InstCode {
     Nst_IC_SET_VAL_LOC,
     Nst_IC_SET_CONT_LOC,
     Nst_IC_THROW_ERR,
-    Nst_IC_POP_CATCH,
     Nst_IC_SET_VAL,
     Nst_IC_GET_VAL,
     Nst_IC_PUSH_VAL,
     Nst_IC_SET_CONT_VAL,
     Nst_IC_OP_CALL,
+    Nst_IC_OP_TAIL_CALL,
     Nst_IC_OP_SEQ_CALL,
     Nst_IC_OP_CAST,
     Nst_IC_OP_RANGE,
@@ -54,6 +54,8 @@ NstEXP typedef enum _Nst_InstCode {
     Nst_IC_MAKE_FUNC,
     Nst_IC_SAVE_ERROR,
     Nst_IC_UNPACK_SEQ,
+    Nst_IC_PUSH_STACK_OP,
+    Nst_IC_GET_STACK_OP,
     Nst_IC_JUMP,
     Nst_IC_JUMPIF_T,
     Nst_IC_JUMPIF_F,
@@ -62,6 +64,17 @@ NstEXP typedef enum _Nst_InstCode {
     Nst_IC_PUSH_CATCH
 } Nst_InstCode;
 
+/**
+ * Build the value of an `Nst_IC_PUSH_STACK_OP` or `Nst_IC_GET_STACK_OP`
+ * instruction from the index of its object and the `Nst_TokType` of its
+ * operator.
+ */
+#define Nst_INST_FUSED_VAL(obj_idx, op) (((i64)(obj_idx) << 8) | (i64)(op))
+/* The index of the object of a fused stack operation. */
+#define Nst_INST_FUSED_OBJ(val) ((usize)((val) >> 8))
+/* The `Nst_TokType` of the operator of a fused stack operation. */
+#define Nst_INST_FUSED_OP(val) ((Nst_TokType)((val) & 0xFF))
+
 /**
  * A structure representing a Nest instruction.
  *
@@ -161,7 +174,8 @@ NstEXP Nst_FuncPrototype *NstC Nst_ilist_get_func(Nst_InstList *list,
  * @return The object associated with the instruction at `idx`. The equivalent
  * of getting an instruction with `Nst_ilist_get_inst` and then getting the
  * object with `Nst_ilist_get_obj` using the value of the instruction as the
- * index.
+ * index. For fused stack operations the index is taken with
+ * `Nst_INST_FUSED_OBJ`.
  */
 NstEXP Nst_Obj *NstC Nst_ilist_get_inst_obj(Nst_InstList *list, usize idx);
 /**
@@ -22,19 +22,20 @@ extern "C" {
  * invalid data and are not safe to read
  * @param v_stack: the value stack
  * @param f_stack: the call stack
- * @param c_stack: the catch frame stack
  * @param func: the function currently being executed
  * @param vt: the current variable table
  * @param idx: the index of the current bytecode instruction
+ * @param vstack_base: the index of the first value of the current function in
+ * the value stack
  */
 NstEXP typedef struct _Nst_InterpreterState {
     Nst_Program *prog;
     Nst_ValueStack v_stack;
-    Nst_CallStack  f_stack;
-    Nst_CatchStack c_stack;
+    Nst_CallStack f_stack;
     Nst_Obj *func;
     Nst_VarTable vt;
     i64 idx;
+    usize vstack_base;
 } Nst_InterpreterState;
 
 /**
@@ -102,13 +103,17 @@ NstEXP Nst_ObjRef *NstC Nst_func_call(Nst_Obj *func, usize arg_num,
  * return without modifying the state of the interpreter. This is to allow the
  * caller to allocate enough memory to hold the stack.
  *
+ * It must be called by a C function that was called directly by the function
+ * that is paused, not through another C function.
+ *
  * @param out_stack: buffer filled with the values from the top function call,
  * each object added is a reference to be handled by the caller
  * @param out_stack_size: the number of object added to `out_stack`
  * @param out_idx: the index of the current instruction
  * @param out_vt: the current variable table
  *
- * @return The paused function.
+ * @return The paused function or `NULL` if it cannot be paused. The error is
+ * set.
  */
 NstEXP Nst_Obj *NstC Nst_coroutine_yield(Nst_ObjRef **out_stack,
                                          usize *out_stack_size,
@@ -11,13 +11,56 @@
 
 #include "lib_import.h"
 
+/* Check if an `Iter` object has the `Nst_FLAG_ITER_IS_NATIVE` flag. */
+#define Nst_ITER_IS_NATIVE(iter) ((iter)->flags & Nst_FLAG_ITER_IS_NATIVE)
+
 #ifdef __cplusplus
 extern "C" {
 #endif // !__cplusplus
 
+/* [docs:link Nst_UNPACK_FAILED Nst_IterUnpackResult] */
+/* [docs:link Nst_UNPACK_END Nst_IterUnpackResult] */
+/* [docs:link Nst_UNPACK_SUCCESS Nst_IterUnpackResult] */
+/* [docs:link Nst_UNPACK_UNSUPPORTED Nst_IterUnpackResult] */
+
+/**
+ * The result of getting the next value of an iterator already unpacked.
+ *
+ * @param Nst_UNPACK_FAILED: an error occurred, the error is set
+ * @param Nst_UNPACK_END: the iterator has no more values
+ * @param Nst_UNPACK_SUCCESS: the values were written
+ * @param Nst_UNPACK_UNSUPPORTED: the iterator cannot produce the requested
+ * number of values directly, it was not advanced
+ */
+NstEXP typedef enum _Nst_IterUnpackResult {
+    Nst_UNPACK_FAILED = -1,
+    Nst_UNPACK_END,
+    Nst_UNPACK_SUCCESS,
+    Nst_UNPACK_UNSUPPORTED
+} Nst_IterUnpackResult;
+
+/**
+ * The type of a function that gets the next value of an iterator already
+ * unpacked, without creating the sequence returned by its `next` function.
+ *
+ * @brief The values must be the same as the ones of the sequence that `next`
+ * would return.
+ *
+ * @param value: the `value` of the iterator
+ * @param count: the number of values to unpack
+ * @param out: the array where the new references to the `count` values are
+ * written in order, it is written only when `Nst_UNPACK_SUCCESS` is returned
+ */
+NstEXP typedef Nst_IterUnpackResult (*Nst_IterUnpackFunc)(Nst_Obj *value,
+                                                          usize count,
+                                                          Nst_ObjRef **out);
+
 /**
  * Create a new Nest iterator object.
  *
+ * @brief When both `start` and `next` are C functions that take exactly one
+ * argument the iterator is native and they are called directly.
+ *
  * @brief Note: this function takes one reference of `start`, `next` and
  * `value` both on success and on failure.
  *
@@ -52,6 +95,8 @@ NstEXP Nst_Obj *NstC Nst_iter_value(Nst_Obj *iter);
 /**
  * Call the `start` function of an `Iter` object.
  *
+ * @brief The result of the function is discarded.
+ *
  * @param iter: the iterator to start
  *
  * @return `true` on success and `false` on success. The error is set.
@@ -68,6 +113,30 @@ NstEXP bool NstC Nst_iter_start(Nst_Obj *iter);
  */
 NstEXP Nst_ObjRef *NstC Nst_iter_next(Nst_Obj *iter);
 
+/**
+ * Set the function that gets the next value of a native iterator already
+ * unpacked.
+ *
+ * @param iter: the iterator to modify, it must be native
+ * @param unpack: the function to set
+ */
+NstEXP void NstC Nst_iter_set_unpack(Nst_Obj *iter, Nst_IterUnpackFunc unpack);
+
+/**
+ * Get the next value of an `Iter` object unpacked into `count` values.
+ *
+ * @param iter: the iterator to get the values from
+ * @param count: the number of values to unpack
+ * @param out: the array where the new references to the values are written
+ *
+ * @return The result of the operation, `Nst_UNPACK_UNSUPPORTED` is returned
+ * when the iterator has no unpack function, in which case `Nst_iter_next` must
+ * be used.
+ */
+NstEXP Nst_IterUnpackResult NstC Nst_iter_next_unpacked(Nst_Obj *iter,
+                                                         usize count,
+                                                         Nst_ObjRef **out);
+
 /* Create a new range object. */
 NstEXP Nst_ObjRef *NstC Nst_iter_range_new(i64 start, i64 stop, i64 step);
 /* Create a new sequence iterator. */
@@ -76,6 +145,8 @@ NstEXP Nst_ObjRef *NstC Nst_iter_seq_new(Nst_Obj *seq);
 NstEXP Nst_ObjRef *NstC Nst_iter_str_new(Nst_Obj *seq);
 /* Create a new map iterator. */
 NstEXP Nst_ObjRef *NstC Nst_iter_map_new(Nst_Obj *seq);
+/* Create a new typed array iterator. */
+NstEXP Nst_ObjRef *NstC Nst_iter_typed_array_new(Nst_Obj *arr);
 
 // Functions for range iterators
 
@@ -105,6 +176,28 @@ NstEXP Nst_ObjRef *NstC Nst_iter_map_start(usize arg_num, Nst_Obj **args);
 /* The `next` function of the map iterator. */
 NstEXP Nst_ObjRef *NstC Nst_iter_map_next(usize arg_num, Nst_Obj **args);
 
+// Functions for typed array iterators
+
+/* The `start` function of the typed array iterator. */
+NstEXP Nst_ObjRef *NstC Nst_iter_typed_array_start(usize arg_num,
+                                                   Nst_Obj **args);
+/* The `next` function of the typed array iterator. */
+NstEXP Nst_ObjRef *NstC Nst_iter_typed_array_next(usize arg_num,
+                                                  Nst_Obj **args);
+
+/* [docs:link Nst_FLAG_ITER_IS_NATIVE Nst_IterFlags] */
+
+/**
+ * Flags for `Iter` objects.
+ *
+ * @param Nst_FLAG_ITER_IS_NATIVE: the `start` and `next` functions of the
+ * iterator have a C body that is called directly, without going through
+ * `Nst_func_call`
+ */
+NstEXP typedef enum _Nst_IterFlags {
+    Nst_FLAG_ITER_IS_NATIVE = Nst_FLAG(1)
+} Nst_IterFlags;
+
 #ifdef __cplusplus
 }
 #endif // !__cplusplus
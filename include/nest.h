@@ -31,6 +31,7 @@
 #endif // !Nst_VERSION
 
 #include "iter.h"
+#include "typed_array.h"
 #include "hash.h"
 #include "obj_ops.h"
 #include "tokens.h"
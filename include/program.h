@@ -22,11 +22,26 @@ extern "C" {
  * @param main_func: the main function of a program
  * @param argv: arguments passed to the program
  * @param source_path: the path of the main file
+ * @param print_op_pairs: whether to count the instructions executed and print
+ * the most frequent pairs and triplets when the program ends
+ * @param no_tail_calls: whether calls in tail position should create a new
+ * frame instead of replacing the one of the caller
+ * @param profile_path: the file where the call stacks sampled while the
+ * program runs are written, `NULL` to not profile the program
+ * @param print_gc_stats: whether to print a histogram of the pauses of the
+ * garbage collector when the program ends
+ * @param gc_step: the maximum number of objects and references of the old
+ * generation visited each time the garbage collector runs, `0` for no limit
  */
 NstEXP typedef struct _Nst_Program {
     Nst_ObjRef *main_func;
     Nst_ObjRef *argv;
     Nst_ObjRef *source_path;
+    bool print_op_pairs;
+    bool no_tail_calls;
+    const char *profile_path;
+    bool print_gc_stats;
+    usize gc_step;
 } Nst_Program;
 
 /* [docs:link Nst_EK_ERROR Nst_ExecutionKind] */
@@ -39,14 +39,15 @@ NstEXP typedef struct _Nst_ValueStack {
  * @param span: the position of the call
  * @param vt: the variable table of the call
  * @param idx: the instruction index of the call
- * @param cstack_len: the size of the catch stack when the function was called
+ * @param vstack_base: the index in the value stack of the first value of the
+ * calling function
  */
 NstEXP typedef struct _Nst_FuncCall {
     Nst_ObjRef *func;
     Nst_Span span;
     Nst_VarTable vt;
     i64 idx;
-    usize cstack_len;
+    usize vstack_base;
 } Nst_FuncCall;
 
 /**
@@ -64,33 +65,6 @@ NstEXP typedef struct _Nst_CallStack {
     usize max_recursion_depth;
 } Nst_CallStack;
 
-/**
- * A structure representing the state of the stack when a catch was pushed and
- * that is restored if an error occurs.
- *
- * @param f_stack_len: the size of the call stack
- * @param v_stack_len: the size of the value stack
- * @param inst_idx: the instruction index
- */
-NstEXP typedef struct _Nst_CatchFrame {
-    usize f_stack_len;
-    usize v_stack_len;
-    i64 idx;
-} Nst_CatchFrame;
-
-/**
- * A structure representing the catch stack.
- *
- * @param stack: the catch frames in the stack
- * @param len: the current size of the stack
- * @param cap: the maximum size of the stack before it needs to be expanded
- */
-NstEXP typedef struct _Nst_CatchStack {
-    Nst_CatchFrame *stack;
-    usize len;
-    usize cap;
-} Nst_CatchStack;
-
 /**
  * Initialize a value stack.
  *
@@ -107,7 +81,8 @@ NstEXP bool NstC Nst_vstack_init(Nst_ValueStack *v_stack);
  */
 NstEXP bool NstC Nst_vstack_push(Nst_ValueStack *v_stack, Nst_Obj *obj);
 /**
- * Pop the top value from a value stack.
+ * Pop the top value from a value stack. The stack is never shrunk, use
+ * `Nst_vstack_shrink` to release the unused memory.
  *
  * @param v_stack: the value stack to pop the value from
  *
@@ -124,6 +99,11 @@ NstEXP Nst_ObjRef *NstC Nst_vstack_pop(Nst_ValueStack *v_stack);
  * returned. No error is set.
  */
 NstEXP Nst_Obj *NstC Nst_vstack_peek(Nst_ValueStack *v_stack);
+/**
+ * Halve the capacity of a value stack if less than an eighth of it is used.
+ * The capacity is never less than `_Nst_V_STACK_MIN_SIZE`.
+ */
+NstEXP void NstC Nst_vstack_shrink(Nst_ValueStack *v_stack);
 /**
  * Duplicate the top value of a value stack.
  *
@@ -159,7 +139,8 @@ NstEXP bool NstC Nst_fstack_init(Nst_CallStack *f_stack);
  */
 NstEXP bool NstC Nst_fstack_push(Nst_CallStack *f_stack, Nst_FuncCall call);
 /**
- * Pop the top call from a call stack
+ * Pop the top call from a call stack. The stack is never shrunk, use
+ * `Nst_fstack_shrink` to release the unused memory.
  *
  * @param f_stack: the call stack to pop the value from
  *
@@ -176,47 +157,11 @@ NstEXP Nst_FuncCall NstC Nst_fstack_pop(Nst_CallStack *f_stack);
  * `Nst_FuncCall` with a `NULL` `func` and `vt` is returned. No error is set.
  */
 NstEXP Nst_FuncCall NstC Nst_fstack_peek(Nst_CallStack *f_stack);
+/* Halve the capacity of a call stack if less than an eighth of it is used. */
+NstEXP void NstC Nst_fstack_shrink(Nst_CallStack *f_stack);
 /* Destroy the contents of a call stack. */
 NstEXP void NstC Nst_fstack_destroy(Nst_CallStack *f_stack);
 
-/**
- * Initialize a catch stack.
- *
- * @param c_stack: the catch stack to initialize
- *
- * @return `true` on success and `false` on failure. The error is set.
- */
-NstEXP bool NstC Nst_cstack_init(Nst_CatchStack *c_stack);
-/**
- * Push a frame on a catch stack.
- *
- * @param c_stack: the catch stack to push the frame onto
- * @param frame: the `Nst_CatchFrame` to push on the stack
- *
- * @return `true` on success and `false` on failure. The error is set.
- */
-NstEXP bool NstC Nst_cstack_push(Nst_CatchStack *c_stack, Nst_CatchFrame frame);
-/**
- * Peek at the top frame of a catch stack.
- *
- * @param c_stack: the catch stack to peek from
- *
- * @return The top value of the catch stack. If the stack is empty a
- * `Nst_CatchFrame` with an `inst_idx` of `-1` is returned. No error is set.
- */
-NstEXP Nst_CatchFrame NstC Nst_cstack_peek(Nst_CatchStack *c_stack);
-/**
- * Pop the top value of a catch stack.
- *
- * @param c_stack: the catch stack to pop the frame from
- *
- * @return The popped frame. If the stack is empty a `Nst_CatchFrame` with an
- * `inst_idx` of `-1` is returned. No error is set.
- */
-NstEXP Nst_CatchFrame NstC Nst_cstack_pop(Nst_CatchStack *c_stack);
-/* Destroy the contents of a catch stack. */
-NstEXP void NstC Nst_cstack_destroy(Nst_CatchStack *c_stack);
-
 #ifdef __cplusplus
 }
 #endif // !__cplusplus
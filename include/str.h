@@ -79,6 +79,23 @@ NstEXP Nst_ObjRef *NstC Nst_str_new_len(u8 *val, usize len, usize char_len,
  * set.
  */
 NstEXP Nst_ObjRef *NstC Nst_str_copy(Nst_Obj *src);
+/**
+ * Create a new string with the characters of an existing one that go from
+ * `start` to `stop`.
+ *
+ * @brief When the slice reaches the end of `str` and is at least half as long
+ * as the buffer that contains it, the buffer is shared instead of being
+ * copied.
+ *
+ * @param str: the string to take the slice of
+ * @param start: the index of the first character of the slice
+ * @param stop: the index after the last character of the slice, it must be
+ * greater than or equal to `start` and less than or equal to the length of
+ * `str`
+ *
+ * @return The new string on success and `NULL` on failure. The error is set.
+ */
+NstEXP Nst_ObjRef *NstC Nst_str_slice(Nst_Obj *str, usize start, usize stop);
 /**
  * Create a new string by making a string representation of an existing one
  * that replaces any special characters such as newlines and tabs with their
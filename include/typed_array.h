@@ -0,0 +1,153 @@
+/**
+ * @file typed_array.h
+ *
+ * @brief `IntArray`, `RealArray` and `ByteArray` objects interface
+ *
+ * @author TheSilvered
+ */
+
+#ifndef TYPED_ARRAY_H
+#define TYPED_ARRAY_H
+
+#include "obj.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // !__cplusplus
+
+/**
+ * Create a new `IntArray` object of the specified length. The values are
+ * initialized to `0`.
+ *
+ * @param len: the length of the array to create
+ *
+ * @return The new object on success or `NULL` on failure. The error is set.
+ */
+NstEXP Nst_ObjRef *NstC Nst_int_array_new(usize len);
+/**
+ * Create a new `RealArray` object of the specified length. The values are
+ * initialized to `0.0`.
+ *
+ * @param len: the length of the array to create
+ *
+ * @return The new object on success or `NULL` on failure. The error is set.
+ */
+NstEXP Nst_ObjRef *NstC Nst_real_array_new(usize len);
+/**
+ * Create a new `ByteArray` object of the specified length. The values are
+ * initialized to `0b`.
+ *
+ * @param len: the length of the array to create
+ *
+ * @return The new object on success or `NULL` on failure. The error is set.
+ */
+NstEXP Nst_ObjRef *NstC Nst_byte_array_new(usize len);
+/**
+ * Create a new `ByteArray` object that uses an existing buffer for its values.
+ *
+ * @brief The array takes ownership of `values`, which must be allocated on the
+ * heap with the allocation functions of `mem.h`. It is freed even when the
+ * function fails.
+ *
+ * @param values: the buffer to use, can be `NULL` only if `len` is `0`
+ * @param len: the number of bytes in `values`
+ *
+ * @return The new object on success or `NULL` on failure. The error is set.
+ */
+NstEXP Nst_ObjRef *NstC Nst_byte_array_from_buf(u8 *values, usize len);
+/**
+ * Create a new typed array of the same type and with the same values as
+ * another.
+ *
+ * @param arr: the array to copy
+ *
+ * @return The new object on success or `NULL` on failure. The error is set.
+ */
+NstEXP Nst_ObjRef *NstC Nst_typed_array_copy(Nst_Obj *arr);
+
+void _Nst_typed_array_destroy(Nst_Obj *arr);
+/* Change the length of a typed array, new values are set to `0`. */
+bool _Nst_typed_array_resize(Nst_Obj *arr, usize len);
+
+/**
+ * @return `true` if the object is an `IntArray`, a `RealArray` or a
+ * `ByteArray` and `false` otherwise.
+ */
+NstEXP bool NstC Nst_is_typed_array(Nst_Obj *obj);
+/**
+ * @return The type of the elements of a typed array (`Int`, `Real` or
+ * `Byte`). No reference is added.
+ */
+NstEXP Nst_Obj *NstC Nst_typed_array_elem_type(Nst_Obj *arr);
+/**
+ * @return The length of a typed array.
+ */
+NstEXP usize NstC Nst_typed_array_len(Nst_Obj *arr);
+/**
+ * @return The size in bytes of the elements of a typed array.
+ */
+NstEXP usize NstC Nst_typed_array_elem_size(Nst_Obj *arr);
+/**
+ * @return The values of a typed array as a generic pointer.
+ */
+NstEXP void *NstC Nst_typed_array_values(Nst_Obj *arr);
+/**
+ * @return The values of an `IntArray`.
+ */
+NstEXP i64 *NstC Nst_int_array_values(Nst_Obj *arr);
+/**
+ * @return The values of a `RealArray`.
+ */
+NstEXP f64 *NstC Nst_real_array_values(Nst_Obj *arr);
+/**
+ * @return The values of a `ByteArray`.
+ */
+NstEXP u8 *NstC Nst_byte_array_values(Nst_Obj *arr);
+
+/**
+ * Change the value of an index in a typed array.
+ *
+ * @brief `idx` can be negative in which case it is subtracted from the length
+ * of the array to get the new index. An `IntArray` accepts `Int` and `Byte`
+ * values, a `RealArray` accepts `Int`, `Real` and `Byte` values and a
+ * `ByteArray` accepts `Byte` values and `Int` values between `0` and `255`.
+ *
+ * @param arr: the array to modify
+ * @param idx: the index to update
+ * @param val: the value to set the index to
+ *
+ * @return `true` on success and `false` on failure. The error is set. This
+ * function fails when the index is outside the array, when the type of `val`
+ * is not accepted or when an `Int` does not fit in a `ByteArray`.
+ */
+NstEXP bool NstC Nst_typed_array_set(Nst_Obj *arr, i64 idx, Nst_Obj *val);
+/**
+ * Get a value in a typed array, creating the object that contains it.
+ *
+ * @param arr: the array to get the value from
+ * @param idx: the index of the value to get, if negative it is subtracted
+ * from the length of the array
+ *
+ * @return The new object on success and `NULL` on failure. The error is set.
+ * The function fails when the index is outside the array.
+ */
+NstEXP Nst_ObjRef *NstC Nst_typed_array_get(Nst_Obj *arr, i64 idx);
+/**
+ * Get a value in a typed array quickly, creating the object that contains
+ * it.
+ *
+ * @brief Warning: use this function only if you are certain that `idx` is
+ * inside `arr`. Bound checks are only performed in debug builds.
+ *
+ * @param arr: the array to get the value from
+ * @param idx: the index of the value to get
+ *
+ * @return The new object on success and `NULL` on failure. The error is set.
+ */
+NstEXP Nst_ObjRef *NstC Nst_typed_array_getf(Nst_Obj *arr, usize idx);
+
+#ifdef __cplusplus
+}
+#endif // !__cplusplus
+
+#endif // !TYPED_ARRAY_H
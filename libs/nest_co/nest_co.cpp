@@ -282,7 +282,8 @@ Nst_Obj *NstC yield_(usize arg_num, Nst_Obj **args)
     }
 
     usize stack_size;
-    Nst_coroutine_yield(nullptr, &stack_size, nullptr, nullptr);
+    if (Nst_coroutine_yield(nullptr, &stack_size, nullptr, nullptr) == nullptr)
+        return nullptr;
     co->stack_size = stack_size + 1;
     co->stack = Nst_malloc_c(co->stack_size, Nst_Obj *);
     if (co->stack == nullptr)
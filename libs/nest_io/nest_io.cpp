@@ -15,6 +15,7 @@ static Nst_Declr obj_list_[] = {
     Nst_FUNCDECLR(write_bytes_, 2),
     Nst_FUNCDECLR(read_, 2),
     Nst_FUNCDECLR(read_bytes_, 2),
+    Nst_FUNCDECLR(read_byte_array_, 2),
     Nst_FUNCDECLR(file_size_, 1),
     Nst_FUNCDECLR(seek_, 3),
     Nst_FUNCDECLR(flush_, 1),
@@ -479,8 +480,13 @@ Nst_Obj *NstC write_bytes_(usize arg_num, Nst_Obj **args)
     Nst_Obj *f;
     Nst_Obj *seq;
 
-    if (!Nst_extract_args("F A.B", arg_num, args, &f, &seq))
+    if (!Nst_extract_args(
+            "F A|#.B",
+            arg_num, args,
+            &f, Nst_type()->ByteArray, &seq))
+    {
         return nullptr;
+    }
 
     if (Nst_IOF_IS_CLOSED(f)) {
         SET_FILE_CLOSED_ERROR;
@@ -493,18 +499,29 @@ Nst_Obj *NstC write_bytes_(usize arg_num, Nst_Obj **args)
         return nullptr;
     }
 
-    usize seq_len = Nst_seq_len(seq);
-    Nst_Obj **objs = Nst_seq_objs(seq);
-    u8 *bytes = Nst_malloc_c(seq_len + 1, u8);
-    if (bytes == nullptr)
-        return nullptr;
+    usize count;
+    Nst_IOResult result;
+
+    // the values of a ByteArray are already contiguous
+    if (Nst_T(seq, ByteArray)) {
+        result = Nst_fwrite(
+            Nst_byte_array_values(seq),
+            Nst_typed_array_len(seq),
+            &count, f);
+    } else {
+        usize seq_len = Nst_seq_len(seq);
+        Nst_Obj **objs = Nst_seq_objs(seq);
+        u8 *bytes = Nst_malloc_c(seq_len + 1, u8);
+        if (bytes == nullptr)
+            return nullptr;
 
-    for (usize i = 0; i < seq_len; i++)
-        bytes[i] = Nst_byte_u8(objs[i]);
+        for (usize i = 0; i < seq_len; i++)
+            bytes[i] = Nst_byte_u8(objs[i]);
+
+        result = Nst_fwrite(bytes, seq_len, &count, f);
+        Nst_free(bytes);
+    }
 
-    usize count;
-    Nst_IOResult result = Nst_fwrite(bytes, seq_len, &count, f);
-    Nst_free(bytes);
     if (result == Nst_IO_ERROR) {
         Nst_error_setc_call("failed to write all bytes");
         return nullptr;
@@ -580,32 +597,23 @@ Nst_Obj *NstC read_(usize arg_num, Nst_Obj **args)
     return Nst_str_new(buf, buf_len, true);
 }
 
-Nst_Obj *NstC read_bytes_(usize arg_num, Nst_Obj **args)
+static bool read_bin_file(Nst_Obj *f, i64 bytes_to_read, u8 **buf,
+                          usize *buf_len)
 {
-    Nst_Obj *f;
-    Nst_Obj *bytes_to_read_obj;
-
-    if (!Nst_extract_args("F ?i", arg_num, args, &f, &bytes_to_read_obj))
-        return nullptr;
-    i64 bytes_to_read = Nst_DEF_VAL(
-        bytes_to_read_obj,
-        Nst_int_i64(bytes_to_read_obj),
-        -1);
-
     if (Nst_IOF_IS_CLOSED(f)) {
         SET_FILE_CLOSED_ERROR;
-        return nullptr;
+        return false;
     } else if (!Nst_IOF_CAN_READ(f)) {
         Nst_error_setc_value("the file does not support reading");
-        return nullptr;
+        return false;
     } else if (!Nst_IOF_IS_BIN(f)) {
         Nst_error_setc_value("the file is not binary, try using 'read'");
-        return nullptr;
+        return false;
     }
 
     if (!Nst_IOF_CAN_SEEK(f) && bytes_to_read < 0) {
         Nst_error_setc_value("the file must be seekable to read it entierly");
-        return nullptr;
+        return false;
     } else if (Nst_IOF_CAN_SEEK(f)) {
         usize start;
         Nst_ftell(f, &start);
@@ -616,20 +624,37 @@ Nst_Obj *NstC read_bytes_(usize arg_num, Nst_Obj **args)
             bytes_to_read = max_size;
     }
 
-    u8 *buf;
-    usize buf_len;
     Nst_IOResult result = Nst_fread(
-        (u8 *)&buf, 0,
-        usize(bytes_to_read), &buf_len,
+        (u8 *)buf, 0,
+        usize(bytes_to_read), buf_len,
         f);
 
     if (result == Nst_IO_ALLOC_FAILED) {
         Nst_error_failed_alloc();
-        return nullptr;
+        return false;
     } else if (result == Nst_IO_ERROR) {
         Nst_error_setc_call("failed to read the file");
-        return nullptr;
+        return false;
     }
+    return true;
+}
+
+Nst_Obj *NstC read_bytes_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *f;
+    Nst_Obj *bytes_to_read_obj;
+
+    if (!Nst_extract_args("F ?i", arg_num, args, &f, &bytes_to_read_obj))
+        return nullptr;
+    i64 bytes_to_read = Nst_DEF_VAL(
+        bytes_to_read_obj,
+        Nst_int_i64(bytes_to_read_obj),
+        -1);
+
+    u8 *buf;
+    usize buf_len;
+    if (!read_bin_file(f, bytes_to_read, &buf, &buf_len))
+        return nullptr;
 
     Nst_Obj *bytes_array = Nst_array_new(buf_len);
 
@@ -640,6 +665,27 @@ Nst_Obj *NstC read_bytes_(usize arg_num, Nst_Obj **args)
     return bytes_array;
 }
 
+Nst_Obj *NstC read_byte_array_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *f;
+    Nst_Obj *bytes_to_read_obj;
+
+    if (!Nst_extract_args("F ?i", arg_num, args, &f, &bytes_to_read_obj))
+        return nullptr;
+    i64 bytes_to_read = Nst_DEF_VAL(
+        bytes_to_read_obj,
+        Nst_int_i64(bytes_to_read_obj),
+        -1);
+
+    u8 *buf;
+    usize buf_len;
+    if (!read_bin_file(f, bytes_to_read, &buf, &buf_len))
+        return nullptr;
+
+    // the buffer read from the file becomes the one of the array
+    return Nst_byte_array_from_buf(buf, buf_len);
+}
+
 Nst_Obj *NstC file_size_(usize arg_num, Nst_Obj **args)
 {
     Nst_Obj *f;
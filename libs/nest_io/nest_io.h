@@ -22,6 +22,7 @@ Nst_Obj *NstC write_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC write_bytes_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC read_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC read_bytes_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC read_byte_array_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC file_size_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC seek_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC flush_(usize arg_num, Nst_Obj **args);
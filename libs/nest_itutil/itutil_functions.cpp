@@ -299,6 +299,29 @@ Nst_Obj *NstC zip_next(usize arg_num, Nst_Obj **args)
     return arr;
 }
 
+Nst_IterUnpackResult NstC zip_unpack(Nst_Obj *value, usize count,
+                                     Nst_Obj **out)
+{
+    ZipData *data = (ZipData *)Nst_obj_custom_data(value);
+    if (count != data->count)
+        return Nst_UNPACK_UNSUPPORTED;
+
+    Nst_Obj **iterators = data->iterators;
+    for (usize i = 0; i < count; i++) {
+        Nst_Obj *res = Nst_iter_next(iterators[i]);
+        if (res == nullptr || res == Nst_iend()) {
+            for (usize j = 0; j < i; j++)
+                Nst_dec_ref(out[j]);
+            if (res == nullptr)
+                return Nst_UNPACK_FAILED;
+            Nst_dec_ref(res);
+            return Nst_UNPACK_END;
+        }
+        out[i] = res;
+    }
+    return Nst_UNPACK_SUCCESS;
+}
+
 // ------------------------------- Enumerate ------------------------------- //
 Nst_Obj *NstC enumerate_start(usize arg_num, Nst_Obj **args)
 {
@@ -332,6 +355,33 @@ Nst_Obj *NstC enumerate_next(usize arg_num, Nst_Obj **args)
     return arr;
 }
 
+Nst_IterUnpackResult NstC enumerate_unpack(Nst_Obj *value, usize count,
+                                           Nst_Obj **out)
+{
+    if (count != 2)
+        return Nst_UNPACK_UNSUPPORTED;
+    EnumerateData *data = (EnumerateData *)Nst_obj_custom_data(value);
+
+    Nst_Obj *res = Nst_iter_next(data->iterator);
+    if (res == nullptr)
+        return Nst_UNPACK_FAILED;
+    if (res == Nst_iend()) {
+        Nst_dec_ref(res);
+        return Nst_UNPACK_END;
+    }
+
+    Nst_Obj *idx = Nst_int_new(data->idx);
+    if (idx == nullptr) {
+        Nst_dec_ref(res);
+        return Nst_UNPACK_FAILED;
+    }
+    data->idx += data->step;
+
+    out[data->invert_order ? 1 : 0] = idx;
+    out[data->invert_order ? 0 : 1] = res;
+    return Nst_UNPACK_SUCCESS;
+}
+
 // ----------------------------- Map iterators ----------------------------- //
 
 Nst_Obj *NstC map_iter_start(usize arg_num, Nst_Obj **args)
@@ -112,9 +112,13 @@ Nst_Obj *NstC chain_next(usize arg_num, Nst_Obj **args);
 
 Nst_Obj *NstC zip_start(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC zip_next(usize arg_num, Nst_Obj **args);
+Nst_IterUnpackResult NstC zip_unpack(Nst_Obj *value, usize count,
+                                     Nst_Obj **out);
 
 Nst_Obj *NstC enumerate_start(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC enumerate_next(usize arg_num, Nst_Obj **args);
+Nst_IterUnpackResult NstC enumerate_unpack(Nst_Obj *value, usize count,
+                                           Nst_Obj **out);
 
 Nst_Obj *NstC map_iter_start(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC keys_next(usize arg_num, Nst_Obj **args);
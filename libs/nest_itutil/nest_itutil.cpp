@@ -15,6 +15,17 @@
     return iter__;                                                            \
     } while (0)
 
+#define RETURN_NEW_UNPACK_ITER(start, next, unpack, value) do {               \
+    Nst_Obj *iter__ = Nst_iter_new(                                           \
+        Nst_inc_ref(itutil_functions.start),                                  \
+        Nst_inc_ref(itutil_functions.next),                                   \
+        value);                                                               \
+    if (iter__ == nullptr)                                                    \
+        return nullptr;                                                       \
+    Nst_iter_set_unpack(iter__, unpack);                                      \
+    return iter__;                                                            \
+    } while (0)
+
 static Nst_Declr obj_list_[] = {
     Nst_FUNCDECLR(count_,        2),
     Nst_FUNCDECLR(cycle_,        1),
@@ -197,7 +208,7 @@ Nst_Obj *zipn_(Nst_Obj *seq)
         data->count++;
     }
 
-    RETURN_NEW_ITER(zip_start, zip_next, zip_data);
+    RETURN_NEW_UNPACK_ITER(zip_start, zip_next, zip_unpack, zip_data);
 }
 
 Nst_Obj *NstC zip_(usize arg_num, Nst_Obj **args)
@@ -243,7 +254,7 @@ Nst_Obj *NstC zip_(usize arg_num, Nst_Obj **args)
     iterators[0] = seq1;
     iterators[1] = seq2;
 
-    RETURN_NEW_ITER(zip_start, zip_next, zip_data);
+    RETURN_NEW_UNPACK_ITER(zip_start, zip_next, zip_unpack, zip_data);
 }
 
 Nst_Obj *NstC enumerate_(usize arg_num, Nst_Obj **args)
@@ -281,7 +292,11 @@ Nst_Obj *NstC enumerate_(usize arg_num, Nst_Obj **args)
         return nullptr;
     }
 
-    RETURN_NEW_ITER(enumerate_start, enumerate_next, enumerate_data);
+    RETURN_NEW_UNPACK_ITER(
+        enumerate_start,
+        enumerate_next,
+        enumerate_unpack,
+        enumerate_data);
 }
 
 Nst_Obj *NstC keys_(usize arg_num, Nst_Obj **args)
@@ -462,10 +477,7 @@ Nst_Obj *NstC iter_next_(usize arg_num, Nst_Obj **args)
     if (!Nst_extract_args("I", arg_num, args, &iter))
         return nullptr;
 
-    Nst_Obj *next = Nst_iter_next_func(iter);
-    Nst_Obj *value = Nst_iter_value(iter);
-
-    return Nst_func_call(next, 1, &value);
+    return Nst_iter_next(iter);
 }
 
 Nst_Obj *NstC IEND_()
@@ -10,335 +10,383 @@
 
 #endif
 
-#define EXCEPT_ERROR do {                                                     \
-    if (Nst_error_occurred())                                                 \
-        FAIL;                                                                 \
+#define MAX_RECURSION_LVL 1500
+
+#define INC_RECURSION_LVL(dumper) do {                                        \
+        (dumper)->recursion_level++;                                          \
+        if ((dumper)->recursion_level > MAX_RECURSION_LVL) {                  \
+            Nst_error_setc_memory("over 1500 recursive calls, dump failed");  \
+            return false;                                                     \
+        }                                                                     \
     } while (0)
+#define DEC_RECURSION_LVL(dumper) (dumper)->recursion_level--
+
+static bool dump_obj(JSONDumper *dumper, Nst_Obj *obj);
+static bool dump_str(JSONDumper *dumper, Nst_Obj *str);
+static bool dump_int(JSONDumper *dumper, i64 val);
+static bool dump_real(JSONDumper *dumper, f64 val);
+static bool dump_seq(JSONDumper *dumper, Nst_Obj *seq);
+static bool dump_map(JSONDumper *dumper, Nst_Obj *map);
+static bool add_comma(JSONDumper *dumper);
+static bool add_newline(JSONDumper *dumper);
+
+static void dumper_init(JSONDumper *dumper, i32 indent)
+{
+    dumper->file = nullptr;
+    dumper->encoding = nullptr;
+    dumper->len = 0;
+    dumper->indent = indent;
+    dumper->indent_level = 0;
+    dumper->recursion_level = 0;
+}
 
-#define FAIL do {                                                             \
-    Nst_sb_destroy(&sb);                                                      \
-    return;                                                                   \
-    } while (0)
+Nst_Obj *json_dump(Nst_Obj *obj, i32 indent)
+{
+    JSONDumper dumper;
+    dumper_init(&dumper, indent);
+    if (!Nst_sb_init(&dumper.sb, 255))
+        return nullptr;
 
-#define INC_RECURSION_LVL do {                                                \
-    recursion_level++;                                                        \
-    if (recursion_level > 1500) {                                             \
-        Nst_error_setc_memory("over 1500 recursive calls, dump failed");     \
-        FAIL;                                                                 \
-    }                                                                         \
-    } while (0)
+    if (!dump_obj(&dumper, obj)) {
+        Nst_sb_destroy(&dumper.sb);
+        return nullptr;
+    }
+    return Nst_str_from_sb(&dumper.sb);
+}
 
-#define DEC_RECURSION_LVL recursion_level--
+static bool flush(JSONDumper *dumper)
+{
+    Nst_IOResult result = Nst_IO_SUCCESS;
 
-static void dump_obj(Nst_Obj *obj, i32 indent);
-static void dump_str(Nst_Obj *str);
-static void dump_num(Nst_Obj *number);
-static void dump_seq(Nst_Obj *seq, i32 indent);
-static void dump_map(Nst_Obj *map, i32 indent);
-static void add_comma(i32 indent);
-static void add_indent(i32 indent);
+    // the output contains only ASCII characters, in encodings where they are
+    // one byte long they are written as-is
+    if (dumper->encoding->mult_min_sz == 1)
+        result = Nst_fwrite(dumper->buf, dumper->len, nullptr, dumper->file);
+    else {
+        u8 encoded[256 * Nst_ENCODING_MULTIBYTE_MAX_SIZE];
+        Nst_FromUTF32Func from_utf32 = dumper->encoding->from_utf32;
+        usize i = 0;
+
+        while (i < dumper->len && result == Nst_IO_SUCCESS) {
+            usize encoded_len = 0;
+            for (usize end = i + 256; i < end && i < dumper->len; i++) {
+                u8 *ch_buf = encoded + encoded_len;
+                encoded_len += from_utf32(dumper->buf[i], ch_buf);
+            }
+            result = Nst_fwrite(encoded, encoded_len, nullptr, dumper->file);
+        }
+    }
 
-static Nst_StrBuilder sb;
-static i32 indent_level;
-static i32 recursion_level;
+    dumper->len = 0;
+    if (result != Nst_IO_SUCCESS) {
+        Nst_error_setc_call("JSON: could not write to the file");
+        return false;
+    }
+    return true;
+}
 
-Nst_Obj *json_dump(Nst_Obj *obj, i32 indent)
+bool json_dump_file(Nst_Obj *obj, i32 indent, Nst_Obj *file,
+                    Nst_EncodingID encoding)
 {
-    recursion_level = 0;
-    if (!Nst_sb_init(&sb, 255))
-        return nullptr;
+    JSONDumper dumper;
+    dumper_init(&dumper, indent);
+    dumper.file = file;
+    dumper.encoding = Nst_encoding(encoding);
 
-    dump_obj(obj, indent);
-    if (Nst_error_occurred())
-        return nullptr;
+    return dump_obj(&dumper, obj) && flush(&dumper);
+}
 
-    return Nst_str_from_sb(&sb);
+static bool write_str(JSONDumper *dumper, const char *str, usize len)
+{
+    if (dumper->file == nullptr)
+        return Nst_sb_push(&dumper->sb, (u8 *)str, len);
+
+    while (len > 0) {
+        if (dumper->len == JSON_DUMP_BUF_SIZE && !flush(dumper))
+            return false;
+        usize chunk_len = JSON_DUMP_BUF_SIZE - dumper->len;
+        if (chunk_len > len)
+            chunk_len = len;
+        memcpy(dumper->buf + dumper->len, str, chunk_len);
+        dumper->len += chunk_len;
+        str += chunk_len;
+        len -= chunk_len;
+    }
+    return true;
 }
 
-static void dump_obj(Nst_Obj *obj, i32 indent)
+static inline bool write_char(JSONDumper *dumper, char ch)
+{
+    if (dumper->file == nullptr)
+        return Nst_sb_push_char(&dumper->sb, ch);
+    if (dumper->len == JSON_DUMP_BUF_SIZE && !flush(dumper))
+        return false;
+    dumper->buf[dumper->len++] = (u8)ch;
+    return true;
+}
+
+static bool dump_obj(JSONDumper *dumper, Nst_Obj *obj)
 {
-    INC_RECURSION_LVL;
     if (Nst_T(obj, Str))
-        dump_str(obj);
-    else if (Nst_T(obj, Int) || Nst_T(obj, Real) || Nst_T(obj, Byte))
-        dump_num(obj);
+        return dump_str(dumper, obj);
+    else if (Nst_T(obj, Int))
+        return dump_int(dumper, Nst_int_i64(obj));
+    else if (Nst_T(obj, Real))
+        return dump_real(dumper, Nst_real_f64(obj));
+    else if (Nst_T(obj, Byte))
+        return dump_int(dumper, Nst_byte_u8(obj));
     else if (Nst_T(obj, Map))
-        dump_map(obj, indent);
+        return dump_map(dumper, obj);
     else if (Nst_T(obj, Array) || Nst_T(obj, Vector))
-        dump_seq(obj, indent);
+        return dump_seq(dumper, obj);
     else if (obj == Nst_null())
-        Nst_sb_push_c(&sb, "null");
+        return write_str(dumper, "null", 4);
     else if (obj == Nst_true())
-        Nst_sb_push_c(&sb, "true");
+        return write_str(dumper, "true", 4);
     else if (obj == Nst_false())
-        Nst_sb_push_c(&sb, "false");
-    else {
-        Nst_error_setf_type(
-            "JSON: an object of type %s is not serializable",
-            Nst_type_name(obj->type).value);
-        FAIL;
-    }
-    DEC_RECURSION_LVL;
+        return write_str(dumper, "false", 5);
+
+    Nst_error_setf_type(
+        "JSON: an object of type %s is not serializable",
+        Nst_type_name(obj->type).value);
+    return false;
 }
 
-static void dump_str(Nst_Obj *str)
+static bool is_plain_char(u8 ch)
 {
-    INC_RECURSION_LVL;
+    return ch >= ' ' && ch < 0x7f && ch != '"' && ch != '\\';
+}
 
-    usize unicode_bytes = 0;
-    u8 *s_val = Nst_str_value(str);
-    usize s_len = Nst_str_len(str);
+static bool dump_escape(JSONDumper *dumper, u32 ch)
+{
     const char *hex_digits = "0123456789abcdef";
+    char escape[6] = {
+        '\\', 'u',
+        hex_digits[(ch >> 12) & 0xf],
+        hex_digits[(ch >> 8) & 0xf],
+        hex_digits[(ch >> 4) & 0xf],
+        hex_digits[ch & 0xf]
+    };
+    return write_str(dumper, escape, 6);
+}
 
-    for (usize i = 0; i < s_len; i++) {
-        i32 res = Nst_check_ext_utf8_bytes((u8 *)s_val + i, s_len - i);
-        if (res != 1)
-            unicode_bytes++;
-        if (res != -1)
-            i += res - 1;
-    }
+static bool dump_str(JSONDumper *dumper, Nst_Obj *str)
+{
+    u8 *s_val = Nst_str_value(str);
+    usize s_len = Nst_str_len(str);
 
-    Nst_sb_reserve(&sb, s_len + unicode_bytes * 5 + 2);
-    EXCEPT_ERROR;
+    if (!write_char(dumper, '"'))
+        return false;
 
-    Nst_sb_push_char(&sb, '"');
-    for (usize i = 0; i < s_len; i++) {
-        i32 res = Nst_check_ext_utf8_bytes((u8 *)s_val + i, s_len - i);
-        switch (res) {
-        case 1:
-            Nst_sb_push_char(&sb, s_val[i]);
-            break;
-        case -1: {
-            Nst_sb_push_c(&sb, "\\u00");
-            u8 c1 = u8(s_val[i]) >> 4;
-            u8 c2 = u8(s_val[i]) & 0xf;
-            Nst_sb_push_char(&sb, hex_digits[c1]);
-            Nst_sb_push_char(&sb, hex_digits[c2]);
-            break;
-        }
-        case 2: {
-            Nst_sb_push_c(&sb, "\\u0");
-            u8 c1 = u8(s_val[i]) >> 2 & 0xf;
-            u8 c2 = ((u8(s_val[i]) & 0x3) << 2)
-                  + ((u8(s_val[i + 1]) >> 4) & 0x3);
-            u8 c3 = u8(s_val[i + 1]) & 0xf;
+    usize i = 0;
+    while (i < s_len) {
+        // copy runs of characters that need no escaping all at once
+        usize run_start = i;
+        while (i < s_len && is_plain_char(s_val[i]))
             i++;
-
-            Nst_sb_push_char(&sb, hex_digits[c1]);
-            Nst_sb_push_char(&sb, hex_digits[c2]);
-            Nst_sb_push_char(&sb, hex_digits[c3]);
-            break;
+        usize run_len = i - run_start;
+        if (run_len != 0
+            && !write_str(dumper, (const char *)s_val + run_start, run_len))
+        {
+            return false;
         }
-        case 3: {
-            Nst_sb_push_c(&sb, "\\u");
-            u8 c1 = u8(s_val[i++]) & 0xf;
-            u8 c2 = (u8(s_val[i]) >> 2) & 0xf;
-            u8 c3 = ((u8(s_val[i]) & 0x3) << 2)
-                  + ((u8(s_val[i + 1]) >> 4) & 0x3);
-            u8 c4 = (u8)(s_val[i + 1]) & 0xf;
-            i++;
-
-            Nst_sb_push_char(&sb, hex_digits[c1]);
-            Nst_sb_push_char(&sb, hex_digits[c2]);
-            Nst_sb_push_char(&sb, hex_digits[c3]);
-            Nst_sb_push_char(&sb, hex_digits[c4]);
+        if (i == s_len)
             break;
+
+        bool result;
+        switch (s_val[i]) {
+        case '"':  result = write_str(dumper, "\\\"", 2); break;
+        case '\\': result = write_str(dumper, "\\\\", 2); break;
+        case '\b': result = write_str(dumper, "\\b", 2); break;
+        case '\f': result = write_str(dumper, "\\f", 2); break;
+        case '\n': result = write_str(dumper, "\\n", 2); break;
+        case '\r': result = write_str(dumper, "\\r", 2); break;
+        case '\t': result = write_str(dumper, "\\t", 2); break;
+        default: {
+            i32 ch_len = Nst_check_ext_utf8_bytes(s_val + i, s_len - i);
+            if (ch_len == 4) {
+                Nst_error_setc_value(
+                    "JSON: cannot serialize characters above U+FFFF");
+                return false;
+            }
+            // invalid bytes are written as the code point with their value
+            if (ch_len == -1) {
+                result = dump_escape(dumper, s_val[i]);
+                break;
+            }
+            result = dump_escape(dumper, Nst_ext_utf8_to_utf32(s_val + i));
+            i += ch_len - 1;
         }
-        case 4:
-            Nst_error_setc_value(
-                "JSON: cannot serialize characters above U+FFFF");
-            FAIL;
         }
+        if (!result)
+            return false;
+        i++;
     }
-    Nst_sb_push_char(&sb, '"');
-    DEC_RECURSION_LVL;
+    return write_char(dumper, '"');
 }
 
-static void dump_num(Nst_Obj *number)
+static bool dump_int(JSONDumper *dumper, i64 val)
+{
+    char buf[21];
+    char *end = buf + sizeof(buf);
+    char *start = end;
+    u64 abs_val = val < 0 ? 0 - (u64)val : (u64)val;
+
+    do {
+        *--start = (char)('0' + abs_val % 10);
+        abs_val /= 10;
+    } while (abs_val != 0);
+    if (val < 0)
+        *--start = '-';
+    return write_str(dumper, start, end - start);
+}
+
+static bool dump_real(JSONDumper *dumper, f64 val)
 {
-    INC_RECURSION_LVL;
-    f64 val;
-    char loc_buf[27];
-    usize len;
-
-    if (Nst_T(number, Byte)) {
-        sprintf(loc_buf, "%i", Nst_byte_u8(number));
-        Nst_sb_push_c(&sb, loc_buf);
-        goto finish;
-    } else if (Nst_T(number, Int)) {
-        sprintf(loc_buf, "%" PRIi64, Nst_int_i64(number));
-        Nst_sb_push_c(&sb, loc_buf);
-        goto finish;
-    }
-    val = Nst_real_f64(number);
     if (isinf(val) || isnan(val)) {
         if (!nan_and_inf) {
-            Nst_error_setc_value(
-                "JSON: cannot serialize infinities or NaNs");
-            FAIL;
+            Nst_error_setc_value("JSON: cannot serialize infinities or NaNs");
+            return false;
         }
-        if (isinf(val)) {
-            if (val < 0)
-                Nst_sb_push_c(&sb, "-Infinity");
-            else
-                Nst_sb_push_c(&sb, "Infinity");
-        } else
-            Nst_sb_push_c(&sb, "NaN");
-        goto finish;
+        if (isnan(val))
+            return write_str(dumper, "NaN", 3);
+        return val < 0
+            ? write_str(dumper, "-Infinity", 9)
+            : write_str(dumper, "Infinity", 8);
     }
-    sprintf(loc_buf, "%.16lg", val);
-    len = strlen(loc_buf);
-    for (usize i = 0; i < len; i++) {
-        if (loc_buf[i] == '.' || loc_buf[i] == 'e')
-            goto add_buf;
+
+    // mode 0 gives the shortest digits that read back to the same value
+    int decpt, sign;
+    char *digits_end;
+    char *digits = Nst_dtoa(val, 0, 0, &decpt, &sign, &digits_end);
+    i32 n_digits = i32(digits_end - digits);
+    i32 exponent = decpt - 1;
+
+    // large enough for 17 digits, the sign, the point and the exponent or the
+    // leading zeroes
+    char buf[40];
+    usize len = 0;
+    if (sign)
+        buf[len++] = '-';
+
+    if (exponent < -4 || exponent >= 16) {
+        buf[len++] = digits[0];
+        if (n_digits > 1) {
+            buf[len++] = '.';
+            memcpy(buf + len, digits + 1, n_digits - 1);
+            len += n_digits - 1;
+        }
+        len += sprintf(
+            buf + len, "e%c%02i",
+            exponent < 0 ? '-' : '+',
+            exponent < 0 ? -exponent : exponent);
+    } else if (decpt <= 0) {
+        buf[len++] = '0';
+        buf[len++] = '.';
+        for (i32 i = decpt; i < 0; i++)
+            buf[len++] = '0';
+        memcpy(buf + len, digits, n_digits);
+        len += n_digits;
+    } else if (decpt >= n_digits) {
+        memcpy(buf + len, digits, n_digits);
+        len += n_digits;
+        for (i32 i = n_digits; i < decpt; i++)
+            buf[len++] = '0';
+        buf[len++] = '.';
+        buf[len++] = '0';
+    } else {
+        memcpy(buf + len, digits, decpt);
+        len += decpt;
+        buf[len++] = '.';
+        memcpy(buf + len, digits + decpt, n_digits - decpt);
+        len += n_digits - decpt;
     }
-    loc_buf[len++] = '.';
-    loc_buf[len++] = '0';
-    loc_buf[len++] = '\0';
-add_buf:
-    Nst_sb_push_c(&sb, loc_buf);
-
-finish:
-    DEC_RECURSION_LVL;
+    Nst_freedtoa(digits);
+    return write_str(dumper, buf, len);
 }
 
-static void dump_seq(Nst_Obj *seq, i32 indent)
+static bool dump_seq(JSONDumper *dumper, Nst_Obj *seq)
 {
-    if (Nst_seq_len(seq) == 0) {
-        Nst_sb_push_c(&sb, "[]");
-        return;
-    }
-    INC_RECURSION_LVL;
-
-    Nst_sb_push_char(&sb, '[');
-    EXCEPT_ERROR;
-    indent_level++;
-
-    if (indent > 1) {
-        Nst_sb_reserve(&sb, indent * indent_level + 1);
-        EXCEPT_ERROR;
-        Nst_sb_push_char(&sb, '\n');
-        for (i32 i = 0; i < indent * indent_level; i++)
-            Nst_sb_push_char(&sb, ' ');
-    }
+    usize len = Nst_seq_len(seq);
+    if (len == 0)
+        return write_str(dumper, "[]", 2);
 
-    for (usize i = 0, n = Nst_seq_len(seq); i < n; i++) {
-        dump_obj(Nst_seq_getnf(seq, i), indent);
-        EXCEPT_ERROR;
-
-        if (i + 1 == n) {
-            DEC_RECURSION_LVL;
-            indent_level--;
-            Nst_sb_reserve(&sb, 1);
-            EXCEPT_ERROR;
-            if (indent < 1) {
-                Nst_sb_push_char(&sb, ']');
-                return;
-            }
-            Nst_sb_push_char(&sb, '\n');
-            add_indent(indent);
-            EXCEPT_ERROR;
-            Nst_sb_reserve(&sb, 1);
-            EXCEPT_ERROR;
-            Nst_sb_push_char(&sb, ']');
-            return;
-        }
+    INC_RECURSION_LVL(dumper);
+    dumper->indent_level++;
+    if (!write_char(dumper, '[') || !add_newline(dumper))
+        return false;
 
-        add_comma(indent);
-        EXCEPT_ERROR;
+    for (usize i = 0; i < len; i++) {
+        if (i != 0 && !add_comma(dumper))
+            return false;
+        if (!dump_obj(dumper, Nst_seq_getnf(seq, i)))
+            return false;
     }
+
+    dumper->indent_level--;
+    DEC_RECURSION_LVL(dumper);
+    return add_newline(dumper) && write_char(dumper, ']');
 }
 
-static void dump_map(Nst_Obj *map, i32 indent)
+static bool dump_map(JSONDumper *dumper, Nst_Obj *map)
 {
-    if (Nst_map_len(map) == 0) {
-        Nst_sb_push_c(&sb, "{}");
-        return;
-    }
-    INC_RECURSION_LVL;
-    Nst_sb_push_char(&sb, '{');
-    EXCEPT_ERROR;
-    indent_level++;
-
-    if (indent > 1) {
-        Nst_sb_reserve(&sb, indent * indent_level + 1);
-        EXCEPT_ERROR;
-        Nst_sb_push_char(&sb, '\n');
-        for (i32 i = 0; i < indent * indent_level; i++)
-            Nst_sb_push_char(&sb, ' ');
-    }
+    if (Nst_map_len(map) == 0)
+        return write_str(dumper, "{}", 2);
+
+    INC_RECURSION_LVL(dumper);
+    dumper->indent_level++;
+    if (!write_char(dumper, '{') || !add_newline(dumper))
+        return false;
 
-    usize count = 0;
-    usize tot = Nst_map_len(map);
+    bool first = true;
     Nst_Obj *key;
     Nst_Obj *value;
     for (isize i = Nst_map_next(-1, map, &key, &value);
          i != -1;
          i = Nst_map_next(i, map, &key, &value))
     {
-        count++;
         if (!Nst_T(key, Str)) {
             Nst_error_setc_type("JSON: all keys of a map must be strings");
-            FAIL;
-        }
-
-        dump_str(key);
-        EXCEPT_ERROR;
-
-        if (indent == -1)
-            Nst_sb_push_char(&sb, ':');
-        else
-            Nst_sb_push_c(&sb, ": ");
-        EXCEPT_ERROR;
-
-        dump_obj(value, indent);
-        EXCEPT_ERROR;
-
-        if (count == tot) {
-            DEC_RECURSION_LVL;
-            indent_level--;
-            if (indent < 1) {
-                Nst_sb_push_char(&sb, '}');
-                return;
-            } else {
-                Nst_sb_push_char(&sb, '\n');
-                EXCEPT_ERROR;
-            }
-            add_indent(indent);
-            EXCEPT_ERROR;
-            Nst_sb_push_char(&sb, '}');
-            return;
+            return false;
         }
 
-        add_comma(indent);
-        EXCEPT_ERROR;
+        if (!first && !add_comma(dumper))
+            return false;
+        first = false;
+
+        if (!dump_str(dumper, key))
+            return false;
+        bool result = dumper->indent == -1
+            ? write_char(dumper, ':')
+            : write_str(dumper, ": ", 2);
+        if (!result || !dump_obj(dumper, value))
+            return false;
     }
+
+    dumper->indent_level--;
+    DEC_RECURSION_LVL(dumper);
+    return add_newline(dumper) && write_char(dumper, '}');
 }
 
-static void add_comma(i32 indent)
+static bool add_comma(JSONDumper *dumper)
 {
-    INC_RECURSION_LVL;
-    if (indent == -1)
-        Nst_sb_reserve(&sb, 1);
-    else
-        Nst_sb_reserve(&sb, 2);
-    EXCEPT_ERROR;
-    Nst_sb_push_char(&sb, ',');
-    if (indent == 0)
-        Nst_sb_push_char(&sb, ' ');
-    else if (indent > 0) {
-        Nst_sb_push_char(&sb, '\n');
-        add_indent(indent);
-    }
-    DEC_RECURSION_LVL;
+    if (!write_char(dumper, ','))
+        return false;
+    if (dumper->indent == 0)
+        return write_char(dumper, ' ');
+    return add_newline(dumper);
 }
 
-static void add_indent(i32 indent)
+// adds a new line followed by the indentation, only when indenting is enabled
+static bool add_newline(JSONDumper *dumper)
 {
-    INC_RECURSION_LVL;
-    Nst_sb_reserve(&sb, indent * indent_level);
-    EXCEPT_ERROR;
-    for (i32 i = 0; i < indent * indent_level; i++)
-        Nst_sb_push_char(&sb, ' ');
-    DEC_RECURSION_LVL;
+    if (dumper->indent < 1)
+        return true;
+    if (!write_char(dumper, '\n'))
+        return false;
+    for (i32 i = 0, n = dumper->indent * dumper->indent_level; i < n; i++) {
+        if (!write_char(dumper, ' '))
+            return false;
+    }
+    return true;
 }
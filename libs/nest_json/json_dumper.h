@@ -3,6 +3,41 @@
 
 #include "nest.h"
 
+// size of the buffer flushed to the file when dumping
+#define JSON_DUMP_BUF_SIZE 4096
+
+/**
+ * The state of the dumper. When writing to a file the text is collected in
+ * `buf` and flushed once it is full, otherwise it is added to `sb`.
+ *
+ * @param file: the binary file to write to, `nullptr` when dumping to a string
+ * @param encoding: the encoding used to write to `file`
+ * @param sb: the string builder used when dumping to a string
+ * @param buf: the text not yet written to `file`
+ * @param len: the length in bytes of `buf`
+ * @param indent: the number of spaces for each indentation level, `0` puts
+ * everything in one line and `-1` removes all optional spaces
+ * @param indent_level: the current indentation level
+ * @param recursion_level: the current depth of nested objects
+ */
+typedef struct _JSONDumper {
+    Nst_Obj *file;
+    Nst_Encoding *encoding;
+    Nst_StrBuilder sb;
+    u8 buf[JSON_DUMP_BUF_SIZE];
+    usize len;
+    i32 indent;
+    i32 indent_level;
+    i32 recursion_level;
+} JSONDumper;
+
+/* Serialize `obj` into a new `Str` object. */
 Nst_Obj *json_dump(Nst_Obj *obj, i32 indent);
+/**
+ * Serialize `obj` writing it to `file` in chunks of at most
+ * `JSON_DUMP_BUF_SIZE` characters. `file` must be a binary `IOFile`.
+ */
+bool json_dump_file(Nst_Obj *obj, i32 indent, Nst_Obj *file,
+                    Nst_EncodingID encoding);
 
-#endif // !JSON_DUMPER_H
\ No newline at end of file
+#endif // !JSON_DUMPER_H
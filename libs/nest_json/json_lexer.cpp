@@ -6,435 +6,763 @@
 
 #define FILE_INFO ", file \"%s\", line %" PRIi32 ", column %" PRIi32
 
-#define SET_INVALID_ESCAPE_ERROR                                              \
-    Nst_error_setf_syntax(                                                    \
-        "JSON: invalid string escape" FILE_INFO,                              \
-        state.text->path == NULL ? "<Str>" : state.text->path,        \
-        state.pos.line,                                                       \
-        state.pos.col)
-
-#define SET_INVALID_VALUE_ERROR                                               \
-    Nst_error_setf_syntax(                                                    \
-        "JSON: invalid value" FILE_INFO,                                      \
-        state.text->path == NULL ? "<Str>" : state.text->path,        \
-        state.pos.line,                                                       \
-        state.pos.col)
+// the error is not overwritten when the file could not be read
+#define SET_SYNTAX_ERROR(msg, lexer, pos) do {                                \
+    if (!Nst_error_occurred())                                                \
+        JSON_SYNTAX_ERROR(msg, (lexer)->path, pos);                           \
+    } while (0)
 
 #define IS_HEX(ch) ((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f'))
 #define HEX_TO_INT(ch) (ch <= '9' ? ch - '0' : ch - 'a' + 10)
+#define IS_DIGIT(ch) (ch >= '0' && ch <= '9')
+
+// a character of the source encoding can be up to three bytes in UTF-8 for
+// each byte it occupies
+#define DECODED_BUF_SIZE (JSON_CHUNK_SIZE * 3 + Nst_ENCODING_MULTIBYTE_MAX_SIZE)
+
+// the character returned by `peek` when the end of the text is reached
+#define CH_EOF -1
 
 bool comments = false;
 bool nan_and_inf = false;
 
-typedef struct _LexerState {
-    Nst_Pos pos;
-    Nst_SourceText *text;
-    usize idx;
-    usize len;
-    char *path;
-    char ch;
-} LexerState;
+static bool decode_raw(JSONLexer *lexer);
+static bool read_chunk(JSONLexer *lexer);
+static JSONToken lex_str(JSONLexer *lexer);
+static JSONToken lex_num(JSONLexer *lexer);
+static JSONToken lex_val(JSONLexer *lexer);
+static bool skip_comment(JSONLexer *lexer);
+static bool check_ident(JSONLexer *lexer, const char *name);
+static void destroy_keys(JSONKeyTable *keys);
+static Nst_Obj *intern_key(JSONKeyTable *keys, Nst_StrBuilder *sb);
+
+static inline JSONToken make_token(JSONTokenType type, Nst_Pos pos,
+                                   Nst_Obj *value)
+{
+    JSONToken tok = { type, pos, value };
+    return tok;
+}
 
-static LexerState state;
+static inline JSONToken error_token()
+{
+    return make_token(JSON_ERROR, Nst_pos_empty(), nullptr);
+}
 
-static void advance()
+static inline i32 peek(JSONLexer *lexer)
 {
-    state.idx++;
-    state.pos.col++;
-    if (state.idx >= state.len) {
-        state.ch = '\0';
-        return;
-    }
+    if (lexer->idx < lexer->len || read_chunk(lexer))
+        return lexer->buf[lexer->idx];
+    return CH_EOF;
+}
 
-    state.ch = state.text->text[state.idx];
-    if (state.ch == '\n') {
-        state.pos.line++;
-        state.pos.col = 0;
+static inline void advance(JSONLexer *lexer)
+{
+    u8 ch = lexer->buf[lexer->idx++];
+    if (ch == '\n') {
+        if (!lexer->after_cr)
+            lexer->pos.line++;
+        lexer->pos.col = 1;
+        lexer->after_cr = false;
+    } else if (ch == '\r') {
+        lexer->pos.line++;
+        lexer->pos.col = 1;
+        lexer->after_cr = true;
+    } else {
+        lexer->pos.col++;
+        lexer->after_cr = false;
     }
 }
 
-static void go_back()
+static void lexer_init_common(JSONLexer *lexer)
 {
-    state.idx--;
-    state.pos.col--;
-    state.ch = state.text->text[state.idx];
+    lexer->file = nullptr;
+    lexer->src_encoding = nullptr;
+    lexer->decode = false;
+    lexer->eof = true;
+    lexer->buf = nullptr;
+    lexer->len = 0;
+    lexer->idx = 0;
+    lexer->raw_buf = nullptr;
+    lexer->raw_len = 0;
+    lexer->raw_pos = 0;
+    lexer->pos.line = 1;
+    lexer->pos.col = 1;
+    lexer->pos.text = nullptr;
+    lexer->path = "<Str>";
+    lexer->after_cr = false;
+    lexer->keys.entries = nullptr;
+    lexer->keys.cap = 0;
+    lexer->keys.len = 0;
+    lexer->lexing_key = false;
 }
 
-static Nst_Tok parse_json_str();
-static Nst_Tok parse_json_num();
-static Nst_Tok parse_json_val();
-static bool ignore_comment();
-static bool check_ident(const char *name);
+bool json_lexer_init_str(JSONLexer *lexer, Nst_Obj *str)
+{
+    lexer_init_common(lexer);
+    lexer->buf = Nst_str_value(str);
+    lexer->len = Nst_str_len(str);
+    return Nst_sb_init(&lexer->sb, 32);
+}
 
-Nst_DynArray json_tokenize(char *path, char *text, usize text_len,
-                           Nst_EncodingID encoding)
+bool json_lexer_init_file(JSONLexer *lexer, const char *path,
+                          Nst_EncodingID encoding)
 {
-    Nst_DynArray tokens;
-    Nst_da_init(&tokens, sizeof(Nst_Tok), 0);
-    Nst_SourceText *src_text;
+    lexer_init_common(lexer);
+    if (!Nst_sb_init(&lexer->sb, 32))
+        return false;
+    lexer->path = path;
 
-    if (path == NULL) {
-        src_text = Nst_source_from_sv(Nst_sv_new((u8 *)text, text_len));
-    } else
-        src_text = Nst_source_from_file(path, encoding);
-
-    if (src_text == NULL)
-        goto end;
-
-    state.pos.text = NULL;
-    state.pos.col = 1;
-    state.pos.line = 1;
-    state.text = src_text;
-    state.idx = 0;
-    state.len = src_text->text_len;
-    state.path = path;
-    state.ch = *src_text->text;
-
-    while (state.idx < state.len) {
-        Nst_Tok tok = Nst_tok_invalid();
-        if (state.ch == ' ' || state.ch == '\n' ||
-            state.ch == '\r' || state.ch == '\t')
-        {
-            advance();
-            continue;
-        } else if (state.ch == '[') {
-            tok = Nst_tok_new(
-                Nst_span_from_pos(state.pos),
-                JSON_LBRACKET,
-                NULL);
-        } else if (state.ch == ']') {
-            tok = Nst_tok_new(
-                Nst_span_from_pos(state.pos),
-                JSON_RBRACKET,
-                NULL);
-        } else if (state.ch == '{')
-            tok = Nst_tok_new(Nst_span_from_pos(state.pos), JSON_LBRACE, NULL);
-        else if (state.ch == '}')
-            tok = Nst_tok_new(Nst_span_from_pos(state.pos), JSON_RBRACE, NULL);
-        else if (state.ch == ',')
-            tok = Nst_tok_new(Nst_span_from_pos(state.pos), JSON_COMMA, NULL);
-        else if (state.ch == ':')
-            tok = Nst_tok_new(Nst_span_from_pos(state.pos), JSON_COLON, NULL);
-        else if (state.ch == '"')
-            tok = parse_json_str();
-        else if ((state.ch >= '0' && state.ch <= '9') || state.ch == '-'
-                || state.ch == 'I' || state.ch == 'N')
+    FILE *fp = Nst_fopen_unicode(path, "rb");
+    if (fp == nullptr) {
+        if (!Nst_error_occurred())
+            Nst_error_setf_value("File \"%.100s\" not found.", path);
+        Nst_sb_destroy(&lexer->sb);
+        return false;
+    }
+
+    lexer->file = Nst_iof_new(fp, true, true, false, nullptr);
+    if (lexer->file == nullptr) {
+        fclose(fp);
+        Nst_sb_destroy(&lexer->sb);
+        return false;
+    }
+
+    lexer->raw_buf = Nst_malloc_c(JSON_CHUNK_SIZE, u8);
+    if (lexer->raw_buf == nullptr) {
+        json_lexer_destroy(lexer);
+        return false;
+    }
+
+    usize read_len = 0;
+    Nst_IOResult result = Nst_fread(
+        lexer->raw_buf,
+        JSON_CHUNK_SIZE, JSON_CHUNK_SIZE,
+        &read_len,
+        lexer->file);
+    if (result < 0) {
+        Nst_error_setf_call("JSON: could not read the file \"%s\"", path);
+        json_lexer_destroy(lexer);
+        return false;
+    }
+    lexer->eof = read_len < JSON_CHUNK_SIZE;
+
+    // the encoding is detected using only the first chunk, a character that
+    // could be truncated at the end of the chunk is ignored
+    i32 bom_size = 0;
+    if (encoding == Nst_EID_UNKNOWN) {
+        usize detect_len = read_len;
+        while (!lexer->eof
+               && detect_len > 0
+               && read_len - detect_len < Nst_ENCODING_MULTIBYTE_MAX_SIZE
+               && lexer->raw_buf[detect_len - 1] >= 0x80)
         {
-            tok = parse_json_num();
-        } else if (state.ch == 't' || state.ch == 'f' || state.ch == 'n')
-            tok = parse_json_val();
-        else if (state.ch == '/') {
-            if (ignore_comment())
-                continue;
-        } else {
+            detect_len--;
+        }
+        encoding = Nst_encoding_detect(
+            (char *)lexer->raw_buf,
+            detect_len,
+            &bom_size);
+    } else
+        Nst_encoding_from_bom((char *)lexer->raw_buf, read_len, &bom_size);
+
+    encoding = Nst_encoding_to_single_byte(encoding);
+    lexer->src_encoding = Nst_encoding(encoding);
+    lexer->decode = encoding != Nst_EID_UTF8
+                 && encoding != Nst_EID_EXT_UTF8
+                 && encoding != Nst_EID_ASCII;
+
+    read_len -= bom_size;
+    memmove(lexer->raw_buf, lexer->raw_buf + bom_size, read_len);
+    lexer->raw_pos = bom_size;
+
+    // text already in UTF-8 is lexed directly from the buffer it is read into
+    if (!lexer->decode) {
+        lexer->buf = lexer->raw_buf;
+        lexer->len = read_len;
+        lexer->raw_buf = nullptr;
+        return true;
+    }
+
+    lexer->buf = Nst_malloc_c(DECODED_BUF_SIZE, u8);
+    if (lexer->buf == nullptr) {
+        json_lexer_destroy(lexer);
+        return false;
+    }
+    lexer->raw_len = read_len;
+    if (!decode_raw(lexer)) {
+        json_lexer_destroy(lexer);
+        return false;
+    }
+    return true;
+}
+
+void json_lexer_destroy(JSONLexer *lexer)
+{
+    Nst_sb_destroy(&lexer->sb);
+    destroy_keys(&lexer->keys);
+    if (lexer->file == nullptr)
+        return;
+
+    Nst_fclose(lexer->file);
+    Nst_dec_ref(lexer->file);
+    lexer->file = nullptr;
+    if (lexer->buf != nullptr)
+        Nst_free(lexer->buf);
+    if (lexer->raw_buf != nullptr)
+        Nst_free(lexer->raw_buf);
+    lexer->buf = nullptr;
+    lexer->raw_buf = nullptr;
+}
+
+// Translates the bytes in `raw_buf` to UTF-8 appending them to `buf`, an
+// incomplete character at the end of `raw_buf` is kept for the next chunk
+static bool decode_raw(JSONLexer *lexer)
+{
+    Nst_Encoding *encoding = lexer->src_encoding;
+    u8 *p = lexer->raw_buf;
+    u8 *end = p + lexer->raw_len;
+    u8 *out = lexer->buf + lexer->len;
+
+    while (p < end) {
+        i32 ch_len = encoding->check_bytes(p, end - p);
+        if (ch_len < 0) {
+            if (!lexer->eof && usize(end - p) < encoding->mult_max_sz)
+                break;
             Nst_error_setf_syntax(
-                "JSON: invalid character" FILE_INFO,
-                path, state.pos.line, state.pos.col);
+                "JSON: could not decode byte %ib for %s encoding, file "
+                "\"%s\", byte %zi",
+                *p, encoding->name, lexer->path,
+                lexer->raw_pos + (p - lexer->raw_buf));
+            return false;
+        }
+        out += Nst_ext_utf8_from_utf32(encoding->to_utf32(p), out);
+        p += ch_len;
+    }
+
+    lexer->len = out - lexer->buf;
+    lexer->raw_pos += p - lexer->raw_buf;
+    lexer->raw_len = end - p;
+    memmove(lexer->raw_buf, p, lexer->raw_len);
+    return true;
+}
+
+// Moves the bytes that have not been read yet to the beginning of the buffer
+// and reads the next chunk after them. Returns `false` if no new text could be
+// read, setting the error if it is not due to the end of the file.
+static bool read_chunk(JSONLexer *lexer)
+{
+    if (lexer->eof)
+        return false;
+
+    usize left = lexer->len - lexer->idx;
+    memmove(lexer->buf, lexer->buf + lexer->idx, left);
+    lexer->len = left;
+    lexer->idx = 0;
+
+    while (!lexer->eof && lexer->len == left) {
+        u8 *dst = lexer->decode
+            ? lexer->raw_buf + lexer->raw_len
+            : lexer->buf + left;
+        usize size = JSON_CHUNK_SIZE - (lexer->decode ? lexer->raw_len : left);
+        usize read_len = 0;
+
+        Nst_IOResult result = Nst_fread(dst, size, size, &read_len,
+                                        lexer->file);
+        if (result < 0) {
+            lexer->eof = true;
+            Nst_error_setf_call(
+                "JSON: could not read the file \"%s\"",
+                lexer->path);
+            return false;
         }
+        lexer->eof = read_len < size;
 
-        if (tok.type == Nst_TT_INVALID || !Nst_da_append(&tokens, &tok)) {
-            Nst_da_clear(&tokens, (Nst_Destructor)Nst_tok_destroy);
-            Nst_source_text_destroy(src_text);
-            return tokens;
+        if (!lexer->decode) {
+            lexer->len += read_len;
+            continue;
         }
-        advance();
+
+        lexer->raw_len += read_len;
+        if (!decode_raw(lexer))
+            return false;
     }
-end:
-    Nst_Tok eof_tok = Nst_tok_new(Nst_span_from_pos(state.pos), JSON_EOF, NULL);
-    Nst_da_append(&tokens, &eof_tok);
-    Nst_source_text_destroy(src_text);
-    return tokens;
+    return lexer->len > left;
 }
 
-static Nst_Tok parse_json_str()
+// Makes sure that at least `count` bytes are in the buffer unless the end of
+// the file is reached
+static inline void ensure_bytes(JSONLexer *lexer, usize count)
 {
-    Nst_Pos start = state.pos;
-    Nst_Pos escape_start = state.pos;
-    bool escape = false;
+    while (lexer->len - lexer->idx < count && read_chunk(lexer));
+}
 
-    Nst_StrBuilder sb;
-    if (!Nst_sb_init(&sb, 8))
-        return Nst_tok_invalid();
+JSONToken json_next_key(JSONLexer *lexer)
+{
+    lexer->lexing_key = true;
+    JSONToken tok = json_next_token(lexer);
+    lexer->lexing_key = false;
+    return tok;
+}
 
-    advance();
+JSONToken json_next_token(JSONLexer *lexer)
+{
+    while (true) {
+        Nst_Pos pos = lexer->pos;
+        i32 ch = peek(lexer);
+        switch (ch) {
+        case ' ':
+        case '\n':
+        case '\r':
+        case '\t':
+            advance(lexer);
+            continue;
+        case '/':
+            if (!skip_comment(lexer))
+                return error_token();
+            continue;
+        case CH_EOF:
+            if (Nst_error_occurred())
+                return error_token();
+            return make_token(JSON_EOF, pos, nullptr);
+        case '[':
+            advance(lexer);
+            return make_token(JSON_LBRACKET, pos, nullptr);
+        case ']':
+            advance(lexer);
+            return make_token(JSON_RBRACKET, pos, nullptr);
+        case '{':
+            advance(lexer);
+            return make_token(JSON_LBRACE, pos, nullptr);
+        case '}':
+            advance(lexer);
+            return make_token(JSON_RBRACE, pos, nullptr);
+        case ',':
+            advance(lexer);
+            return make_token(JSON_COMMA, pos, nullptr);
+        case ':':
+            advance(lexer);
+            return make_token(JSON_COLON, pos, nullptr);
+        case '"':
+            return lex_str(lexer);
+        case '-':
+        case 'I':
+        case 'N':
+            return lex_num(lexer);
+        case 't':
+        case 'f':
+        case 'n':
+            return lex_val(lexer);
+        default:
+            if (IS_DIGIT(ch))
+                return lex_num(lexer);
+            SET_SYNTAX_ERROR("invalid character", lexer, pos);
+            return error_token();
+        }
+    }
+}
 
-    while (state.idx < state.len && (state.ch != '"' || escape)) {
-        if (!Nst_sb_reserve(&sb, 3)) {
-            Nst_sb_destroy(&sb);
-            return Nst_tok_invalid();
+static JSONToken lex_str(JSONLexer *lexer)
+{
+    Nst_Pos start = lexer->pos;
+    Nst_StrBuilder *sb = &lexer->sb;
+    // only text read as-is from a file can contain invalid characters
+    bool validate = lexer->file != nullptr && !lexer->decode;
+
+    sb->len = 0;
+    advance(lexer);
+
+    while (true) {
+        if (peek(lexer) == CH_EOF) {
+            SET_SYNTAX_ERROR("open string", lexer, lexer->pos);
+            return error_token();
         }
 
-        if (!escape) {
-            if ((u8)state.ch < ' ') {
-                Nst_sb_destroy(&sb);
-                Nst_error_setf_syntax(
-                    "JSON: invalid character" FILE_INFO,
-                    state.text->path,
-                    state.pos.line,
-                    state.pos.col);
-                return Nst_tok_invalid();
-            } else if (state.ch == '\\') {
-                escape = true;
-                escape_start = state.pos;
-            } else
-                Nst_sb_push_char(&sb, state.ch);
-            advance();
+        // copy everything up to the next special character at once
+        u8 *run_start = lexer->buf + lexer->idx;
+        u8 *p = run_start;
+        u8 *end = lexer->buf + lexer->len;
+        while (p < end
+               && *p != '"' && *p != '\\' && *p >= ' '
+               && (*p < 0x80 || !validate))
+        {
+            p++;
+        }
+        if (p != run_start) {
+            if (!Nst_sb_push(sb, run_start, p - run_start))
+                return error_token();
+            lexer->idx += p - run_start;
+            lexer->pos.col += i32(p - run_start);
             continue;
         }
 
-        // If there is an escape sequence
-        switch (state.ch) {
-        case '"': Nst_sb_push_char(&sb, '"' ); break;
-        case '\\':Nst_sb_push_char(&sb, '\\'); break;
-        case '/': Nst_sb_push_char(&sb, '/' ); break;
-        case 'b': Nst_sb_push_char(&sb, '\b'); break;
-        case 'f': Nst_sb_push_char(&sb, '\f'); break;
-        case 'n': Nst_sb_push_char(&sb, '\n'); break;
-        case 'r': Nst_sb_push_char(&sb, '\r'); break;
-        case 't': Nst_sb_push_char(&sb, '\t'); break;
-        case 'u': {
-            advance();
-            if (state.idx + 3 >= state.len) {
-                Nst_sb_destroy(&sb);
-                SET_INVALID_ESCAPE_ERROR;
-                return Nst_tok_invalid();
+        u8 ch = *p;
+        if (ch == '"') {
+            advance(lexer);
+            break;
+        } else if (ch < ' ') {
+            SET_SYNTAX_ERROR("invalid character", lexer, lexer->pos);
+            return error_token();
+        } else if (ch >= 0x80) {
+            ensure_bytes(lexer, lexer->src_encoding->mult_max_sz);
+            u8 *ch_start = lexer->buf + lexer->idx;
+            i32 ch_len = lexer->src_encoding->check_bytes(
+                ch_start,
+                lexer->len - lexer->idx);
+            if (ch_len < 0) {
+                if (!Nst_error_occurred()) {
+                    Nst_error_setf_syntax(
+                        "JSON: could not decode byte %ib for %s encoding"
+                        FILE_INFO,
+                        *ch_start, lexer->src_encoding->name,
+                        lexer->path, lexer->pos.line, lexer->pos.col);
+                }
+                return error_token();
             }
+            if (!Nst_sb_push(sb, ch_start, ch_len))
+                return error_token();
+            lexer->idx += ch_len;
+            lexer->pos.col++;
+            continue;
+        }
 
-            u8 ch1 = (u8)tolower(state.ch);
-            advance();
-            u8 ch2 = (u8)tolower(state.ch);
-            advance();
-            u8 ch3 = (u8)tolower(state.ch);
-            advance();
-            u8 ch4 = (u8)tolower(state.ch);
-
-            if (!IS_HEX(ch1) || !IS_HEX(ch2) || !IS_HEX(ch3) || !IS_HEX(ch4)) {
-                Nst_sb_destroy(&sb);
-                SET_INVALID_ESCAPE_ERROR;
-                return Nst_tok_invalid();
+        // escape sequences
+        Nst_Pos escape_start = lexer->pos;
+        advance(lexer);
+        i32 escape = peek(lexer);
+        if (escape != CH_EOF)
+            advance(lexer);
+
+        char escaped_ch;
+        switch (escape) {
+        case '"': escaped_ch = '"';  break;
+        case '\\':escaped_ch = '\\'; break;
+        case '/': escaped_ch = '/';  break;
+        case 'b': escaped_ch = '\b'; break;
+        case 'f': escaped_ch = '\f'; break;
+        case 'n': escaped_ch = '\n'; break;
+        case 'r': escaped_ch = '\r'; break;
+        case 't': escaped_ch = '\t'; break;
+        case 'u': {
+            u32 num = 0;
+            for (int i = 0; i < 4; i++) {
+                i32 hex_ch = peek(lexer);
+                if (hex_ch == CH_EOF) {
+                    SET_SYNTAX_ERROR(
+                        "invalid string escape",
+                        lexer,
+                        escape_start);
+                    return error_token();
+                }
+                hex_ch = tolower(hex_ch);
+                if (!IS_HEX(hex_ch)) {
+                    SET_SYNTAX_ERROR(
+                        "invalid string escape",
+                        lexer,
+                        escape_start);
+                    return error_token();
+                }
+                num = (num << 4) + HEX_TO_INT(hex_ch);
+                advance(lexer);
             }
-
-            ch1 = HEX_TO_INT(ch1);
-            ch2 = HEX_TO_INT(ch2);
-            ch3 = HEX_TO_INT(ch3);
-            ch4 = HEX_TO_INT(ch4);
-
-            u32 num = (ch1 << 12) + (ch2 << 8) + (ch3 << 4) + ch4;
-            Nst_sb_push_cps(&sb, &num, 1);
-            break;
+            if (!Nst_sb_push_cps(sb, &num, 1))
+                return error_token();
+            continue;
         }
         default:
-            Nst_sb_destroy(&sb);
-            SET_INVALID_ESCAPE_ERROR;
-            return Nst_tok_invalid();
+            SET_SYNTAX_ERROR("invalid string escape", lexer, escape_start);
+            return error_token();
         }
 
-        escape = false;
-        advance();
+        if (!Nst_sb_push_char(sb, escaped_ch))
+            return error_token();
     }
 
-    if (state.ch != '"') {
-        JSON_SYNTAX_ERROR("open string", state.path, state.pos);
-        Nst_sb_destroy(&sb);
-        return Nst_tok_invalid();
-    }
+    Nst_Obj *val_obj = lexer->lexing_key
+        ? intern_key(&lexer->keys, sb)
+        : Nst_str_from_sv(Nst_sv_from_sb(sb));
+    if (val_obj == nullptr)
+        return error_token();
+    return make_token(JSON_VALUE, start, val_obj);
+}
 
-    Nst_Obj *val_obj = Nst_str_from_sb(&sb);
-    return Nst_tok_new(Nst_span_new(start, state.pos), JSON_VALUE, val_obj);
+// ------------------------------ Key interning ----------------------------- //
+
+static void destroy_keys(JSONKeyTable *keys)
+{
+    if (keys->entries == nullptr)
+        return;
+    for (usize i = 0; i < keys->cap; i++)
+        Nst_ndec_ref(keys->entries[i].key);
+    Nst_free(keys->entries);
+    keys->entries = nullptr;
+    keys->cap = 0;
+    keys->len = 0;
 }
 
-static bool check_ident(const char *name)
+static u32 hash_key(u8 *key, usize len)
 {
-    usize l = strlen(name);
-    for (usize i = 0; i < l; i++) {
-        if (state.ch != name[i]) {
-            SET_INVALID_VALUE_ERROR;
-            return false;
-        }
-        advance();
+    // FNV-1a
+    u32 hash = 2166136261u;
+    for (usize i = 0; i < len; i++) {
+        hash ^= key[i];
+        hash *= 16777619u;
     }
-    go_back();
+    return hash;
+}
+
+static bool grow_keys(JSONKeyTable *keys)
+{
+    usize new_cap = keys->cap == 0 ? 64 : keys->cap * 2;
+    JSONKeyEntry *new_entries = Nst_calloc_c(new_cap, JSONKeyEntry, nullptr);
+    if (new_entries == nullptr)
+        return false;
+
+    for (usize i = 0; i < keys->cap; i++) {
+        JSONKeyEntry entry = keys->entries[i];
+        if (entry.key == nullptr)
+            continue;
+        usize idx = entry.hash & (new_cap - 1);
+        while (new_entries[idx].key != nullptr)
+            idx = (idx + 1) & (new_cap - 1);
+        new_entries[idx] = entry;
+    }
+    if (keys->entries != nullptr)
+        Nst_free(keys->entries);
+    keys->entries = new_entries;
+    keys->cap = new_cap;
     return true;
 }
 
-static Nst_Tok parse_json_num()
+// Returns the `Str` with the contents of `sb`, reusing the one created the
+// previous time the same key was read if there is one
+static Nst_Obj *intern_key(JSONKeyTable *keys, Nst_StrBuilder *sb)
 {
-    char *start_idx = state.text->text + state.idx;
-    Nst_Pos start = state.pos;
-    if (state.ch == '-')
-        advance();
-
-    if (state.idx >= state.len) {
-        JSON_SYNTAX_ERROR("invalid number", state.path, state.pos);
-        return Nst_tok_invalid();
-    } else if (state.ch == '0') {
-        advance();
-        if (state.ch >= '0' && state.ch <= '9') {
-            JSON_SYNTAX_ERROR("invalid number", state.path, state.pos);
-            return Nst_tok_invalid();
+    if (sb->len > JSON_MAX_INTERNED_KEY_LEN)
+        return Nst_str_from_sv(Nst_sv_from_sb(sb));
+
+    u32 hash = hash_key(sb->value, sb->len);
+    usize idx = 0;
+    if (keys->cap != 0) {
+        idx = hash & (keys->cap - 1);
+        for (Nst_Obj *key = keys->entries[idx].key;
+             key != nullptr;
+             key = keys->entries[idx].key)
+        {
+            if (keys->entries[idx].hash == hash
+                && Nst_str_len(key) == sb->len
+                && memcmp(Nst_str_value(key), sb->value, sb->len) == 0)
+            {
+                return Nst_inc_ref(key);
+            }
+            idx = (idx + 1) & (keys->cap - 1);
         }
+    }
 
-        goto float_ltrl;
-    } else if (state.ch > '0' && state.ch <= '9') {
-        while (state.ch >= '0' && state.ch <= '9')
-            advance();
-
-        if (state.ch == '.' || state.ch == 'e' || state.ch == 'E')
-            goto float_ltrl;
-        go_back();
-        errno = 0;
-        i64 value = strtoll((char *)start_idx, nullptr, 10);
-        if (errno == ERANGE) {
-            Nst_error_setf_memory(
-                "JSON: number too big" FILE_INFO,
-                state.path,
-                state.pos.line,
-                state.pos.col);
-            return Nst_tok_invalid();
+    Nst_Obj *key = Nst_str_from_sv(Nst_sv_from_sb(sb));
+    if (key == nullptr || keys->len >= JSON_MAX_INTERNED_KEYS)
+        return key;
+
+    // the table is kept at most three quarters full
+    if ((keys->len + 1) * 4 > keys->cap * 3) {
+        if (!grow_keys(keys)) {
+            // the key can still be used even if it is not shared
+            Nst_error_clear();
+            return key;
         }
-        return Nst_tok_new(
-            Nst_span_new(start, state.pos),
+        idx = hash & (keys->cap - 1);
+        while (keys->entries[idx].key != nullptr)
+            idx = (idx + 1) & (keys->cap - 1);
+    }
+
+    keys->entries[idx].hash = hash;
+    keys->entries[idx].key = Nst_inc_ref(key);
+    keys->len++;
+    return key;
+}
+
+static bool push_digits(JSONLexer *lexer)
+{
+    i32 ch = peek(lexer);
+    if (!IS_DIGIT(ch)) {
+        SET_SYNTAX_ERROR("invalid number", lexer, lexer->pos);
+        return false;
+    }
+
+    do {
+        if (!Nst_sb_push_char(&lexer->sb, (char)ch))
+            return false;
+        advance(lexer);
+        ch = peek(lexer);
+    } while (IS_DIGIT(ch));
+    return true;
+}
+
+static JSONToken lex_num(JSONLexer *lexer)
+{
+    Nst_Pos start = lexer->pos;
+    Nst_StrBuilder *sb = &lexer->sb;
+    bool is_negative = false;
+    bool is_real = false;
+
+    sb->len = 0;
+    i32 ch = peek(lexer);
+    if (ch == '-') {
+        if (!Nst_sb_push_char(sb, '-'))
+            return error_token();
+        is_negative = true;
+        advance(lexer);
+        ch = peek(lexer);
+    }
+
+    if (ch == 'I' && nan_and_inf) {
+        if (!check_ident(lexer, "Infinity"))
+            return error_token();
+        return make_token(
             JSON_VALUE,
-            Nst_int_new(value));
-    } else if (state.ch == 'I' && nan_and_inf) {
-        if (!check_ident("Infinity"))
-            return Nst_tok_invalid();
-
-        if (*start_idx == '-') {
-            return Nst_tok_new(
-                Nst_span_new(start, state.pos),
-                JSON_VALUE,
-                Nst_inc_ref(Nst_const()->Real_neginf));
-        } else {
-            return Nst_tok_new(
-                Nst_span_new(start, state.pos),
-                JSON_VALUE,
-                Nst_inc_ref(Nst_const()->Real_inf));
-        }
-    } else if (state.ch == 'N' && nan_and_inf) {
-        if (!check_ident("NaN"))
-            return Nst_tok_invalid();
-
-        if (*start_idx == '-') {
-            return Nst_tok_new(
-                Nst_span_new(start, state.pos),
-                JSON_VALUE,
-                Nst_inc_ref(Nst_const()->Real_negnan));
-        } else {
-            return Nst_tok_new(
-                Nst_span_new(start, state.pos),
-                JSON_VALUE,
-                Nst_inc_ref(Nst_const()->Real_nan));
+            start,
+            Nst_inc_ref(is_negative
+                ? Nst_const()->Real_neginf
+                : Nst_const()->Real_inf));
+    } else if (ch == 'N' && nan_and_inf) {
+        if (!check_ident(lexer, "NaN"))
+            return error_token();
+        return make_token(
+            JSON_VALUE,
+            start,
+            Nst_inc_ref(is_negative
+                ? Nst_const()->Real_negnan
+                : Nst_const()->Real_nan));
+    } else if (ch == '0') {
+        if (!Nst_sb_push_char(sb, '0'))
+            return error_token();
+        advance(lexer);
+        ch = peek(lexer);
+        if (IS_DIGIT(ch)) {
+            SET_SYNTAX_ERROR("invalid number", lexer, lexer->pos);
+            return error_token();
         }
+    } else if (IS_DIGIT(ch)) {
+        if (!push_digits(lexer))
+            return error_token();
+        ch = peek(lexer);
     } else {
-        JSON_SYNTAX_ERROR("invalid number", state.path, state.pos);
-        return Nst_tok_invalid();
+        SET_SYNTAX_ERROR("invalid number", lexer, lexer->pos);
+        return error_token();
     }
 
-float_ltrl:
-    if (state.ch != '.' && state.ch != 'e' && state.ch != 'E') {
-        go_back();
-        return Nst_tok_new(
-            Nst_span_new(start, state.pos),
-            JSON_VALUE,
-            Nst_inc_ref(Nst_const()->Int_0));
+    if (ch == '.') {
+        is_real = true;
+        if (!Nst_sb_push_char(sb, '.'))
+            return error_token();
+        advance(lexer);
+        if (!push_digits(lexer))
+            return error_token();
+        ch = peek(lexer);
     }
 
-    if (state.ch == '.') {
-        advance();
-        if (state.ch < '0' || state.ch > '9') {
-            JSON_SYNTAX_ERROR("invalid number", state.path, state.pos);
-            return Nst_tok_invalid();
+    if (ch == 'e' || ch == 'E') {
+        is_real = true;
+        if (!Nst_sb_push_char(sb, 'e'))
+            return error_token();
+        advance(lexer);
+        ch = peek(lexer);
+        if (ch == '+' || ch == '-') {
+            if (!Nst_sb_push_char(sb, (char)ch))
+                return error_token();
+            advance(lexer);
         }
-        while (state.ch >= '0' && state.ch <= '9')
-            advance();
+        if (!push_digits(lexer))
+            return error_token();
     }
 
-    if (state.ch == 'e' || state.ch == 'E') {
-        advance();
-        if (state.ch == '+' || state.ch == '-')
-            advance();
+    if (!Nst_sb_reserve(sb, 1))
+        return error_token();
+    sb->value[sb->len] = '\0';
 
-        if (state.ch < '0' || state.ch > '9') {
-            JSON_SYNTAX_ERROR("invalid number", state.path, state.pos);
-            return Nst_tok_invalid();
-        }
-        while (state.ch >= '0' && state.ch <= '9')
-            advance();
-        go_back();
-    } else
-        go_back();
+    if (is_real) {
+        f64 value = Nst_strtod((char *)sb->value, nullptr);
+        Nst_Obj *real = Nst_real_new(value);
+        if (real == nullptr)
+            return error_token();
+        return make_token(JSON_VALUE, start, real);
+    }
 
-    {
-        f64 value = Nst_strtod((char *)start_idx, nullptr);
-        return Nst_tok_new(
-            Nst_span_new(start, state.pos),
-            JSON_VALUE,
-            Nst_real_new(value));
+    errno = 0;
+    i64 value = strtoll((char *)sb->value, nullptr, 10);
+    if (errno == ERANGE) {
+        Nst_error_setf_memory(
+            "JSON: number too big" FILE_INFO,
+            lexer->path,
+            start.line,
+            start.col);
+        return error_token();
     }
+    Nst_Obj *num = Nst_int_new(value);
+    if (num == nullptr)
+        return error_token();
+    return make_token(JSON_VALUE, start, num);
 }
 
-static Nst_Tok parse_json_val()
+static bool check_ident(JSONLexer *lexer, const char *name)
 {
-    Nst_Pos start = state.pos;
-    switch (state.ch) {
+    for (const char *p = name; *p != '\0'; p++) {
+        if (peek(lexer) != *p) {
+            SET_SYNTAX_ERROR("invalid value", lexer, lexer->pos);
+            return false;
+        }
+        advance(lexer);
+    }
+    return true;
+}
+
+static JSONToken lex_val(JSONLexer *lexer)
+{
+    Nst_Pos start = lexer->pos;
+    switch (peek(lexer)) {
     case 't':
-        if (!check_ident("true"))
-            return Nst_tok_invalid();
-        return Nst_tok_new(
-            Nst_span_new(start, state.pos),
-            JSON_VALUE,
-            Nst_inc_ref(Nst_true()));
+        if (!check_ident(lexer, "true"))
+            return error_token();
+        return make_token(JSON_VALUE, start, Nst_true_ref());
     case 'f':
-        if (!check_ident("false"))
-            return Nst_tok_invalid();
-        return Nst_tok_new(
-            Nst_span_new(start, state.pos),
-            JSON_VALUE,
-            Nst_inc_ref(Nst_false()));
+        if (!check_ident(lexer, "false"))
+            return error_token();
+        return make_token(JSON_VALUE, start, Nst_false_ref());
     default:
-        if (!check_ident("null"))
-            return Nst_tok_invalid();
-        return Nst_tok_new(
-            Nst_span_new(start, state.pos),
-            JSON_VALUE,
-            Nst_inc_ref(Nst_null()));
+        if (!check_ident(lexer, "null"))
+            return error_token();
+        return make_token(JSON_VALUE, start, Nst_null_ref());
     }
 }
 
-static bool ignore_comment()
+static bool skip_comment(JSONLexer *lexer)
 {
     if (!comments) {
-        JSON_SYNTAX_ERROR("invalid character", state.path, state.pos);
+        SET_SYNTAX_ERROR("invalid character", lexer, lexer->pos);
         return false;
     }
 
-    advance();
-    if (state.idx >= state.len || (state.ch != '/' && state.ch != '*')) {
-        JSON_SYNTAX_ERROR("invalid character", state.path, state.pos);
+    advance(lexer);
+    i32 ch = peek(lexer);
+    if (ch != '/' && ch != '*') {
+        SET_SYNTAX_ERROR("invalid character", lexer, lexer->pos);
         return false;
     }
+    advance(lexer);
 
-    bool is_multiline = state.ch == '*';
-    bool can_close = false;
+    if (ch == '/') {
+        while ((ch = peek(lexer)) != CH_EOF && ch != '\n' && ch != '\r')
+            advance(lexer);
+        return !Nst_error_occurred();
+    }
 
-    while (state.idx < state.len) {
-        advance();
-        if (state.ch == '\n' && !is_multiline) {
-            advance();
-            return true;
-        } else if (state.ch == '/' && can_close) {
-            advance();
+    bool can_close = false;
+    while ((ch = peek(lexer)) != CH_EOF) {
+        advance(lexer);
+        if (ch == '/' && can_close)
             return true;
-        } else if (state.ch == '*')
-            can_close = true;
-        else
-            can_close = false;
+        can_close = ch == '*';
     }
 
-    if (is_multiline) {
-        JSON_SYNTAX_ERROR("open multiline comment", state.path, state.pos);
-        return false;
-    }
-    return true;
+    SET_SYNTAX_ERROR("open multiline comment", lexer, lexer->pos);
+    return false;
 }
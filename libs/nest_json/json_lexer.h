@@ -9,12 +9,21 @@ extern bool nan_and_inf;
 const bool comments_default = false;
 const bool nan_and_inf_default = false;
 
+// size of the chunks read from a file at a time
+#define JSON_CHUNK_SIZE 65536
+
+// limits of the keys shared between the objects parsed by a lexer, longer
+// keys or keys past the limit are created normally
+#define JSON_MAX_INTERNED_KEYS 4096
+#define JSON_MAX_INTERNED_KEY_LEN 64
+
 #define JSON_SYNTAX_ERROR(msg, path, pos)                                     \
     Nst_error_setf_syntax(                                                    \
         "JSON: " msg ", file \"%s\", line %" PRIi32 ", column %" PRIi32,      \
         path, (pos).line, (pos).col)
 
 typedef enum _JSONTokenType {
+    JSON_ERROR = -1,
     JSON_LBRACKET,
     JSON_RBRACKET,
     JSON_LBRACE,
@@ -25,7 +34,90 @@ typedef enum _JSONTokenType {
     JSON_EOF
 } JSONTokenType;
 
-Nst_DynArray json_tokenize(char *path, char *text, usize text_len,
-                           Nst_EncodingID encoding);
+typedef struct _JSONToken {
+    JSONTokenType type;
+    Nst_Pos pos;
+    Nst_Obj *value;
+} JSONToken;
+
+typedef struct _JSONKeyEntry {
+    u32 hash;
+    Nst_Obj *key;
+} JSONKeyEntry;
+
+/**
+ * An open-addressing table of the object keys already read by a lexer. When a
+ * key is found again the same `Str` is reused, together with the hash cached
+ * inside it.
+ *
+ * @param entries: the entries of the table, `nullptr` when it is empty
+ * @param cap: the number of entries, always a power of two
+ * @param len: the number of keys in the table
+ */
+typedef struct _JSONKeyTable {
+    JSONKeyEntry *entries;
+    usize cap;
+    usize len;
+} JSONKeyTable;
+
+/**
+ * The state of the lexer. The text is read in chunks of `JSON_CHUNK_SIZE`
+ * bytes when reading from a file, so the whole document is never kept in
+ * memory.
+ *
+ * @param file: the binary file the text is read from, `nullptr` when lexing a
+ * string
+ * @param src_encoding: the encoding of the file
+ * @param decode: whether the chunks read need to be translated to UTF-8
+ * @param eof: whether the end of the file has been reached
+ * @param buf: the UTF-8 text currently available
+ * @param len: the length in bytes of `buf`
+ * @param idx: the index in `buf` of the current character
+ * @param raw_buf: the bytes read from the file before being decoded
+ * @param raw_len: the bytes left in `raw_buf` from the previous chunk
+ * @param raw_pos: the number of bytes read from the file so far
+ * @param sb: scratch buffer used to build strings and numbers
+ * @param pos: the position of the current character
+ * @param path: the path printed in error messages
+ * @param after_cr: whether the previous character was a carriage return
+ * @param keys: the keys of the objects read so far
+ * @param lexing_key: whether the string being read is the key of an object
+ */
+typedef struct _JSONLexer {
+    Nst_Obj *file;
+    Nst_Encoding *src_encoding;
+    bool decode;
+    bool eof;
+    u8 *buf;
+    usize len;
+    usize idx;
+    u8 *raw_buf;
+    usize raw_len;
+    usize raw_pos;
+    Nst_StrBuilder sb;
+    Nst_Pos pos;
+    const char *path;
+    bool after_cr;
+    JSONKeyTable keys;
+    bool lexing_key;
+} JSONLexer;
+
+/* Initialize a lexer that reads the contents of a `Str` object. */
+bool json_lexer_init_str(JSONLexer *lexer, Nst_Obj *str);
+/* Initialize a lexer that reads the file at `path` one chunk at a time. */
+bool json_lexer_init_file(JSONLexer *lexer, const char *path,
+                          Nst_EncodingID encoding);
+/* Free the buffers of a lexer and close its file. */
+void json_lexer_destroy(JSONLexer *lexer);
+/**
+ * Read the next token. On failure the type of the token is `JSON_ERROR` and
+ * the error is set.
+ */
+JSONToken json_next_token(JSONLexer *lexer);
+/**
+ * Read the next token where the key of an object is expected. Keys that were
+ * already read by the lexer return the same `Str` object.
+ */
+JSONToken json_next_key(JSONLexer *lexer);
 
 #endif // !JSON_LEXER_H
@@ -3,10 +3,6 @@
 #include "json_parser.h"
 
 bool trailing_commas = false;
-static char *file_path; // the text of the position cannot be used
-static i32 recursion_level;
-static Nst_DynArray *tokens;
-static usize idx;
 
 // needed because when debugging on Windows it runs out of stack space quickly
 // does not cause any issues when running on Release mode
@@ -16,192 +12,266 @@ static usize idx;
 #define MAX_RECURSION_LVL 1500
 #endif
 
-#define INC_RECURSION_LVL do {                                                \
-        recursion_level++;                                                    \
-        if (recursion_level > MAX_RECURSION_LVL) {                            \
+#define INC_RECURSION_LVL(parser) do {                                        \
+        (parser)->recursion_level++;                                          \
+        if ((parser)->recursion_level > MAX_RECURSION_LVL) {                  \
             Nst_error_setc_memory(                                            \
                 "over 1500 recursive calls, parsing failed");                 \
             return nullptr;                                                   \
         }                                                                     \
     } while (0)
-#define DEC_RECURSION_LVL recursion_level--
+#define DEC_RECURSION_LVL(parser) (parser)->recursion_level--
 
-static Nst_Obj *parse_value();
-static Nst_Obj *parse_object();
-static Nst_Obj *parse_array();
+// the error is already set when the lexer fails to read a token
+#define UNEXPECTED_TOKEN(msg, parser, tok) do {                               \
+        if ((tok).type != JSON_ERROR)                                         \
+            JSON_SYNTAX_ERROR(msg, (parser)->lexer->path, (tok).pos);         \
+        Nst_ndec_ref((tok).value);                                            \
+    } while (0)
 
-static Nst_Tok *pop_tok()
-{
-    return (Nst_Tok *)Nst_da_get(tokens, idx++);
-}
+typedef struct _JSONParser {
+    JSONLexer *lexer;
+    i32 recursion_level;
+} JSONParser;
 
-static Nst_Tok *peek_tok()
-{
-    return (Nst_Tok *)Nst_da_get(tokens, idx);
-}
+static Nst_Obj *parse_value(JSONParser *parser, JSONToken tok);
+static Nst_Obj *parse_object(JSONParser *parser);
+static Nst_Obj *parse_array(JSONParser *parser);
 
-Nst_Obj *json_parse(char *path, Nst_DynArray *tok_arr)
+Nst_Obj *json_parse(JSONLexer *lexer)
 {
-    tokens = tok_arr;
-    file_path = path;
-    recursion_level = 0;
-    idx = 0;
-    Nst_Obj *res = parse_value();
-    if (res == nullptr) {
-        Nst_da_clear(tokens, (Nst_Destructor)Nst_tok_destroy);
-        return nullptr;
-    }
+    JSONParser parser = { lexer, 0 };
+    Nst_Obj *res = parse_value(&parser, json_next_token(lexer));
 
-    if (idx + 1 != tokens->len) {
-        Nst_dec_ref(res);
-        Nst_Pos err_pos = Nst_span_end(
-            ((Nst_Tok *)Nst_da_get(tokens, idx))->span);
-        JSON_SYNTAX_ERROR("unexpected token", file_path, err_pos);
-        Nst_da_clear(tokens, (Nst_Destructor)Nst_tok_destroy);
-        return nullptr;
+    if (res != nullptr) {
+        JSONToken tok = json_next_token(lexer);
+        if (tok.type != JSON_EOF) {
+            UNEXPECTED_TOKEN("unexpected token", &parser, tok);
+            Nst_dec_ref(res);
+            res = nullptr;
+        }
     }
-    Nst_da_clear(tokens, (Nst_Destructor)Nst_tok_destroy);
+    json_lexer_destroy(lexer);
     return res;
 }
 
-static Nst_Obj *parse_value()
+static Nst_Obj *parse_value(JSONParser *parser, JSONToken tok)
 {
-    INC_RECURSION_LVL;
-    Nst_Tok *tok = pop_tok();
-
-    switch ((JSONTokenType)tok->type) {
-    case JSON_VALUE: {
-        Nst_Obj *res = Nst_inc_ref(tok->value);
-        DEC_RECURSION_LVL;
-        return res;
-    }
+    switch (tok.type) {
+    case JSON_VALUE:
+        return tok.value;
     case JSON_LBRACKET:
-        DEC_RECURSION_LVL;
-        return parse_array();
+        return parse_array(parser);
     case JSON_LBRACE:
-        DEC_RECURSION_LVL;
-        return parse_object();
+        return parse_object(parser);
     default:
-        JSON_SYNTAX_ERROR(
-            "expected value",
-            file_path,
-            Nst_span_start(tok->span));
+        UNEXPECTED_TOKEN("expected value", parser, tok);
         return nullptr;
     }
 }
 
-static Nst_Obj *parse_object()
+static Nst_Obj *parse_object(JSONParser *parser)
 {
-    INC_RECURSION_LVL;
+    INC_RECURSION_LVL(parser);
     Nst_Obj *map = Nst_map_new();
-    Nst_Tok *tok = pop_tok();
+    if (map == nullptr)
+        return nullptr;
 
-    if ((JSONTokenType)tok->type == JSON_RBRACE) {
-        DEC_RECURSION_LVL;
-        return map;
-    }
+    JSONToken tok = json_next_key(parser->lexer);
+    if (tok.type == JSON_RBRACE)
+        goto end;
 
     while (true) {
-        if ((JSONTokenType)tok->type != JSON_VALUE || !Nst_T(tok->value, Str)){
-            JSON_SYNTAX_ERROR(
-                "expected string",
-                file_path,
-                Nst_span_start(tok->span));
-            Nst_dec_ref(map);
-            return nullptr;
+        if (tok.type != JSON_VALUE || !Nst_T(tok.value, Str)) {
+            UNEXPECTED_TOKEN("expected string", parser, tok);
+            goto failure;
         }
 
-        Nst_Obj *key = Nst_inc_ref(tok->value);
-        tok = pop_tok();
+        Nst_Obj *key = tok.value;
+        tok = json_next_token(parser->lexer);
 
-        if ((JSONTokenType)tok->type != JSON_COLON) {
-            JSON_SYNTAX_ERROR(
-                "expected colon",
-                file_path,
-                Nst_span_start(tok->span));
-            Nst_dec_ref(map);
+        if (tok.type != JSON_COLON) {
+            UNEXPECTED_TOKEN("expected colon", parser, tok);
             Nst_dec_ref(key);
-            return nullptr;
+            goto failure;
         }
 
-        Nst_Obj *val = parse_value();
-
+        Nst_Obj *val = parse_value(parser, json_next_token(parser->lexer));
         if (val == nullptr) {
-            Nst_dec_ref(map);
             Nst_dec_ref(key);
-            return nullptr;
+            goto failure;
         }
 
-        Nst_map_set(map, key, val);
+        bool result = Nst_map_set(map, key, val);
         Nst_dec_ref(key);
         Nst_dec_ref(val);
+        if (!result)
+            goto failure;
 
-        tok = pop_tok();
-        if ((JSONTokenType)tok->type == JSON_RBRACE) {
-            DEC_RECURSION_LVL;
-            return map;
-        } else if ((JSONTokenType)tok->type == JSON_COMMA) {
-            tok = pop_tok();
-        } else {
-            JSON_SYNTAX_ERROR(
-                "expected ',' or '}'",
-                file_path,
-                Nst_span_start(tok->span));
-            Nst_dec_ref(map);
-            return nullptr;
+        tok = json_next_token(parser->lexer);
+        if (tok.type == JSON_RBRACE)
+            goto end;
+        else if (tok.type == JSON_COMMA)
+            tok = json_next_key(parser->lexer);
+        else {
+            UNEXPECTED_TOKEN("expected ',' or '}'", parser, tok);
+            goto failure;
         }
 
-        if ((JSONTokenType)tok->type == JSON_RBRACE && trailing_commas) {
-            DEC_RECURSION_LVL;
-            return map;
-        }
+        if (tok.type == JSON_RBRACE && trailing_commas)
+            goto end;
     }
+
+end:
+    DEC_RECURSION_LVL(parser);
+    return map;
+
+failure:
+    Nst_dec_ref(map);
+    return nullptr;
 }
 
-static Nst_Obj *parse_array()
+static Nst_Obj *parse_array(JSONParser *parser)
 {
-    INC_RECURSION_LVL;
+    INC_RECURSION_LVL(parser);
     Nst_Obj *vec = Nst_vector_new(0);
-    Nst_Tok *tok = peek_tok();
+    if (vec == nullptr)
+        return nullptr;
 
-    if ((JSONTokenType)tok->type == JSON_RBRACKET) {
-        pop_tok();
+    JSONToken tok = json_next_token(parser->lexer);
+    if (tok.type == JSON_RBRACKET)
         goto end;
-    }
 
     while (true) {
-        Nst_Obj *val = parse_value();
-
+        Nst_Obj *val = parse_value(parser, tok);
         if (val == nullptr) {
             Nst_dec_ref(vec);
             return nullptr;
         }
 
-        Nst_vector_append(vec, val);
+        bool result = Nst_vector_append(vec, val);
         Nst_dec_ref(val);
+        if (!result) {
+            Nst_dec_ref(vec);
+            return nullptr;
+        }
 
-        tok = pop_tok();
-        if ((JSONTokenType)tok->type == JSON_RBRACKET) {
+        tok = json_next_token(parser->lexer);
+        if (tok.type == JSON_RBRACKET)
             goto end;
-        } else if ((JSONTokenType)tok->type != JSON_COMMA) {
-            JSON_SYNTAX_ERROR(
-                "expected ',' or ']'",
-                file_path,
-                Nst_span_start(tok->span));
+        else if (tok.type != JSON_COMMA) {
+            UNEXPECTED_TOKEN("expected ',' or ']'", parser, tok);
             Nst_dec_ref(vec);
             return nullptr;
         }
 
-        tok = peek_tok();
-        if ((JSONTokenType)tok->type == JSON_RBRACKET && trailing_commas) {
-            pop_tok();
+        tok = json_next_token(parser->lexer);
+        if (tok.type == JSON_RBRACKET && trailing_commas)
             goto end;
-        }
     }
 
 end:
     vec->type = Nst_inc_ref(Nst_type()->Array);
     Nst_dec_ref(Nst_type()->Vector);
-    DEC_RECURSION_LVL;
+    DEC_RECURSION_LVL(parser);
     return vec;
 }
+
+// ------------------------------- Iterator -------------------------------- //
+
+static void close_iter(JSONIterData *data)
+{
+    if (data->state == JSON_ITER_CLOSED)
+        return;
+    json_lexer_destroy(&data->lexer);
+    data->state = JSON_ITER_CLOSED;
+}
+
+void destroy_json_iter_data(Nst_Obj *obj)
+{
+    JSONIterData *data = (JSONIterData *)Nst_obj_custom_data(obj);
+    close_iter(data);
+    Nst_dec_ref(data->path);
+}
+
+static Nst_Obj *end_of_array(JSONParser *parser)
+{
+    JSONToken tok = json_next_token(parser->lexer);
+    if (tok.type != JSON_EOF) {
+        UNEXPECTED_TOKEN("unexpected token", parser, tok);
+        return nullptr;
+    }
+    return Nst_iend_ref();
+}
+
+static Nst_Obj *next_array_item(JSONParser *parser, JSONIterData *data)
+{
+    JSONToken tok = json_next_token(parser->lexer);
+
+    if (data->state == JSON_ITER_BEGIN) {
+        if (tok.type != JSON_LBRACKET) {
+            UNEXPECTED_TOKEN("expected '['", parser, tok);
+            return nullptr;
+        }
+        tok = json_next_token(parser->lexer);
+        if (tok.type == JSON_RBRACKET)
+            return end_of_array(parser);
+        data->state = JSON_ITER_ITEMS;
+        return parse_value(parser, tok);
+    }
+
+    if (tok.type == JSON_RBRACKET)
+        return end_of_array(parser);
+    else if (tok.type != JSON_COMMA) {
+        UNEXPECTED_TOKEN("expected ',' or ']'", parser, tok);
+        return nullptr;
+    }
+
+    tok = json_next_token(parser->lexer);
+    if (tok.type == JSON_RBRACKET && trailing_commas)
+        return end_of_array(parser);
+    return parse_value(parser, tok);
+}
+
+static Nst_Obj *next_value(JSONParser *parser)
+{
+    JSONToken tok = json_next_token(parser->lexer);
+    if (tok.type == JSON_EOF)
+        return Nst_iend_ref();
+    return parse_value(parser, tok);
+}
+
+Nst_Obj *NstC json_iter_start(usize arg_num, Nst_Obj **args)
+{
+    Nst_UNUSED(arg_num);
+    JSONIterData *data = (JSONIterData *)Nst_obj_custom_data(args[0]);
+    close_iter(data);
+
+    bool result = json_lexer_init_file(
+        &data->lexer,
+        (const char *)Nst_str_value(data->path),
+        data->encoding);
+    if (!result)
+        return nullptr;
+
+    data->state = JSON_ITER_BEGIN;
+    return Nst_null_ref();
+}
+
+Nst_Obj *NstC json_iter_next(usize arg_num, Nst_Obj **args)
+{
+    Nst_UNUSED(arg_num);
+    JSONIterData *data = (JSONIterData *)Nst_obj_custom_data(args[0]);
+    if (data->state == JSON_ITER_CLOSED)
+        return Nst_iend_ref();
+
+    JSONParser parser = { &data->lexer, 0 };
+    Nst_Obj *res = data->ndjson
+        ? next_value(&parser)
+        : next_array_item(&parser, data);
+
+    // the file is closed as soon as it is no longer needed
+    if (res == nullptr || res == Nst_iend())
+        close_iter(data);
+    return res;
+}
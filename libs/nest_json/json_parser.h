@@ -2,10 +2,41 @@
 #define JSON_PARSER_H
 
 #include "nest.h"
+#include "json_lexer.h"
 
 extern bool trailing_commas;
 const bool trailing_commas_default = false;
 
-Nst_Obj *json_parse(char *path, Nst_DynArray *tokens);
+typedef enum _JSONIterState {
+    JSON_ITER_CLOSED,
+    JSON_ITER_BEGIN,
+    JSON_ITER_ITEMS
+} JSONIterState;
 
-#endif // !JSON_PARSER
\ No newline at end of file
+/**
+ * The data of the iterator returned by `iter_load`.
+ *
+ * @param path: the path of the file to read
+ * @param encoding: the encoding of the file
+ * @param ndjson: whether the file contains a sequence of values instead of a
+ * single array
+ * @param state: the state of the iterator, when it is `JSON_ITER_CLOSED` the
+ * lexer is not initialized
+ * @param lexer: the lexer reading the file
+ */
+typedef struct _JSONIterData {
+    Nst_Obj *path;
+    Nst_EncodingID encoding;
+    bool ndjson;
+    JSONIterState state;
+    JSONLexer lexer;
+} JSONIterData;
+
+/* Parse a whole JSON document, destroying the lexer afterwards. */
+Nst_Obj *json_parse(JSONLexer *lexer);
+
+void destroy_json_iter_data(Nst_Obj *obj);
+Nst_Obj *NstC json_iter_start(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC json_iter_next(usize arg_num, Nst_Obj **args);
+
+#endif // !JSON_PARSER
@@ -1,4 +1,9 @@
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
 #include "nest_json.h"
 #include "json_lexer.h"
 #include "json_parser.h"
@@ -7,6 +12,7 @@
 static Nst_Declr obj_list_[] = {
     Nst_FUNCDECLR(load_s_,        1),
     Nst_FUNCDECLR(load_f_,        2),
+    Nst_FUNCDECLR(iter_load_,     3),
     Nst_FUNCDECLR(dump_s_,        2),
     Nst_FUNCDECLR(dump_f_,        4),
     Nst_FUNCDECLR(set_option_,    2),
@@ -15,27 +21,80 @@ static Nst_Declr obj_list_[] = {
     Nst_DECLR_END
 };
 
+namespace fs = std::filesystem;
+
+static Nst_Obj *iter_start_func = nullptr;
+static Nst_Obj *iter_next_func = nullptr;
+
+static fs::path utf8_path(const char *str)
+{
+    return fs::path((const char8_t *)str);
+}
+
+// Follows the symbolic links at `path` so that the file they point to is
+// replaced instead of the link itself
+static fs::path resolve_symlinks(fs::path path)
+{
+    std::error_code ec;
+    // the same limit used by most systems to detect loops
+    for (int i = 0; i < 40 && fs::is_symlink(path, ec); i++) {
+        fs::path target = fs::read_symlink(path, ec);
+        if (ec)
+            break;
+        path = target.is_absolute() ? target : path.parent_path() / target;
+    }
+    return path;
+}
+
+// Creates a new file with a unique name in the same directory as `dest`, an
+// existing file is never opened
+static FILE *open_temp_file(const fs::path &dest, fs::path &tmp_path)
+{
+    std::random_device rd;
+    char suffix[32];
+
+    for (int i = 0; i < 100; i++) {
+        snprintf(suffix, sizeof(suffix), ".%08x.tmp", (unsigned int)rd());
+        tmp_path = dest;
+        tmp_path += suffix;
+        std::u8string tmp_str = tmp_path.u8string();
+        // 'x' fails if the file already exists
+        FILE *f = Nst_fopen_unicode((const char *)tmp_str.c_str(), "wbx");
+        if (f != nullptr || errno != EEXIST)
+            return f;
+    }
+    return nullptr;
+}
+
 Nst_Declr *lib_init()
 {
+    iter_start_func = Nst_func_new_c(1, json_iter_start);
+    iter_next_func = Nst_func_new_c(1, json_iter_next);
+
+    if (Nst_error_occurred()) {
+        Nst_ndec_ref(iter_start_func);
+        Nst_ndec_ref(iter_next_func);
+        return nullptr;
+    }
     return obj_list_;
 }
 
+void lib_quit()
+{
+    Nst_ndec_ref(iter_start_func);
+    Nst_ndec_ref(iter_next_func);
+}
+
 Nst_Obj *NstC load_s_(usize arg_num, Nst_Obj **args)
 {
     Nst_Obj *str;
     if (!Nst_extract_args("s", arg_num, args, &str))
         return nullptr;
 
-    Nst_DynArray tokens = json_tokenize(
-        NULL,
-        (char *)Nst_str_value(str),
-        Nst_str_len(str),
-        Nst_EID_EXT_UTF8);
-    if (tokens.len == 0)
+    JSONLexer lexer;
+    if (!json_lexer_init_str(&lexer, str))
         return nullptr;
-
-    Nst_Obj *value = json_parse((char *)"<Str>", &tokens);
-    return value;
+    return json_parse(&lexer);
 }
 
 Nst_Obj *NstC load_f_(usize arg_num, Nst_Obj **args)
@@ -49,17 +108,46 @@ Nst_Obj *NstC load_f_(usize arg_num, Nst_Obj **args)
         encoding_obj,
         Nst_encoding_from_name((char *)Nst_str_value(encoding_obj)),
         Nst_EID_UNKNOWN);
-    encoding = Nst_encoding_to_single_byte(encoding);
 
-    Nst_DynArray tokens = json_tokenize(
-        (char *)Nst_str_value(path),
-        nullptr, 0,
-        encoding);
-    if (tokens.len == 0)
+    JSONLexer lexer;
+    if (!json_lexer_init_file(&lexer, (char *)Nst_str_value(path), encoding))
         return nullptr;
+    return json_parse(&lexer);
+}
+
+Nst_Obj *NstC iter_load_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *path;
+    bool ndjson;
+    Nst_Obj *encoding_obj;
+    if (!Nst_extract_args("s y ?s", arg_num, args, &path, &ndjson,
+                          &encoding_obj))
+    {
+        return nullptr;
+    }
+
+    JSONIterData data;
+    data.path = Nst_inc_ref(path);
+    data.encoding = Nst_DEF_VAL(
+        encoding_obj,
+        Nst_encoding_from_name((char *)Nst_str_value(encoding_obj)),
+        Nst_EID_UNKNOWN);
+    data.ndjson = ndjson;
+    data.state = JSON_ITER_CLOSED;
 
-    Nst_Obj *value = json_parse((char *)Nst_str_value(path), &tokens);
-    return value;
+    Nst_Obj *iter_data = Nst_obj_custom_ex(
+        JSONIterData,
+        &data,
+        destroy_json_iter_data);
+    if (iter_data == nullptr) {
+        Nst_dec_ref(path);
+        return nullptr;
+    }
+
+    return Nst_iter_new(
+        Nst_inc_ref(iter_start_func),
+        Nst_inc_ref(iter_next_func),
+        iter_data);
 }
 
 Nst_Obj *NstC dump_s_(usize arg_num, Nst_Obj **args)
@@ -94,9 +182,19 @@ Nst_Obj *NstC dump_f_(usize arg_num, Nst_Obj **args)
         encoding_obj,
         Nst_encoding_from_name((char *)Nst_str_value(encoding_obj)),
         Nst_EID_EXT_UTF8);
+    if (encoding == Nst_EID_UNKNOWN) {
+        Nst_error_setf_value(
+            "invalid encoding '%.100s'",
+            Nst_str_value(encoding_obj));
+        return nullptr;
+    }
     encoding = Nst_encoding_to_single_byte(encoding);
 
-    FILE *f = Nst_fopen_unicode((char *)Nst_str_value(path), "wb");
+    // the object is dumped to a temporary file that replaces the destination
+    // only on success, a dump that fails does not leave a partial file
+    fs::path dest = resolve_symlinks(utf8_path((char *)Nst_str_value(path)));
+    fs::path tmp_path;
+    FILE *f = open_temp_file(dest, tmp_path);
 
     if (f == nullptr) {
         if (!Nst_error_occurred()) {
@@ -107,32 +205,37 @@ Nst_Obj *NstC dump_f_(usize arg_num, Nst_Obj **args)
         return nullptr;
     }
 
-    Nst_Obj *res = json_dump(obj, (i32)indent);
-    if (res == nullptr) {
+    Nst_Obj *file = Nst_iof_new(f, true, false, true, nullptr);
+    if (file == nullptr) {
         fclose(f);
+        std::error_code ec;
+        fs::remove(tmp_path, ec);
         return nullptr;
     }
 
-    u8 *encoded_str;
-    usize encoded_str_len;
+    bool result = json_dump_file(obj, (i32)indent, file, encoding);
+    Nst_fclose(file);
+    Nst_dec_ref(file);
 
-    bool result = Nst_encoding_translate(
-        Nst_encoding(Nst_EID_EXT_UTF8),
-        Nst_encoding(encoding),
-        (void *)Nst_str_value(res),
-        Nst_str_len(res),
-        (void **)&encoded_str,
-        &encoded_str_len);
-    Nst_dec_ref(res);
+    std::error_code ec;
+    if (result) {
+        // keep the permissions of the file that is replaced
+        fs::file_status dest_status = fs::status(dest, ec);
+        if (!ec && fs::exists(dest_status))
+            fs::permissions(tmp_path, dest_status.permissions(), ec);
+        fs::rename(tmp_path, dest, ec);
+        if (ec) {
+            Nst_error_setf_value(
+                "could not write to the file '%.4096s'",
+                Nst_str_value(path));
+            result = false;
+        }
+    }
 
     if (!result) {
-        fclose(f);
+        fs::remove(tmp_path, ec);
         return nullptr;
     }
-
-    fwrite(encoded_str, sizeof(u8), encoded_str_len, f);
-    fclose(f);
-    Nst_free(encoded_str);
     return Nst_null_ref();
 }
 
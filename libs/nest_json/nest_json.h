@@ -8,9 +8,11 @@ extern "C" {
 #endif // !__cplusplus
 
 NstEXP Nst_Declr *NstC lib_init();
+NstEXP void NstC lib_quit();
 
 Nst_Obj *NstC load_s_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC load_f_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC iter_load_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC dump_s_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC dump_f_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC set_option_(usize arg_num, Nst_Obj **args);
@@ -5,6 +5,7 @@ using std::fmin;
 using std::fmax;
 using std::isnan;
 using std::isinf;
+using std::isfinite;
 
 static Nst_Declr obj_list_[] = {
     Nst_FUNCDECLR(floor_,  1),
@@ -35,6 +36,13 @@ static Nst_Declr obj_list_[] = {
     Nst_FUNCDECLR(min_,    2),
     Nst_FUNCDECLR(max_,    2),
     Nst_FUNCDECLR(sum_,    1),
+    Nst_FUNCDECLR(argmin_, 1),
+    Nst_FUNCDECLR(argmax_, 1),
+    Nst_FUNCDECLR(dot_,    2),
+    Nst_FUNCDECLR(seq_add_,2),
+    Nst_FUNCDECLR(seq_mul_,2),
+    Nst_FUNCDECLR(seq_scale_, 2),
+    Nst_FUNCDECLR(prefix_sum_, 1),
     Nst_FUNCDECLR(frexp_,  1),
     Nst_FUNCDECLR(ldexp_,  2),
     Nst_FUNCDECLR(map_,    5),
@@ -276,32 +284,394 @@ Nst_Obj *NstC dist_3d_(usize arg_num, Nst_Obj **args)
     return Nst_real_new(sqrt(d2));
 }
 
-Nst_Obj *NstC dist_nd_(usize arg_num, Nst_Obj **args)
+// Same tolerance used by the comparison operators
+#define REAL_EPSILON 9.9e-15
+
+// The kinds of values of a numeric sequence, a kind can represent all the
+// values of the kinds that come before it
+enum NumKind {
+    NUM_BYTE,
+    NUM_INT,
+    NUM_REAL,
+    NUM_OTHER
+};
+
+// The values of a sequence stored contiguously, `values` is owned only when
+// they were copied out of an `Array` or a `Vector`
+struct NumSeq {
+    NumKind kind;
+    usize len;
+    void *values;
+    bool owned;
+};
+
+static bool is_num_seq(Nst_Obj *obj)
 {
-    Nst_Obj *p1;
-    Nst_Obj *p2;
+    return Nst_T(obj, Array) || Nst_T(obj, Vector) || Nst_is_typed_array(obj);
+}
 
-    if (!Nst_extract_args("A.N A.N", arg_num, args, &p1, &p2))
-        return nullptr;
+static void free_num_seq(NumSeq *ns)
+{
+    if (ns->owned)
+        Nst_free(ns->values);
+    ns->values = nullptr;
+    ns->owned = false;
+}
 
-    if (Nst_seq_len(p1) != Nst_seq_len(p2)) {
-        Nst_error_setc_value(
-            "the points must have the same number of values");
-        return nullptr;
+static bool load_num_seq(Nst_Obj *seq, usize arg_idx, NumSeq *ns)
+{
+    ns->values = nullptr;
+    ns->owned = false;
+
+    if (Nst_is_typed_array(seq)) {
+        ns->len = Nst_typed_array_len(seq);
+        if (Nst_T(seq, IntArray)) {
+            ns->kind = NUM_INT;
+            ns->values = Nst_int_array_values(seq);
+        } else if (Nst_T(seq, RealArray)) {
+            ns->kind = NUM_REAL;
+            ns->values = Nst_real_array_values(seq);
+        } else {
+            ns->kind = NUM_BYTE;
+            ns->values = Nst_byte_array_values(seq);
+        }
+        return true;
+    }
+
+    if (!Nst_T(seq, Array) && !Nst_T(seq, Vector)) {
+        Nst_error_setf_type(
+            "expected type 'Array', 'Vector' or a typed array for argument %zi"
+            " but got type '%s' instead",
+            arg_idx, Nst_type_name(seq->type).value);
+        return false;
+    }
+
+    Nst_Obj **objs = Nst_seq_objs(seq);
+    usize len = Nst_seq_len(seq);
+    ns->len = len;
+    ns->kind = NUM_BYTE;
+
+    // the kind is checked only once so that the kernels work on plain values
+    for (usize i = 0; i < len; i++) {
+        Nst_Obj *type = objs[i]->type;
+        if (type == Nst_type()->Real)
+            ns->kind = NUM_REAL;
+        else if (type == Nst_type()->Int) {
+            if (ns->kind == NUM_BYTE)
+                ns->kind = NUM_INT;
+        } else if (type != Nst_type()->Byte) {
+            ns->kind = NUM_OTHER;
+            return true;
+        }
+    }
+
+    if (len == 0)
+        return true;
+
+    if (ns->kind == NUM_REAL) {
+        f64 *values = Nst_malloc_c(len, f64);
+        if (values == nullptr)
+            return false;
+        for (usize i = 0; i < len; i++)
+            values[i] = Nst_number_to_f64(objs[i]);
+        ns->values = values;
+    } else if (ns->kind == NUM_INT) {
+        i64 *values = Nst_malloc_c(len, i64);
+        if (values == nullptr)
+            return false;
+        for (usize i = 0; i < len; i++)
+            values[i] = Nst_number_to_i64(objs[i]);
+        ns->values = values;
+    } else {
+        u8 *values = Nst_malloc_c(len, u8);
+        if (values == nullptr)
+            return false;
+        for (usize i = 0; i < len; i++)
+            values[i] = Nst_byte_u8(objs[i]);
+        ns->values = values;
+    }
+    ns->owned = true;
+    return true;
+}
+
+static bool widen_num_seq(NumSeq *ns, NumKind kind)
+{
+    if (ns->kind >= kind)
+        return true;
+
+    if (ns->len == 0) {
+        ns->kind = kind;
+        return true;
+    }
+
+    void *values;
+    if (kind == NUM_REAL) {
+        f64 *reals = Nst_malloc_c(ns->len, f64);
+        if (reals == nullptr)
+            return false;
+        if (ns->kind == NUM_INT) {
+            i64 *ints = (i64 *)ns->values;
+            for (usize i = 0, n = ns->len; i < n; i++)
+                reals[i] = (f64)ints[i];
+        } else {
+            u8 *bytes = (u8 *)ns->values;
+            for (usize i = 0, n = ns->len; i < n; i++)
+                reals[i] = (f64)bytes[i];
+        }
+        values = reals;
+    } else {
+        i64 *ints = Nst_malloc_c(ns->len, i64);
+        if (ints == nullptr)
+            return false;
+        u8 *bytes = (u8 *)ns->values;
+        for (usize i = 0, n = ns->len; i < n; i++)
+            ints[i] = (i64)bytes[i];
+        values = ints;
+    }
+
+    free_num_seq(ns);
+    ns->kind = kind;
+    ns->values = values;
+    ns->owned = true;
+    return true;
+}
+
+// Loads two sequences of numbers of the same length converting their values
+// to the same kind, which is at least `min_kind`
+static bool load_num_seq_pair(Nst_Obj *seq1, Nst_Obj *seq2, NumSeq *ns1,
+                              NumSeq *ns2, NumKind min_kind)
+{
+    if (!load_num_seq(seq1, 1, ns1))
+        return false;
+    if (!load_num_seq(seq2, 2, ns2)) {
+        free_num_seq(ns1);
+        return false;
+    }
+
+    NumKind kind = min_kind;
+    if (ns1->kind == NUM_OTHER || ns2->kind == NUM_OTHER) {
+        Nst_error_setc_type("the sequences must contain only numbers");
+        goto failure;
+    }
+    if (ns1->len != ns2->len) {
+        Nst_error_setc_value("the sequences must have the same length");
+        goto failure;
+    }
+
+    if (ns1->kind > kind)
+        kind = ns1->kind;
+    if (ns2->kind > kind)
+        kind = ns2->kind;
+    if (!widen_num_seq(ns1, kind) || !widen_num_seq(ns2, kind))
+        goto failure;
+    return true;
+
+failure:
+    free_num_seq(ns1);
+    free_num_seq(ns2);
+    return false;
+}
+
+static inline void neumaier_add(f64 *sum, f64 *comp, f64 val)
+{
+    f64 t = *sum + val;
+    if (fabs(*sum) >= fabs(val))
+        *comp += (*sum - t) + val;
+    else
+        *comp += (val - t) + *sum;
+    *sum = t;
+}
+
+// The kernels below keep four independent accumulators when working with
+// reals, since floating point additions cannot be reordered by the compiler
+// this is what allows the loops to be vectorized
+
+static f64 sum_reals(const f64 *values, usize len)
+{
+    f64 sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    f64 comps[4] = { 0.0, 0.0, 0.0, 0.0 };
+    usize i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        for (usize j = 0; j < 4; j++)
+            neumaier_add(&sums[j], &comps[j], values[i + j]);
+    }
+
+    f64 sum = 0.0;
+    f64 comp = 0.0;
+    for (; i < len; i++)
+        neumaier_add(&sum, &comp, values[i]);
+    for (usize j = 0; j < 4; j++) {
+        neumaier_add(&sum, &comp, sums[j]);
+        comp += comps[j];
+    }
+
+    // with infinities the compensation becomes NaN and must be ignored
+    if (!isfinite(sum))
+        return sum;
+    return sum + comp;
+}
+
+static i64 sum_ints(const i64 *values, usize len)
+{
+    // unsigned integers wrap around like the `+` operator does
+    u64 sum = 0;
+    for (usize i = 0; i < len; i++)
+        sum += (u64)values[i];
+    return (i64)sum;
+}
+
+static u8 sum_bytes(const u8 *values, usize len)
+{
+    u8 sum = 0;
+    for (usize i = 0; i < len; i++)
+        sum += values[i];
+    return sum;
+}
+
+static f64 dot_reals(const f64 *values1, const f64 *values2, usize len)
+{
+    f64 sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    usize i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        for (usize j = 0; j < 4; j++)
+            sums[j] += values1[i + j] * values2[i + j];
+    }
+
+    f64 sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    for (; i < len; i++)
+        sum += values1[i] * values2[i];
+    return sum;
+}
+
+static i64 dot_ints(const i64 *values1, const i64 *values2, usize len)
+{
+    u64 sum = 0;
+    for (usize i = 0; i < len; i++)
+        sum += (u64)values1[i] * (u64)values2[i];
+    return (i64)sum;
+}
+
+static f64 dist2_reals(const f64 *values1, const f64 *values2, usize len)
+{
+    f64 sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    usize i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        for (usize j = 0; j < 4; j++) {
+            f64 diff = values1[i + j] - values2[i + j];
+            sums[j] += diff * diff;
+        }
+    }
+
+    f64 sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    for (; i < len; i++) {
+        f64 diff = values1[i] - values2[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+template <typename T>
+static inline bool num_lt(T a, T b)
+{
+    return a < b;
+}
+
+static inline bool num_lt(f64 a, f64 b)
+{
+    return a < b && !(fabs(a - b) < REAL_EPSILON);
+}
+
+template <bool is_max, typename T>
+static usize arg_extreme(const T *values, usize len)
+{
+    usize idx = 0;
+    for (usize i = 1; i < len; i++) {
+        if (is_max ? num_lt(values[idx], values[i])
+                   : num_lt(values[i], values[idx]))
+        {
+            idx = i;
+        }
     }
+    return idx;
+}
 
-    Nst_Obj **objs1 = Nst_seq_objs(p1);
-    Nst_Obj **objs2 = Nst_seq_objs(p2);
+// Returns the index of the smallest or largest value of a sequence or -1 on
+// failure
+static i64 seq_arg_extreme(Nst_Obj *seq, bool is_max)
+{
+    NumSeq ns;
+    if (!load_num_seq(seq, 1, &ns))
+        return -1;
 
-    f64 tot = 0;
+    if (ns.len == 0) {
+        Nst_error_setc_value("sequence length is zero");
+        return -1;
+    }
 
-    for (usize i = 0, len = Nst_seq_len(p1); i < len; i++) {
-        f64 t1 = Nst_number_to_f64(objs1[i]);
-        f64 t2 = Nst_number_to_f64(objs2[i]);
+    usize idx = 0;
+    switch (ns.kind) {
+    case NUM_BYTE:
+        idx = is_max ? arg_extreme<true>((u8 *)ns.values, ns.len)
+                     : arg_extreme<false>((u8 *)ns.values, ns.len);
+        break;
+    case NUM_INT:
+        idx = is_max ? arg_extreme<true>((i64 *)ns.values, ns.len)
+                     : arg_extreme<false>((i64 *)ns.values, ns.len);
+        break;
+    case NUM_REAL:
+        idx = is_max ? arg_extreme<true>((f64 *)ns.values, ns.len)
+                     : arg_extreme<false>((f64 *)ns.values, ns.len);
+        break;
+    case NUM_OTHER:
+        for (usize i = 1; i < ns.len; i++) {
+            Nst_Obj *curr_obj = Nst_seq_getnf(seq, i);
+            Nst_Obj *extreme_obj = Nst_seq_getnf(seq, idx);
+            Nst_Obj *res = is_max
+                ? Nst_obj_gt(curr_obj, extreme_obj)
+                : Nst_obj_lt(curr_obj, extreme_obj);
+            if (res == nullptr)
+                return -1;
 
-        tot += (t1 - t2) * (t1 - t2);
+            if (res == Nst_true())
+                idx = i;
+            Nst_dec_ref(res);
+        }
+        break;
     }
 
+    free_num_seq(&ns);
+    return (i64)idx;
+}
+
+static Nst_Obj *seq_extreme(Nst_Obj *seq, bool is_max)
+{
+    i64 idx = seq_arg_extreme(seq, is_max);
+    if (idx < 0)
+        return nullptr;
+    if (Nst_is_typed_array(seq))
+        return Nst_typed_array_getf(seq, (usize)idx);
+    return Nst_inc_ref(Nst_seq_getnf(seq, (usize)idx));
+}
+
+Nst_Obj *NstC dist_nd_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *p1;
+    Nst_Obj *p2;
+
+    if (!Nst_extract_args("o o", arg_num, args, &p1, &p2))
+        return nullptr;
+
+    NumSeq ns1;
+    NumSeq ns2;
+    if (!load_num_seq_pair(p1, p2, &ns1, &ns2, NUM_REAL))
+        return nullptr;
+
+    f64 tot = dist2_reals((f64 *)ns1.values, (f64 *)ns2.values, ns1.len);
+    free_num_seq(&ns1);
+    free_num_seq(&ns2);
     return Nst_real_new(sqrt(tot));
 }
 
@@ -332,32 +702,10 @@ Nst_Obj *NstC min_(usize arg_num, Nst_Obj **args)
     if (!Nst_extract_args("o o", arg_num, args, &ob_a, &ob_b))
         return nullptr;
 
-    Nst_Obj *res;
-    if (ob_b == Nst_null() && (Nst_T(ob_a, Array) || Nst_T(ob_a, Vector))) {
-        usize seq_len = Nst_seq_len(ob_a);
-
-        if (seq_len == 0) {
-            Nst_error_setc_value("sequence length is zero");
-            return nullptr;
-        }
-
-        Nst_Obj *min_obj = Nst_seq_getnf(ob_a, 0);
-
-        for (usize i = 1; i < seq_len; i++) {
-            Nst_Obj *curr_obj = Nst_seq_getnf(ob_a, i);
-            res = Nst_obj_lt(curr_obj, min_obj);
-            if (res == nullptr)
-                return nullptr;
+    if (ob_b == Nst_null() && is_num_seq(ob_a))
+        return seq_extreme(ob_a, false);
 
-            if (res == Nst_true())
-                min_obj = curr_obj;
-            Nst_dec_ref(res);
-        }
-
-        return Nst_inc_ref(min_obj);
-    }
-
-    res = Nst_obj_lt(ob_b, ob_a);
+    Nst_Obj *res = Nst_obj_lt(ob_b, ob_a);
     if (res == nullptr)
         return nullptr;
 
@@ -376,32 +724,10 @@ Nst_Obj *NstC max_(usize arg_num, Nst_Obj **args)
     if (!Nst_extract_args("o o", arg_num, args, &ob_a, &ob_b))
         return nullptr;
 
-    Nst_Obj *res;
-    if (ob_b == Nst_null() && (Nst_T(ob_a, Array) || Nst_T(ob_a, Vector))) {
-        usize seq_len = Nst_seq_len(ob_a);
-
-        if (seq_len == 0) {
-            Nst_error_setc_value("sequence length is zero");
-            return nullptr;
-        }
+    if (ob_b == Nst_null() && is_num_seq(ob_a))
+        return seq_extreme(ob_a, true);
 
-        Nst_Obj *max_obj = Nst_seq_getnf(ob_a, 0);
-
-        for (usize i = 1; i < seq_len; i++) {
-            Nst_Obj *curr_obj = Nst_seq_getnf(ob_a, i);
-            res = Nst_obj_gt(curr_obj, max_obj);
-            if (res == nullptr)
-                return nullptr;
-
-            if (res == Nst_true())
-                max_obj = curr_obj;
-            Nst_dec_ref(res);
-        }
-
-        return Nst_inc_ref(max_obj);
-    }
-
-    res = Nst_obj_gt(ob_b, ob_a);
+    Nst_Obj *res = Nst_obj_gt(ob_b, ob_a);
     if (res == nullptr)
         return nullptr;
 
@@ -413,30 +739,265 @@ Nst_Obj *NstC max_(usize arg_num, Nst_Obj **args)
     return Nst_inc_ref(ob_a);
 }
 
+Nst_Obj *NstC argmin_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *seq;
+    if (!Nst_extract_args("o", arg_num, args, &seq))
+        return nullptr;
+
+    i64 idx = seq_arg_extreme(seq, false);
+    if (idx < 0)
+        return nullptr;
+    return Nst_int_new(idx);
+}
+
+Nst_Obj *NstC argmax_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *seq;
+    if (!Nst_extract_args("o", arg_num, args, &seq))
+        return nullptr;
+
+    i64 idx = seq_arg_extreme(seq, true);
+    if (idx < 0)
+        return nullptr;
+    return Nst_int_new(idx);
+}
+
 Nst_Obj *NstC sum_(usize arg_num, Nst_Obj **args)
 {
     Nst_Obj *seq;
 
-    if (!Nst_extract_args("A", arg_num, args, &seq))
+    if (!Nst_extract_args("o", arg_num, args, &seq))
         return nullptr;
 
-    if (Nst_seq_len(seq) == 0)
+    NumSeq ns;
+    if (!load_num_seq(seq, 1, &ns))
+        return nullptr;
+
+    if (ns.len == 0)
         return Nst_inc_ref(Nst_const()->Int_0);
 
-    Nst_Obj *tot = Nst_inc_ref(Nst_const()->Byte_0);
-    Nst_Obj *new_tot = nullptr;
+    Nst_Obj *tot = nullptr;
+    switch (ns.kind) {
+    case NUM_BYTE:
+        tot = Nst_byte_new(sum_bytes((u8 *)ns.values, ns.len));
+        break;
+    case NUM_INT:
+        tot = Nst_int_new(sum_ints((i64 *)ns.values, ns.len));
+        break;
+    case NUM_REAL:
+        tot = Nst_real_new(sum_reals((f64 *)ns.values, ns.len));
+        break;
+    case NUM_OTHER:
+        tot = Nst_inc_ref(Nst_const()->Byte_0);
+        for (usize i = 0, n = ns.len; i < n; i++) {
+            Nst_Obj *new_tot = Nst_obj_add(tot, Nst_seq_getnf(seq, i));
+            Nst_dec_ref(tot);
+
+            if (new_tot == nullptr)
+                return nullptr;
+            else
+                tot = new_tot;
+        }
+        break;
+    }
 
-    for (usize i = 0, n = Nst_seq_len(seq); i < n; i++) {
-        new_tot = Nst_obj_add(tot, Nst_seq_getnf(seq, i));
-        Nst_dec_ref(tot);
+    free_num_seq(&ns);
+    return tot;
+}
 
-        if (new_tot == nullptr)
-            return nullptr;
-        else
-            tot = new_tot;
+Nst_Obj *NstC dot_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *seq1;
+    Nst_Obj *seq2;
+
+    if (!Nst_extract_args("o o", arg_num, args, &seq1, &seq2))
+        return nullptr;
+
+    NumSeq ns1;
+    NumSeq ns2;
+    if (!load_num_seq_pair(seq1, seq2, &ns1, &ns2, NUM_INT))
+        return nullptr;
+
+    Nst_Obj *res;
+    if (ns1.kind == NUM_REAL) {
+        res = Nst_real_new(
+            dot_reals((f64 *)ns1.values, (f64 *)ns2.values, ns1.len));
+    } else {
+        res = Nst_int_new(
+            dot_ints((i64 *)ns1.values, (i64 *)ns2.values, ns1.len));
+    }
+    free_num_seq(&ns1);
+    free_num_seq(&ns2);
+    return res;
+}
+
+// Creates an `IntArray` or a `RealArray` applying an operation to the values
+// of two sequences, `op` is either '+' or '*'
+static Nst_Obj *seq_elem_op(Nst_Obj *seq1, Nst_Obj *seq2, char op)
+{
+    NumSeq ns1;
+    NumSeq ns2;
+    if (!load_num_seq_pair(seq1, seq2, &ns1, &ns2, NUM_INT))
+        return nullptr;
+
+    usize len = ns1.len;
+    Nst_Obj *res;
+    if (ns1.kind == NUM_REAL) {
+        res = Nst_real_array_new(len);
+        if (res == nullptr)
+            goto end;
+        f64 *out = Nst_real_array_values(res);
+        f64 *values1 = (f64 *)ns1.values;
+        f64 *values2 = (f64 *)ns2.values;
+        if (op == '+') {
+            for (usize i = 0; i < len; i++)
+                out[i] = values1[i] + values2[i];
+        } else {
+            for (usize i = 0; i < len; i++)
+                out[i] = values1[i] * values2[i];
+        }
+    } else {
+        res = Nst_int_array_new(len);
+        if (res == nullptr)
+            goto end;
+        i64 *out = Nst_int_array_values(res);
+        i64 *values1 = (i64 *)ns1.values;
+        i64 *values2 = (i64 *)ns2.values;
+        if (op == '+') {
+            for (usize i = 0; i < len; i++)
+                out[i] = (i64)((u64)values1[i] + (u64)values2[i]);
+        } else {
+            for (usize i = 0; i < len; i++)
+                out[i] = (i64)((u64)values1[i] * (u64)values2[i]);
+        }
     }
 
-    return tot;
+end:
+    free_num_seq(&ns1);
+    free_num_seq(&ns2);
+    return res;
+}
+
+Nst_Obj *NstC seq_add_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *seq1;
+    Nst_Obj *seq2;
+
+    if (!Nst_extract_args("o o", arg_num, args, &seq1, &seq2))
+        return nullptr;
+    return seq_elem_op(seq1, seq2, '+');
+}
+
+Nst_Obj *NstC seq_mul_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *seq1;
+    Nst_Obj *seq2;
+
+    if (!Nst_extract_args("o o", arg_num, args, &seq1, &seq2))
+        return nullptr;
+    return seq_elem_op(seq1, seq2, '*');
+}
+
+Nst_Obj *NstC seq_scale_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *seq;
+    Nst_Obj *factor;
+
+    if (!Nst_extract_args("o i|r|B", arg_num, args, &seq, &factor))
+        return nullptr;
+
+    NumSeq ns;
+    if (!load_num_seq(seq, 1, &ns))
+        return nullptr;
+
+    NumKind kind = Nst_T(factor, Real) ? NUM_REAL : NUM_INT;
+    if (ns.kind == NUM_OTHER) {
+        Nst_error_setc_type("the sequence must contain only numbers");
+        return nullptr;
+    }
+    if (!widen_num_seq(&ns, kind)) {
+        free_num_seq(&ns);
+        return nullptr;
+    }
+
+    usize len = ns.len;
+    Nst_Obj *res;
+    if (ns.kind == NUM_REAL) {
+        res = Nst_real_array_new(len);
+        if (res == nullptr)
+            goto end;
+        f64 *out = Nst_real_array_values(res);
+        f64 *values = (f64 *)ns.values;
+        f64 real_factor = Nst_number_to_f64(factor);
+        for (usize i = 0; i < len; i++)
+            out[i] = values[i] * real_factor;
+    } else {
+        res = Nst_int_array_new(len);
+        if (res == nullptr)
+            goto end;
+        i64 *out = Nst_int_array_values(res);
+        i64 *values = (i64 *)ns.values;
+        u64 int_factor = (u64)Nst_number_to_i64(factor);
+        for (usize i = 0; i < len; i++)
+            out[i] = (i64)((u64)values[i] * int_factor);
+    }
+
+end:
+    free_num_seq(&ns);
+    return res;
+}
+
+Nst_Obj *NstC prefix_sum_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *seq;
+
+    if (!Nst_extract_args("o", arg_num, args, &seq))
+        return nullptr;
+
+    NumSeq ns;
+    if (!load_num_seq(seq, 1, &ns))
+        return nullptr;
+
+    if (ns.kind == NUM_OTHER) {
+        Nst_error_setc_type("the sequence must contain only numbers");
+        return nullptr;
+    }
+    if (!widen_num_seq(&ns, NUM_INT)) {
+        free_num_seq(&ns);
+        return nullptr;
+    }
+
+    usize len = ns.len;
+    Nst_Obj *res;
+    if (ns.kind == NUM_REAL) {
+        res = Nst_real_array_new(len);
+        if (res == nullptr)
+            goto end;
+        f64 *out = Nst_real_array_values(res);
+        f64 *values = (f64 *)ns.values;
+        f64 sum = 0.0;
+        f64 comp = 0.0;
+        for (usize i = 0; i < len; i++) {
+            neumaier_add(&sum, &comp, values[i]);
+            out[i] = isfinite(sum) ? sum + comp : sum;
+        }
+    } else {
+        res = Nst_int_array_new(len);
+        if (res == nullptr)
+            goto end;
+        i64 *out = Nst_int_array_values(res);
+        i64 *values = (i64 *)ns.values;
+        u64 sum = 0;
+        for (usize i = 0; i < len; i++) {
+            sum += (u64)values[i];
+            out[i] = (i64)sum;
+        }
+    }
+
+end:
+    free_num_seq(&ns);
+    return res;
 }
 
 Nst_Obj *NstC frexp_(usize arg_num, Nst_Obj **args)
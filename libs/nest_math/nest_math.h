@@ -39,6 +39,13 @@ Nst_Obj *NstC rad_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC min_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC max_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC sum_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC argmin_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC argmax_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC dot_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC seq_add_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC seq_mul_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC seq_scale_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC prefix_sum_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC frexp_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC ldexp_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC map_(usize arg_num, Nst_Obj **args);
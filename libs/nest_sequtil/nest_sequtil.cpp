@@ -2,8 +2,7 @@
 #include <cstring>
 #include "nest_sequtil.h"
 #include "sequtil_i_functions.h"
-
-#define SORT_RUN_SIZE 32
+#include "sequtil_sort.h"
 
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
@@ -230,6 +229,110 @@ static isize clamp_slice_arguments(usize seq_len, Nst_Obj *start_obj,
     return new_size;
 }
 
+static Nst_Obj *typed_array_new(Nst_Obj *type, usize len)
+{
+    if (type == Nst_type()->IntArray)
+        return Nst_int_array_new(len);
+    else if (type == Nst_type()->RealArray)
+        return Nst_real_array_new(len);
+    return Nst_byte_array_new(len);
+}
+
+static Nst_Obj *slice_typed_array(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *arr;
+    Nst_Obj *start_obj;
+    Nst_Obj *stop_obj;
+    Nst_Obj *step_obj;
+
+    if (!Nst_extract_args(
+            "o ?i ?i ?i",
+            arg_num, args,
+            &arr, &start_obj, &stop_obj, &step_obj))
+    {
+        return nullptr;
+    }
+
+    i64 start, step;
+    isize new_size = clamp_slice_arguments(
+        Nst_typed_array_len(arr),
+        start_obj, stop_obj, step_obj,
+        start, step);
+
+    if (new_size == -1)
+        return nullptr;
+
+    Nst_Obj *new_arr = typed_array_new(arr->type, new_size);
+    if (new_arr == nullptr || new_size == 0)
+        return new_arr;
+
+    usize size = Nst_typed_array_elem_size(arr);
+    u8 *values = (u8 *)Nst_typed_array_values(arr);
+    u8 *new_values = (u8 *)Nst_typed_array_values(new_arr);
+
+    if (step == 1)
+        memcpy(new_values, values + start * size, new_size * size);
+    else {
+        for (isize i = 0; i < new_size; i++) {
+            memcpy(
+                new_values + i * size,
+                values + (i * step + start) * size,
+                size);
+        }
+    }
+    return new_arr;
+}
+
+static Nst_Obj *slice_str(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *str;
+    Nst_Obj *start_obj;
+    Nst_Obj *stop_obj;
+    Nst_Obj *step_obj;
+
+    if (!Nst_extract_args(
+            "s ?i ?i ?i",
+            arg_num, args,
+            &str, &start_obj, &stop_obj, &step_obj))
+    {
+        return nullptr;
+    }
+
+    i64 start, step;
+    isize new_size = clamp_slice_arguments(
+        Nst_str_char_len(str),
+        start_obj, stop_obj, step_obj,
+        start, step);
+
+    if (new_size == -1)
+        return nullptr;
+    else if (new_size == 0)
+        return Nst_str_new((u8 *)"", 0, false);
+    else if (step == 1)
+        return Nst_str_slice(str, (usize)start, (usize)(start + new_size));
+
+    // each character takes at most four bytes
+    u8 *buf = Nst_malloc_c(new_size * 4 + 1, u8);
+    if (buf == nullptr)
+        return nullptr;
+
+    usize len = 0;
+    for (isize i = 0; i < new_size; i++) {
+        i32 ch = Nst_str_get(str, i * step + start);
+        if (ch == -1) {
+            Nst_free(buf);
+            return nullptr;
+        }
+        len += Nst_ext_utf8_from_utf32((u32)ch, buf + len);
+    }
+    buf[len] = 0;
+
+    Nst_Obj *new_str = Nst_str_new_len(buf, len, new_size, true);
+    if (new_str == nullptr)
+        Nst_free(buf);
+    return new_str;
+}
+
 Nst_Obj *NstC slice_(usize arg_num, Nst_Obj **args)
 {
     Nst_Obj *seq;
@@ -237,6 +340,12 @@ Nst_Obj *NstC slice_(usize arg_num, Nst_Obj **args)
     Nst_Obj *stop_obj;
     Nst_Obj *step_obj;
 
+    // strings and typed arrays are sliced without being cast to an Array
+    if (arg_num > 0 && Nst_T(args[0], Str))
+        return slice_str(arg_num, args);
+    else if (arg_num > 0 && Nst_is_typed_array(args[0]))
+        return slice_typed_array(arg_num, args);
+
     if (!Nst_extract_args(
             "S ?i ?i ?i",
             arg_num, args,
@@ -350,13 +459,53 @@ Nst_Obj *NstC slice_i_(usize arg_num, Nst_Obj **args)
     }
 }
 
+static Nst_Obj *merge_typed_arrays(Nst_Obj *arr1, Nst_Obj *arr2)
+{
+    if (arr1->type != arr2->type) {
+        Nst_error_setf_type(
+            "cannot merge '%s' and '%s'",
+            Nst_type_name(arr1->type).value,
+            Nst_type_name(arr2->type).value);
+        return nullptr;
+    }
+
+    usize len1 = Nst_typed_array_len(arr1);
+    usize len2 = Nst_typed_array_len(arr2);
+    Nst_Obj *new_arr = typed_array_new(arr1->type, len1 + len2);
+    if (new_arr == nullptr)
+        return nullptr;
+
+    usize size = Nst_typed_array_elem_size(arr1);
+    u8 *new_values = (u8 *)Nst_typed_array_values(new_arr);
+    if (len1 != 0)
+        memcpy(new_values, Nst_typed_array_values(arr1), len1 * size);
+    if (len2 != 0) {
+        memcpy(
+            new_values + len1 * size,
+            Nst_typed_array_values(arr2),
+            len2 * size);
+    }
+    return new_arr;
+}
+
 Nst_Obj *NstC merge_(usize arg_num, Nst_Obj **args)
 {
     Nst_Obj *seq1;
     Nst_Obj *seq2;
 
-    if (!Nst_extract_args("A A", arg_num, args, &seq1, &seq2))
+    if (!Nst_extract_args(
+            "A|#|#|# A|#|#|#",
+            arg_num, args,
+            Nst_type()->IntArray, Nst_type()->RealArray,
+            Nst_type()->ByteArray, &seq1,
+            Nst_type()->IntArray, Nst_type()->RealArray,
+            Nst_type()->ByteArray, &seq2))
+    {
         return nullptr;
+    }
+
+    if (Nst_is_typed_array(seq1) || Nst_is_typed_array(seq2))
+        return merge_typed_arrays(seq1, seq2);
 
     Nst_Obj *new_seq;
     usize len1 = Nst_seq_len(seq1);
@@ -390,163 +539,6 @@ Nst_Obj *NstC extend_(usize arg_num, Nst_Obj **args)
     return Nst_inc_ref(vec);
 }
 
-typedef struct _MappedValue {
-    Nst_Obj *mapped;
-    Nst_Obj *original;
-} MappedValue;
-
-bool mapped_insertion_sort(MappedValue *values, isize left, isize right)
-{
-    for (isize i = left + 1; i < right; i++) {
-        MappedValue temp = values[i];
-        isize j = i - 1;
-
-        while (true) {
-            if (j < left)
-                break;
-
-            Nst_Obj *result = Nst_obj_gt(values[j].mapped, temp.mapped);
-            if (result == nullptr) {
-                return false;
-            }
-            bool c_result = Nst_obj_to_bool(result);
-            Nst_dec_ref(result);
-            if (!c_result)
-                break;
-            j--;
-        }
-        memmove(
-            values + j + 2,
-            values + j + 1,
-            sizeof(MappedValue) * (i - j -1));
-        values[j + 1] = temp;
-    }
-    return true;
-}
-
-bool insertion_sort(Nst_Obj **values, isize left, isize right)
-{
-    for (isize i = left + 1; i < right; i++) {
-        Nst_Obj *temp = values[i];
-        isize j = i - 1;
-
-        while (true) {
-            if (j < left)
-                break;
-
-            Nst_Obj *result = Nst_obj_gt(values[j], temp);
-            if (result == nullptr) {
-                return false;
-            }
-            bool c_result = Nst_obj_to_bool(result);
-            Nst_dec_ref(result);
-            if (!c_result)
-                break;
-            j--;
-        }
-        memmove(
-            values + j + 2,
-            values + j + 1,
-            sizeof(Nst_Obj *) * (i - j -1));
-        values[j + 1] = temp;
-    }
-    return true;
-}
-
-bool mapped_merge(MappedValue *values, usize left, usize mid, usize right,
-                  MappedValue *&buf, usize &buf_size)
-{
-    usize new_size = right - left;
-
-    if (new_size > buf_size) {
-        MappedValue *new_buf = Nst_realloc_c(buf, new_size, MappedValue, 0);
-        if (new_buf == nullptr) {
-            if (buf != nullptr)
-                Nst_free(buf);
-            return false;
-        }
-        buf = new_buf;
-        buf_size = new_size;
-    }
-
-    usize l_idx = left;
-    usize r_idx = mid;
-    usize idx = 0;
-
-    while (l_idx < mid && r_idx < right) {
-        Nst_Obj *result = Nst_obj_le(
-            values[l_idx].mapped,
-            values[r_idx].mapped);
-        if (result == nullptr) {
-            Nst_free(buf);
-            return false;
-        }
-        bool c_result = Nst_obj_to_bool(result);
-        Nst_dec_ref(result);
-
-        if (c_result)
-            buf[idx] = values[l_idx++];
-        else
-            buf[idx] = values[r_idx++];
-        idx++;
-    }
-
-    while (l_idx < mid)
-        buf[idx++] = values[l_idx++];
-
-    while (r_idx < right)
-        buf[idx++] = values[r_idx++];
-
-    memcpy(values + left, buf, new_size * sizeof(MappedValue));
-    return true;
-}
-
-bool merge(Nst_Obj **values, usize left, usize mid, usize right,
-           Nst_Obj **&buf, usize &buf_size)
-{
-    usize new_size = right - left;
-
-    if (new_size > buf_size) {
-        Nst_Obj **new_buf = Nst_realloc_c(buf, new_size, Nst_Obj *, 0);
-        if (new_buf == nullptr) {
-            if (buf != nullptr)
-                Nst_free(buf);
-            return false;
-        }
-        buf = new_buf;
-        buf_size = new_size;
-    }
-
-    usize l_idx = left;
-    usize r_idx = mid;
-    usize idx = 0;
-
-    while (l_idx < mid && r_idx < right) {
-        Nst_Obj *result = Nst_obj_le(values[l_idx], values[r_idx]);
-        if (result == nullptr) {
-            Nst_free(buf);
-            return false;
-        }
-        bool c_result = Nst_obj_to_bool(result);
-        Nst_dec_ref(result);
-
-        if (c_result)
-            buf[idx] = values[l_idx++];
-        else
-            buf[idx] = values[r_idx++];
-        idx++;
-    }
-
-    while (l_idx < mid)
-        buf[idx++] = values[l_idx++];
-
-    while (r_idx < right)
-        buf[idx++] = values[r_idx++];
-
-    memcpy(values + left, buf, new_size * sizeof(Nst_Obj *));
-    return true;
-}
-
 static Nst_Obj *mapped_sort(Nst_Obj *seq, Nst_Obj *map_func, bool new_seq)
 {
     if (Nst_func_arg_num(map_func) != 1) {
@@ -559,48 +551,30 @@ static Nst_Obj *mapped_sort(Nst_Obj *seq, Nst_Obj *map_func, bool new_seq)
 
     usize seq_len = Nst_seq_len(seq);
     Nst_Obj **objs = Nst_seq_objs(seq);
-    MappedValue *buf = nullptr;
-    usize buf_size = 0;
 
     MappedValue *values = Nst_malloc_c(seq_len, MappedValue);
-    if (values == nullptr)
+    if (values == nullptr) {
+        if (new_seq)
+            Nst_dec_ref(seq);
         return nullptr;
+    }
 
     for (usize i = 0; i < seq_len; i++) {
         Nst_Obj *mapped_value = Nst_func_call(map_func, 1, objs + i);
         if (mapped_value == nullptr) {
             for (usize j = 0; j < i; j++)
                 Nst_dec_ref(values[j].mapped);
+            Nst_free(values);
+            if (new_seq)
+                Nst_dec_ref(seq);
             return nullptr;
         }
         values[i].mapped = mapped_value;
         values[i].original = objs[i];
     }
 
-    for (usize i = 0; i < seq_len; i += SORT_RUN_SIZE) {
-        isize right = MIN(i + SORT_RUN_SIZE, seq_len);
-        if (!mapped_insertion_sort(values, i, right))
-            goto fail;
-    }
-
-    for (usize chunk_size = SORT_RUN_SIZE;
-         chunk_size < seq_len;
-         chunk_size *= 2)
-    {
-        for (usize left = 0; left < seq_len; left += 2 * chunk_size) {
-            usize mid = left + chunk_size;
-            usize right = MIN(left + 2*chunk_size, seq_len);
-
-            if (mid >= right)
-                continue;
-
-            if (!mapped_merge(values, left, mid, right, buf, buf_size))
-                goto fail; // buf is freed by mapped_merge
-        }
-    }
-
-    if (buf != nullptr)
-        Nst_free(buf);
+    if (!sort_mapped(values, seq_len))
+        goto fail;
 
     for (usize i = 0; i < seq_len; i++) {
         objs[i] = values[i].original;
@@ -637,42 +611,12 @@ Nst_Obj *NstC sort_(usize arg_num, Nst_Obj **args)
     if (new_seq)
         seq = Nst_seq_copy(seq);
 
-    usize seq_len = Nst_seq_len(seq);
-    Nst_Obj **objs = Nst_seq_objs(seq);
-    Nst_Obj **buf = nullptr;
-    usize buf_size = 0;
-
-    for (usize i = 0; i < seq_len; i += SORT_RUN_SIZE) {
-        isize right = MIN(i + SORT_RUN_SIZE, seq_len);
-        if (!insertion_sort(objs, i, right)) {
-            if (new_seq)
-                Nst_dec_ref(seq);
-            return nullptr;
-        }
-    }
-
-    for (usize chunk_size = SORT_RUN_SIZE;
-         chunk_size < seq_len;
-         chunk_size *= 2)
-    {
-        for (usize left = 0; left < seq_len; left += 2 * chunk_size) {
-            usize mid = left + chunk_size;
-            usize right = MIN(left + 2*chunk_size, seq_len);
-
-            if (mid >= right)
-                continue;
-
-            if (!merge(objs, left, mid, right, buf, buf_size)) {
-                if (new_seq)
-                    Nst_dec_ref(seq);
-                return nullptr; // buf is freed by merge
-            }
-        }
+    if (!sort_objs(Nst_seq_objs(seq), Nst_seq_len(seq))) {
+        if (new_seq)
+            Nst_dec_ref(seq);
+        return nullptr;
     }
 
-    if (buf != nullptr)
-        Nst_free(buf);
-
     return new_seq ? seq : Nst_inc_ref(seq);
 }
 
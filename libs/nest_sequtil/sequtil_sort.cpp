@@ -0,0 +1,414 @@
+#include <cmath>
+#include <cstring>
+#include "sequtil_sort.h"
+
+// runs shorter than this are extended with a binary insertion sort
+#define MIN_RUN 32
+// the lengths of the pending runs grow at least like the Fibonacci sequence,
+// 85 runs are enough for any array that fits in memory
+#define MAX_PENDING_RUNS 85
+// the same tolerance used by the `<` operator when comparing real numbers
+#define REAL_EPSILON 9.9e-15
+
+// Comparison kernels, `less` returns `1` when `a < b`, `0` when it is not and
+// `-1` if the comparison failed
+
+struct GenericLess {
+    static inline int less(Nst_Obj *a, Nst_Obj *b)
+    {
+        Nst_Obj *result = Nst_obj_lt(a, b);
+        if (result == nullptr)
+            return -1;
+        int is_less = result == Nst_true();
+        Nst_dec_ref(result);
+        return is_less;
+    }
+};
+
+struct IntLess {
+    static inline int less(Nst_Obj *a, Nst_Obj *b)
+    {
+        return Nst_int_i64(a) < Nst_int_i64(b);
+    }
+};
+
+struct RealLess {
+    static inline int less(Nst_Obj *a, Nst_Obj *b)
+    {
+        f64 v1 = Nst_real_f64(a);
+        f64 v2 = Nst_real_f64(b);
+        return v1 < v2 && !(std::fabs(v1 - v2) < REAL_EPSILON);
+    }
+};
+
+struct StrLess {
+    static inline int less(Nst_Obj *a, Nst_Obj *b)
+    {
+        usize len1 = Nst_str_len(a);
+        usize len2 = Nst_str_len(b);
+        int cmp = memcmp(
+            Nst_str_value(a),
+            Nst_str_value(b),
+            len1 < len2 ? len1 : len2);
+        return cmp < 0 || (cmp == 0 && len1 < len2);
+    }
+};
+
+static inline Nst_Obj *sort_key(Nst_Obj *obj)
+{
+    return obj;
+}
+
+static inline Nst_Obj *sort_key(const MappedValue &value)
+{
+    return value.mapped;
+}
+
+typedef struct _SortRun {
+    usize start;
+    usize len;
+} SortRun;
+
+template <typename T>
+struct SortState {
+    T *values;
+    T *buf;
+    usize buf_size;
+    SortRun runs[MAX_PENDING_RUNS];
+    usize n_runs;
+};
+
+template <typename T>
+static void reverse(T *values, usize lo, usize hi)
+{
+    for (hi--; lo < hi; lo++, hi--) {
+        T temp = values[lo];
+        values[lo] = values[hi];
+        values[hi] = temp;
+    }
+}
+
+// Returns the length of the run starting at `lo`, a strictly descending run is
+// reversed in place. Returns `0` on failure.
+template <typename T, typename Cmp>
+static usize count_run(T *values, usize lo, usize hi)
+{
+    usize i = lo + 1;
+    if (i == hi)
+        return 1;
+
+    int is_less = Cmp::less(sort_key(values[i]), sort_key(values[lo]));
+    if (is_less < 0)
+        return 0;
+
+    if (is_less) {
+        for (i++; i < hi; i++) {
+            is_less = Cmp::less(sort_key(values[i]), sort_key(values[i - 1]));
+            if (is_less < 0)
+                return 0;
+            if (!is_less)
+                break;
+        }
+        reverse(values, lo, i);
+    } else {
+        for (i++; i < hi; i++) {
+            is_less = Cmp::less(sort_key(values[i]), sort_key(values[i - 1]));
+            if (is_less < 0)
+                return 0;
+            if (is_less)
+                break;
+        }
+    }
+    return i - lo;
+}
+
+// Sorts `values[lo:hi]` knowing that `values[lo:start]` is already sorted
+template <typename T, typename Cmp>
+static bool binary_insertion_sort(T *values, usize lo, usize hi, usize start)
+{
+    for (; start < hi; start++) {
+        T pivot = values[start];
+        usize left = lo;
+        usize right = start;
+
+        // the pivot goes after the elements equal to it to keep the sort
+        // stable
+        while (left < right) {
+            usize mid = left + (right - left) / 2;
+            int is_less = Cmp::less(sort_key(pivot), sort_key(values[mid]));
+            if (is_less < 0)
+                return false;
+            if (is_less)
+                right = mid;
+            else
+                left = mid + 1;
+        }
+        memmove(values + left + 1, values + left, (start - left) * sizeof(T));
+        values[left] = pivot;
+    }
+    return true;
+}
+
+// Returns the index of the first element of `values[lo:hi]` greater than
+// `key` or `-1` on failure
+template <typename T, typename Cmp>
+static isize upper_bound(T *values, usize lo, usize hi, Nst_Obj *key)
+{
+    while (lo < hi) {
+        usize mid = lo + (hi - lo) / 2;
+        int is_less = Cmp::less(key, sort_key(values[mid]));
+        if (is_less < 0)
+            return -1;
+        if (is_less)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return (isize)lo;
+}
+
+// Returns the index of the first element of `values[lo:hi]` not less than
+// `key` or `-1` on failure
+template <typename T, typename Cmp>
+static isize lower_bound(T *values, usize lo, usize hi, Nst_Obj *key)
+{
+    while (lo < hi) {
+        usize mid = lo + (hi - lo) / 2;
+        int is_less = Cmp::less(sort_key(values[mid]), key);
+        if (is_less < 0)
+            return -1;
+        if (is_less)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (isize)lo;
+}
+
+template <typename T>
+static bool reserve_buf(SortState<T> *state, usize size)
+{
+    if (size <= state->buf_size)
+        return true;
+    T *new_buf = Nst_realloc_c(state->buf, size, T, 0);
+    if (new_buf == nullptr)
+        return false;
+    state->buf = new_buf;
+    state->buf_size = size;
+    return true;
+}
+
+// Merges `values[lo:mid]` and `values[mid:hi]` copying the left run, which is
+// the shorter one, to the buffer
+template <typename T, typename Cmp>
+static bool merge_lo(SortState<T> *state, usize lo, usize mid, usize hi)
+{
+    T *values = state->values;
+    usize left_len = mid - lo;
+    if (!reserve_buf(state, left_len))
+        return false;
+    T *buf = state->buf;
+    memcpy(buf, values + lo, left_len * sizeof(T));
+
+    usize l = 0, r = mid, dest = lo;
+    while (l < left_len && r < hi) {
+        int is_less = Cmp::less(sort_key(values[r]), sort_key(buf[l]));
+        if (is_less < 0) {
+            // the remaining objects of the left run fill the gap
+            memcpy(values + dest, buf + l, (left_len - l) * sizeof(T));
+            return false;
+        }
+        values[dest++] = is_less ? values[r++] : buf[l++];
+    }
+    memcpy(values + dest, buf + l, (left_len - l) * sizeof(T));
+    return true;
+}
+
+// Merges `values[lo:mid]` and `values[mid:hi]` copying the right run, which is
+// the shorter one, to the buffer and filling the array from the end
+template <typename T, typename Cmp>
+static bool merge_hi(SortState<T> *state, usize lo, usize mid, usize hi)
+{
+    T *values = state->values;
+    usize right_len = hi - mid;
+    if (!reserve_buf(state, right_len))
+        return false;
+    T *buf = state->buf;
+    memcpy(buf, values + mid, right_len * sizeof(T));
+
+    // the indices point one past the next element to take
+    usize l = mid, r = right_len, dest = hi;
+    while (l > lo && r > 0) {
+        int is_less = Cmp::less(sort_key(buf[r - 1]), sort_key(values[l - 1]));
+        if (is_less < 0) {
+            memcpy(values + dest - r, buf, r * sizeof(T));
+            return false;
+        }
+        values[--dest] = is_less ? values[--l] : buf[--r];
+    }
+    memcpy(values + dest - r, buf, r * sizeof(T));
+    return true;
+}
+
+// Merges the pending runs `i` and `i + 1`
+template <typename T, typename Cmp>
+static bool merge_at(SortState<T> *state, usize i)
+{
+    T *values = state->values;
+    usize lo = state->runs[i].start;
+    usize mid = lo + state->runs[i].len;
+    usize hi = mid + state->runs[i + 1].len;
+
+    state->runs[i].len = hi - lo;
+    if (i + 2 < state->n_runs)
+        state->runs[i + 1] = state->runs[i + 2];
+    state->n_runs--;
+
+    // the elements of the left run that are not greater than the first one of
+    // the right run and the elements of the right run not less than the last
+    // one of the left run are already in place
+    isize new_lo = upper_bound<T, Cmp>(values, lo, mid, sort_key(values[mid]));
+    if (new_lo < 0)
+        return false;
+    lo = (usize)new_lo;
+    if (lo == mid)
+        return true;
+
+    isize new_hi = lower_bound<T, Cmp>(
+        values, mid, hi,
+        sort_key(values[mid - 1]));
+    if (new_hi < 0)
+        return false;
+    hi = (usize)new_hi;
+
+    if (mid - lo <= hi - mid)
+        return merge_lo<T, Cmp>(state, lo, mid, hi);
+    return merge_hi<T, Cmp>(state, lo, mid, hi);
+}
+
+// Merges the pending runs until their lengths satisfy the invariants
+// runs[i - 2].len > runs[i - 1].len + runs[i].len and
+// runs[i - 1].len > runs[i].len
+template <typename T, typename Cmp>
+static bool merge_collapse(SortState<T> *state)
+{
+    SortRun *runs = state->runs;
+    while (state->n_runs > 1) {
+        usize n = state->n_runs - 2;
+        if ((n > 0 && runs[n - 1].len <= runs[n].len + runs[n + 1].len)
+            || (n > 1 && runs[n - 2].len <= runs[n - 1].len + runs[n].len))
+        {
+            if (runs[n - 1].len < runs[n + 1].len)
+                n--;
+        } else if (runs[n].len > runs[n + 1].len)
+            break;
+        if (!merge_at<T, Cmp>(state, n))
+            return false;
+    }
+    return true;
+}
+
+template <typename T, typename Cmp>
+static bool merge_force(SortState<T> *state)
+{
+    while (state->n_runs > 1) {
+        usize n = state->n_runs - 2;
+        if (n > 0 && state->runs[n - 1].len < state->runs[n + 1].len)
+            n--;
+        if (!merge_at<T, Cmp>(state, n))
+            return false;
+    }
+    return true;
+}
+
+// Computes the minimum length of a run so that the number of runs is a power
+// of two or slightly less
+static usize min_run_length(usize len)
+{
+    usize r = 0;
+    while (len >= MIN_RUN) {
+        r |= len & 1;
+        len >>= 1;
+    }
+    return len + r;
+}
+
+template <typename T, typename Cmp>
+static bool tim_sort(T *values, usize len)
+{
+    if (len < 2)
+        return true;
+
+    SortState<T> state;
+    state.values = values;
+    state.buf = nullptr;
+    state.buf_size = 0;
+    state.n_runs = 0;
+
+    bool result = true;
+    usize min_run = min_run_length(len);
+    for (usize lo = 0; lo < len && result;) {
+        usize run_len = count_run<T, Cmp>(values, lo, len);
+        if (run_len == 0) {
+            result = false;
+            break;
+        }
+
+        if (run_len < min_run) {
+            usize forced_len = len - lo < min_run ? len - lo : min_run;
+            if (!binary_insertion_sort<T, Cmp>(
+                    values,
+                    lo, lo + forced_len,
+                    lo + run_len))
+            {
+                result = false;
+                break;
+            }
+            run_len = forced_len;
+        }
+
+        state.runs[state.n_runs].start = lo;
+        state.runs[state.n_runs].len = run_len;
+        state.n_runs++;
+        result = merge_collapse<T, Cmp>(&state);
+        lo += run_len;
+    }
+
+    if (result)
+        result = merge_force<T, Cmp>(&state);
+    if (state.buf != nullptr)
+        Nst_free(state.buf);
+    return result;
+}
+
+template <typename T>
+static bool sort_dispatch(T *values, usize len)
+{
+    if (len == 0)
+        return true;
+
+    // the specialized kernels are used only when all keys have the same type
+    Nst_Obj *type = sort_key(values[0])->type;
+    for (usize i = 1; i < len && type != nullptr; i++) {
+        if (sort_key(values[i])->type != type)
+            type = nullptr;
+    }
+
+    if (type == Nst_type()->Int)
+        return tim_sort<T, IntLess>(values, len);
+    else if (type == Nst_type()->Real)
+        return tim_sort<T, RealLess>(values, len);
+    else if (type == Nst_type()->Str)
+        return tim_sort<T, StrLess>(values, len);
+    return tim_sort<T, GenericLess>(values, len);
+}
+
+bool sort_objs(Nst_Obj **objs, usize len)
+{
+    return sort_dispatch(objs, len);
+}
+
+bool sort_mapped(MappedValue *values, usize len)
+{
+    return sort_dispatch(values, len);
+}
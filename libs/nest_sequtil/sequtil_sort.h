@@ -0,0 +1,21 @@
+#ifndef SEQUTIL_SORT_H
+#define SEQUTIL_SORT_H
+
+#include "nest.h"
+
+typedef struct _MappedValue {
+    Nst_Obj *mapped;
+    Nst_Obj *original;
+} MappedValue;
+
+/**
+ * Sort `objs` in place with a stable adaptive merge sort. When all the objects
+ * are `Int`, `Real` or `Str` they are compared directly, otherwise
+ * `Nst_obj_lt` is used. On failure the error is set and `objs` contains the
+ * same objects in an unspecified order.
+ */
+bool sort_objs(Nst_Obj **objs, usize len);
+/* Like `sort_objs` but the values are ordered using their `mapped` field. */
+bool sort_mapped(MappedValue *values, usize len);
+
+#endif // !SEQUTIL_SORT_H
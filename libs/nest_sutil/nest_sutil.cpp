@@ -32,6 +32,7 @@ static Nst_Declr obj_list_[] = {
     Nst_FUNCDECLR(replace_, 3),
     Nst_FUNCDECLR(decode_, 2),
     Nst_FUNCDECLR(encode_, 2),
+    Nst_FUNCDECLR(encode_byte_array_, 2),
     Nst_FUNCDECLR(repr_, 1),
     Nst_FUNCDECLR(join_, 2),
     Nst_FUNCDECLR(lsplit_, 3),
@@ -280,20 +281,13 @@ Nst_Obj *NstC ltrim_(usize arg_num, Nst_Obj **args)
         return nullptr;
 
     u8 *s_start = Nst_str_value(str);
-    usize len = Nst_str_len(str);
+    usize spaces = 0;
 
-    while (isspace((u8)*s_start)) {
-        s_start++;
-        --len;
-    }
+    while (isspace((u8)s_start[spaces]))
+        spaces++;
 
-    u8 *new_str = Nst_malloc_c(len + 1, u8);
-    if (new_str == nullptr)
-        return nullptr;
-    memcpy(new_str, s_start, len);
-    new_str[len] = '\0';
-
-    return Nst_str_new(new_str, len, true);
+    // the spaces are all ASCII characters
+    return Nst_str_slice(str, spaces, Nst_str_char_len(str));
 }
 
 Nst_Obj *NstC rtrim_(usize arg_num, Nst_Obj **args)
@@ -912,8 +906,13 @@ Nst_Obj *NstC decode_(usize arg_num, Nst_Obj **args)
     Nst_Obj *seq;
     Nst_Obj *encoding_obj;
 
-    if (!Nst_extract_args("A.B ?s", arg_num, args, &seq, &encoding_obj))
+    if (!Nst_extract_args(
+            "A|#.B ?s",
+            arg_num, args,
+            Nst_type()->ByteArray, &seq, &encoding_obj))
+    {
         return nullptr;
+    }
 
     Nst_EncodingID cpid = Nst_DEF_VAL(
         encoding_obj,
@@ -930,39 +929,44 @@ Nst_Obj *NstC decode_(usize arg_num, Nst_Obj **args)
 
     Nst_Encoding *encoding = Nst_encoding(cpid);
 
-    usize len = Nst_seq_len(seq);
-    u8 *byte_array = Nst_malloc_c(len + 1, u8);
-    if (byte_array == nullptr)
-        return nullptr;
-    Nst_Obj **objs = Nst_seq_objs(seq);
+    u8 *str;
+    usize str_len;
+    bool result;
+
+    // the values of a ByteArray can be translated without copying them
+    if (Nst_T(seq, ByteArray)) {
+        result = Nst_encoding_translate(
+            encoding, Nst_encoding(Nst_EID_EXT_UTF8),
+            Nst_byte_array_values(seq), Nst_typed_array_len(seq),
+            (void **)&str, &str_len);
+    } else {
+        usize len = Nst_seq_len(seq);
+        u8 *byte_array = Nst_malloc_c(len + 1, u8);
+        if (byte_array == nullptr)
+            return nullptr;
+        Nst_Obj **objs = Nst_seq_objs(seq);
 
-    for (usize i = 0; i < len; i++)
-        byte_array[i] = Nst_byte_u8(objs[i]);
+        for (usize i = 0; i < len; i++)
+            byte_array[i] = Nst_byte_u8(objs[i]);
 
-    byte_array[len] = 0;
+        byte_array[len] = 0;
 
-    u8 *str;
-    usize str_len;
-    bool result = Nst_encoding_translate(
-        encoding, Nst_encoding(Nst_EID_EXT_UTF8),
-        byte_array, len,
-        (void **)&str, &str_len);
+        result = Nst_encoding_translate(
+            encoding, Nst_encoding(Nst_EID_EXT_UTF8),
+            byte_array, len,
+            (void **)&str, &str_len);
+        Nst_free(byte_array);
+    }
 
-    Nst_free(byte_array);
     if (!result)
         return nullptr;
 
     return Nst_str_new(str, str_len, true);
 }
 
-Nst_Obj *NstC encode_(usize arg_num, Nst_Obj **args)
+static bool encode_str(Nst_Obj *str, Nst_Obj *encoding_obj, u8 **bytes,
+                       usize *bytes_len)
 {
-    Nst_Obj *str;
-    Nst_Obj *encoding_obj;
-
-    if (!Nst_extract_args("s ?s", arg_num, args, &str, &encoding_obj))
-        return nullptr;
-
     Nst_EncodingID cpid = Nst_DEF_VAL(
         encoding_obj,
         Nst_encoding_from_name((char *)Nst_str_value(encoding_obj)),
@@ -972,20 +976,29 @@ Nst_Obj *NstC encode_(usize arg_num, Nst_Obj **args)
             Nst_sprintf(
                 "invalid encoding '%.100s'",
                 Nst_str_value(encoding_obj)));
-        return nullptr;
+        return false;
     }
     cpid = Nst_encoding_to_single_byte(cpid);
 
     Nst_Encoding *encoding = Nst_encoding(cpid);
 
-    u8 *byte_array;
-    usize array_len;
-    bool result = Nst_encoding_translate(
+    return Nst_encoding_translate(
         Nst_encoding(Nst_EID_EXT_UTF8), encoding,
         Nst_str_value(str), Nst_str_len(str),
-        (void **)&byte_array, &array_len);
+        (void **)bytes, bytes_len);
+}
 
-    if (!result)
+Nst_Obj *NstC encode_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *str;
+    Nst_Obj *encoding_obj;
+
+    if (!Nst_extract_args("s ?s", arg_num, args, &str, &encoding_obj))
+        return nullptr;
+
+    u8 *byte_array;
+    usize array_len;
+    if (!encode_str(str, encoding_obj, &byte_array, &array_len))
         return nullptr;
 
     Nst_Obj *new_arr = Nst_array_new(array_len);
@@ -997,6 +1010,22 @@ Nst_Obj *NstC encode_(usize arg_num, Nst_Obj **args)
     return new_arr;
 }
 
+Nst_Obj *NstC encode_byte_array_(usize arg_num, Nst_Obj **args)
+{
+    Nst_Obj *str;
+    Nst_Obj *encoding_obj;
+
+    if (!Nst_extract_args("s ?s", arg_num, args, &str, &encoding_obj))
+        return nullptr;
+
+    u8 *byte_array;
+    usize array_len;
+    if (!encode_str(str, encoding_obj, &byte_array, &array_len))
+        return nullptr;
+
+    return Nst_byte_array_from_buf(byte_array, array_len);
+}
+
 Nst_Obj *NstC repr_(usize arg_num, Nst_Obj **args)
 {
     Nst_Obj *obj;
@@ -1512,11 +1541,10 @@ Nst_Obj *NstC lremove_(usize arg_num, Nst_Obj **args)
             return Nst_inc_ref(str);
     }
 
-    usize new_len = Nst_str_len(str) - Nst_str_len(substr);
-    u8 *new_str_value = (u8 *)Nst_calloc(1, new_len + 1, str_p);
-    if (new_str_value == NULL)
-        return NULL;
-    return Nst_str_new_allocated(new_str_value, new_len);
+    return Nst_str_slice(
+        str,
+        Nst_str_char_len(substr),
+        Nst_str_char_len(str));
 }
 
 Nst_Obj *NstC rremove_(usize arg_num, Nst_Obj **args)
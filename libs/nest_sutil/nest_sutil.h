@@ -37,6 +37,7 @@ Nst_Obj *NstC is_ascii_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC replace_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC decode_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC encode_(usize arg_num, Nst_Obj **args);
+Nst_Obj *NstC encode_byte_array_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC repr_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC join_(usize arg_num, Nst_Obj **args);
 Nst_Obj *NstC lsplit_(usize arg_num, Nst_Obj **args);
@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include <string.h>
 #include "nest.h"
 
@@ -27,9 +28,24 @@
     "  -i --instructions     prints the instructions of the program\n"                   \
     "  -b --bytecode         prints the bytecode of the program\n"                       \
     "  -f --force-execution  executes the program even when -t, -a or -b are used\n"     \
+    "  --op-pairs            prints the pairs and triplets of instructions executed\n"   \
+    "                        most often when the program ends\n"                         \
     "  -D --no-default       does not set or optimize default variables such as\n"       \
     "                        'true' or 'Int'; this does not affect the optimization\n"   \
-    "                        on imported modules\n\n"                                    \
+    "                        on imported modules\n"                                      \
+    "  --no-tail-calls       calls in tail position create a new frame instead of\n"     \
+    "                        replacing the current one, errors show all the calls\n"     \
+    "                        in the traceback\n"                                         \
+    "  --profile             samples the program while it runs and writes the call\n"    \
+    "                        stacks in 'profile.folded' or in the file given in the\n"   \
+    "                        form --profile=file, the lines that were sampled most\n"    \
+    "                        often are printed when the program ends\n"                  \
+    "  --gc-stats            prints a histogram of the pauses of the garbage\n"          \
+    "                        collector when the program ends\n"                          \
+    "  --gc-step             in the form --gc-step=n, the garbage collector visits\n"    \
+    "                        at most n objects and references of the old\n"              \
+    "                        generation each time it runs, 0 collects the whole\n"       \
+    "                        generation at once\n\n"                                     \
                                                                                          \
     "  -O0                   do not optimize the program\n"                              \
     "  -O1                   optimize only expressions with known values\n"              \
@@ -83,9 +99,14 @@ void Nst_cl_args_init(Nst_CLArgs *args, int argc, char **argv)
     args->print_ast = false;
     args->print_instructions = false;
     args->print_bytecode = false;
+    args->print_op_pairs = false;
     args->force_execution = false;
     args->encoding = Nst_EID_UNKNOWN;
     args->no_default = false;
+    args->no_tail_calls = false;
+    args->profile_path = NULL;
+    args->print_gc_stats = false;
+    args->gc_step = _Nst_OLD_GEN_STEP;
     args->opt_level = 3;
     args->command = NULL;
     args->filename = NULL;
@@ -102,13 +123,36 @@ static i32 long_arg(char *arg, Nst_CLArgs *cl_args)
         cl_args->print_instructions = true;
     else if (strcmp(arg, "--bytecode") == 0)
         cl_args->print_bytecode = true;
+    else if (strcmp(arg, "--op-pairs") == 0)
+        cl_args->print_op_pairs = true;
     else if (strcmp(arg, "--force-execution") == 0)
         cl_args->force_execution = true;
     else if (strcmp(arg, "--monochrome") == 0)
         supports_color = false;
     else if (strcmp(arg, "--no-default") == 0)
         cl_args->no_default = true;
-    else if (strcmp(arg, "--help") == 0) {
+    else if (strcmp(arg, "--no-tail-calls") == 0)
+        cl_args->no_tail_calls = true;
+    else if (strcmp(arg, "--profile") == 0)
+        cl_args->profile_path = "profile.folded";
+    else if (strncmp(arg, "--profile=", 10) == 0) {
+        if (arg[10] == '\0') {
+            Nst_printf("Invalid usage of the option: --profile\n");
+            Nst_printf("\n" USAGE_MESSAGE);
+            return -1;
+        }
+        cl_args->profile_path = arg + 10;
+    } else if (strcmp(arg, "--gc-stats") == 0)
+        cl_args->print_gc_stats = true;
+    else if (strncmp(arg, "--gc-step=", 10) == 0) {
+        char *end;
+        cl_args->gc_step = (usize)strtoull(arg + 10, &end, 10);
+        if (arg[10] < '0' || arg[10] > '9' || *end != '\0') {
+            Nst_printf("Invalid usage of the option: --gc-step\n");
+            Nst_printf("\n" USAGE_MESSAGE);
+            return -1;
+        }
+    } else if (strcmp(arg, "--help") == 0) {
         Nst_printf(HELP_MESSAGE);
         return 1;
     } else if (strcmp(arg, "--version") == 0) {
@@ -1,6 +1,19 @@
+#include <string.h>
 #include "nest.h"
 
-#define JOIN_OP(code, arg) ((((u8)(code)) << 8) | (u8)(arg))
+#define JOIN_OP(code, arg)                                                    \
+    ((((u32)(u8)(code)) << 24) | ((u32)(arg) & Nst_OP_ARG_MAX))
+
+#ifdef Nst_MSVC
+#define ALIGN_OF(type) __alignof(type)
+#else
+#define ALIGN_OF(type) _Alignof(type)
+#endif
+
+// Rounds `offset` up to the alignment required by `type`
+#define ALIGN_UP(offset, type)                                                \
+    (((offset) + ALIGN_OF(type) - 1) & ~(usize)(ALIGN_OF(type) - 1))
+#define IS_ALIGNED(ptr, type) (((usize)(ptr) & (ALIGN_OF(type) - 1)) == 0)
 
 typedef struct {
     usize jump_offset;
@@ -8,22 +21,90 @@ typedef struct {
     u8 arg_ext;
 } JumpRemap;
 
-static Nst_Bytecode *bc_new(usize len, usize obj_len);
+static Nst_Bytecode *bc_new(usize len, usize obj_len, usize handler_len);
 static u8 val_size(usize val);
 static usize calc_jump_remaps(JumpRemap *remaps, Nst_InstList *ls);
+static isize stack_effect(Nst_Inst *inst);
+static void calc_stack_depths(Nst_InstList *ls, isize *depths);
+static bool build_handlers(Nst_InstList *ls, JumpRemap *remaps, usize bc_len,
+                           Nst_DynArray *handlers);
+static bool flush_handlers(Nst_DynArray *handlers, Nst_ExceptionEntry *open,
+                           usize *open_len, usize *cursor, usize up_to);
 static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
                             JumpRemap *remap);
 static usize add_op(Nst_OpCode op, usize arg, Nst_Span span, Nst_Bytecode *bc,
                     usize op_i);
 static bool assemble_func(Nst_FuncPrototype *func, Nst_Bytecode *bc);
-
-static Nst_Bytecode *bc_new(usize len, usize obj_len)
+static Nst_Obj *func_outer_names(Nst_FuncPrototype *func, bool *capture_all);
+static bool collect_names(Nst_InstList *ls, Nst_Obj *names, bool *capture_all);
+
+static const char *op_names[] = {
+    [Nst_OP_POP_VAL]              = "pop",
+    [Nst_OP_FOR_START]            = "istart",
+    [Nst_OP_FOR_NEXT]             = "inext",
+    [Nst_OP_RETURN_VAL]           = "ret",
+    [Nst_OP_RETURN_VARS]          = "retvar",
+    [Nst_OP_SET_VAL_LOC]          = "setpop",
+    [Nst_OP_SET_CONT_LOC]         = "setcpop",
+    [Nst_OP_THROW_ERR]            = "throw",
+    [Nst_OP_SET_VAL]              = "set",
+    [Nst_OP_GET_VAL]              = "get",
+    [Nst_OP_PUSH_VAL]             = "push",
+    [Nst_OP_SET_CONT_VAL]         = "setc",
+    [Nst_OP_CALL]                 = "call",
+    [Nst_OP_TAIL_CALL]            = "tcall",
+    [Nst_OP_SEQ_CALL]             = "callseq",
+    [Nst_OP_CAST]                 = "cast",
+    [Nst_OP_RANGE]                = "range",
+    [Nst_OP_STACK]                = "binop",
+    [Nst_OP_LOCAL]                = "uniop",
+    [Nst_OP_IMPORT]               = "import",
+    [Nst_OP_EXTRACT]              = "extract",
+    [Nst_OP_DEC_INT]              = "dec",
+    [Nst_OP_NEW_INT]              = "dupint",
+    [Nst_OP_DUP]                  = "dup",
+    [Nst_OP_ROT_2]                = "rot2",
+    [Nst_OP_ROT_3]                = "rot3",
+    [Nst_OP_MAKE_ARR]             = "mkarr",
+    [Nst_OP_MAKE_ARR_REP]         = "fillarr",
+    [Nst_OP_MAKE_VEC]             = "mkvec",
+    [Nst_OP_MAKE_VEC_REP]         = "fillvec",
+    [Nst_OP_MAKE_MAP]             = "mkmap",
+    [Nst_OP_MAKE_FUNC]            = "mkfunc",
+    [Nst_OP_SAVE_ERROR]           = "geterr",
+    [Nst_OP_UNPACK_SEQ]           = "unpack",
+    [Nst_OP_PUSH_STACK_OP]        = "pushop",
+    [Nst_OP_GET_STACK_OP]         = "getop",
+    [Nst_OP_EXTEND_ARG]           = "extend",
+    [Nst_OP_JUMP]                 = "jmp",
+    [Nst_OP_JUMPIF_T]             = "jmptrue",
+    [Nst_OP_JUMPIF_F]             = "jmpflse",
+    [Nst_OP_JUMPIF_ZERO]          = "jmpzero",
+    [Nst_OP_JUMPIF_IEND]          = "jmpiend",
+    [Nst_OP_EXTRACT_SEQ_INT]      = "seqget",
+    [Nst_OP_EXTRACT_MAP]          = "mapget",
+    [Nst_OP_EXTRACT_STR_INT]      = "strget",
+    [Nst_OP_SET_CONT_SEQ_INT]     = "seqset",
+    [Nst_OP_SET_CONT_MAP]         = "mapset",
+    [Nst_OP_SET_CONT_LOC_SEQ_INT] = "seqsetp",
+    [Nst_OP_SET_CONT_LOC_MAP]     = "mapsetp",
+};
+
+static Nst_Bytecode *bc_new(usize len, usize obj_len, usize handler_len)
 {
-    usize tot_size = sizeof(Nst_Bytecode)
-                   + len * sizeof(Nst_Op)
-                   + len * sizeof(Nst_Span)
-                   + obj_len * sizeof(Nst_Obj *);
-    void *block = Nst_calloc(1, tot_size, NULL);
+    // the arrays follow the header in the same block, each one starts at an
+    // offset aligned for its elements
+    usize ops_offset = ALIGN_UP(sizeof(Nst_Bytecode), Nst_Op);
+    usize pos_offset = ALIGN_UP(ops_offset + len * sizeof(Nst_Op), Nst_Span);
+    usize obj_offset = ALIGN_UP(
+        pos_offset + len * sizeof(Nst_Span),
+        Nst_Obj *);
+    usize handlers_offset = ALIGN_UP(
+        obj_offset + obj_len * sizeof(Nst_Obj *),
+        Nst_ExceptionEntry);
+    usize tot_size = handlers_offset
+                   + handler_len * sizeof(Nst_ExceptionEntry);
+    u8 *block = Nst_calloc(1, tot_size, NULL);
     if (block == NULL)
         return NULL;
 
@@ -31,9 +112,15 @@ static Nst_Bytecode *bc_new(usize len, usize obj_len)
     bc->copy_count = 0;
     bc->len = len;
     bc->obj_len = obj_len;
-    bc->bytecode = (Nst_Op *)(bc + 1);
-    bc->positions = (Nst_Span *)(bc->bytecode + len);
-    bc->objects = (Nst_Obj **)(bc->positions + len);
+    bc->bytecode = (Nst_Op *)(block + ops_offset);
+    bc->positions = (Nst_Span *)(block + pos_offset);
+    bc->objects = (Nst_Obj **)(block + obj_offset);
+    bc->handler_len = handler_len;
+    bc->handlers = (Nst_ExceptionEntry *)(block + handlers_offset);
+
+    Nst_assert(IS_ALIGNED(bc->positions, Nst_Span));
+    Nst_assert(IS_ALIGNED(bc->objects, Nst_Obj *));
+    Nst_assert(IS_ALIGNED(bc->handlers, Nst_ExceptionEntry));
 
     return bc;
 }
@@ -53,14 +140,36 @@ Nst_Bytecode *Nst_assemble(Nst_InstList *ls)
 
     usize bc_len = calc_jump_remaps(remap, ls);
 
-    Nst_Bytecode *bc = bc_new(bc_len, ls->objects.len + ls->functions.len);
+    Nst_DynArray handlers;
+    if (!Nst_da_init(&handlers, sizeof(Nst_ExceptionEntry), 0)) {
+        Nst_free(remap);
+        return NULL;
+    }
+    if (!build_handlers(ls, remap, bc_len, &handlers)) {
+        Nst_da_clear(&handlers, NULL);
+        Nst_free(remap);
+        return NULL;
+    }
+
+    Nst_Bytecode *bc = bc_new(
+        bc_len,
+        ls->objects.len + ls->functions.len,
+        handlers.len);
     if (bc == NULL) {
+        Nst_da_clear(&handlers, NULL);
         Nst_free(remap);
         return NULL;
     }
 
     translate_ilist(bc, ls, remap);
     Nst_free(remap);
+    if (handlers.len != 0) {
+        memcpy(
+            bc->handlers,
+            handlers.data,
+            handlers.len * sizeof(Nst_ExceptionEntry));
+    }
+    Nst_da_clear(&handlers, NULL);
 
     bc->obj_len = ls->objects.len;
     for (usize i = 0, n = ls->objects.len; i < n; i++)
@@ -78,7 +187,7 @@ Nst_Bytecode *Nst_assemble(Nst_InstList *ls)
 
 static u8 val_size(usize val)
 {
-    return (val > 0xffffff) + (val > 0xffff) + (val > 0xff);
+    return val > Nst_OP_ARG_MAX;
 }
 
 // populate remaps & calculate the final op count
@@ -92,7 +201,8 @@ static usize calc_jump_remaps(JumpRemap *remaps, Nst_InstList *ls)
     for (usize i = 0; i < ls_len; i++) {
         Nst_Inst *inst = Nst_ilist_get_inst(ls, i);
         remaps[i].jump_offset = bc_len - i;
-        if (inst->code == Nst_IC_NO_OP)
+        // the start of a `try` block is recorded only in the exception table
+        if (inst->code == Nst_IC_NO_OP || inst->code == Nst_IC_PUSH_CATCH)
             continue;
         if (Nst_ic_is_jump(inst->code))
             bc_len += 1;
@@ -112,6 +222,8 @@ static usize calc_jump_remaps(JumpRemap *remaps, Nst_InstList *ls)
                 continue;
             usize dst = (usize)inst->val + remaps[inst->val].jump_offset;
             remaps[i].jump_dst = dst;
+            if (inst->code == Nst_IC_PUSH_CATCH)
+                continue;
             // give up if a jump needs more OP_ARG_EXTEND
             if (val_size(dst) > remaps[i].arg_ext) {
                 expand_idx = i;
@@ -136,6 +248,176 @@ static usize calc_jump_remaps(JumpRemap *remaps, Nst_InstList *ls)
     return bc_len;
 }
 
+// The number of values that an instruction adds to the value stack, for
+// conditional jumps it is the effect when the jump is not taken
+static isize stack_effect(Nst_Inst *inst)
+{
+    switch (inst->code) {
+    case Nst_IC_FOR_START:
+    case Nst_IC_FOR_NEXT:
+    case Nst_IC_GET_VAL:
+    case Nst_IC_PUSH_VAL:
+    case Nst_IC_DUP:
+    case Nst_IC_MAKE_FUNC:
+    case Nst_IC_SAVE_ERROR:
+        return 1;
+    case Nst_IC_POP_VAL:
+    case Nst_IC_SET_VAL_LOC:
+    case Nst_IC_OP_SEQ_CALL:
+    case Nst_IC_OP_CAST:
+    case Nst_IC_STACK_OP:
+    case Nst_IC_OP_EXTRACT:
+    case Nst_IC_MAKE_ARR_REP:
+    case Nst_IC_MAKE_VEC_REP:
+    case Nst_IC_JUMPIF_T:
+    case Nst_IC_JUMPIF_F:
+        return -1;
+    case Nst_IC_THROW_ERR:
+    case Nst_IC_SET_CONT_VAL:
+        return -2;
+    case Nst_IC_SET_CONT_LOC:
+        return -3;
+    case Nst_IC_OP_CALL:
+    case Nst_IC_OP_TAIL_CALL:
+        return -(isize)inst->val;
+    case Nst_IC_OP_RANGE:
+    case Nst_IC_MAKE_ARR:
+    case Nst_IC_MAKE_VEC:
+        return 1 - (isize)inst->val;
+    case Nst_IC_MAKE_MAP:
+        return 1 - (isize)inst->val * 2;
+    case Nst_IC_UNPACK_SEQ:
+        return (isize)inst->val - 1;
+    default:
+        return 0;
+    }
+}
+
+// Computes the number of values of the function on the value stack before
+// each instruction is executed, unreachable instructions are set to `-1`
+static void calc_stack_depths(Nst_InstList *ls, isize *depths)
+{
+    usize ls_len = Nst_ilist_len(ls);
+    for (usize i = 0; i < ls_len; i++)
+        depths[i] = -1;
+    depths[0] = 0;
+
+    // the depths are propagated along the jumps until all the reachable
+    // instructions have one, more passes are needed only for backward jumps
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (usize i = 0; i < ls_len; i++) {
+            if (depths[i] < 0)
+                continue;
+            Nst_Inst *inst = Nst_ilist_get_inst(ls, i);
+            isize depth = depths[i] + stack_effect(inst);
+
+            if (Nst_ic_is_jump(inst->code) && (usize)inst->val < ls_len) {
+                // the value is popped only when the iterator ends
+                isize jump_depth = inst->code == Nst_IC_JUMPIF_IEND
+                                 ? depth - 1
+                                 : depth;
+                if (depths[inst->val] < 0) {
+                    depths[inst->val] = jump_depth;
+                    changed = changed || (usize)inst->val < i;
+                }
+            }
+
+            if (inst->code == Nst_IC_JUMP
+                || inst->code == Nst_IC_RETURN_VAL
+                || inst->code == Nst_IC_RETURN_VARS
+                || inst->code == Nst_IC_THROW_ERR)
+            {
+                continue;
+            }
+            if (i + 1 < ls_len && depths[i + 1] < 0)
+                depths[i + 1] = depth;
+        }
+    }
+}
+
+// Builds the exception table from the `Nst_IC_PUSH_CATCH` instructions. Each
+// of them covers the instructions up to the start of its `catch` block, the
+// ranges of nested blocks are split so that the entries do not overlap.
+static bool build_handlers(Nst_InstList *ls, JumpRemap *remaps, usize bc_len,
+                           Nst_DynArray *handlers)
+{
+    usize ls_len = Nst_ilist_len(ls);
+    usize try_count = 0;
+    for (usize i = 0; i < ls_len; i++) {
+        if (Nst_ilist_get_inst(ls, i)->code == Nst_IC_PUSH_CATCH)
+            try_count++;
+    }
+    if (try_count == 0)
+        return true;
+
+    isize *depths = Nst_malloc_c(ls_len, isize);
+    if (depths == NULL)
+        return false;
+    Nst_ExceptionEntry *open = Nst_malloc_c(try_count, Nst_ExceptionEntry);
+    if (open == NULL) {
+        Nst_free(depths);
+        return false;
+    }
+    calc_stack_depths(ls, depths);
+
+    bool result = true;
+    usize open_len = 0;
+    usize cursor = 0;
+    for (usize i = 0; i < ls_len && result; i++) {
+        // a `try` block that cannot be reached has no entry
+        if (Nst_ilist_get_inst(ls, i)->code != Nst_IC_PUSH_CATCH
+            || depths[i] < 0)
+        {
+            continue;
+        }
+
+        Nst_ExceptionEntry entry = {
+            .start = i + remaps[i].jump_offset,
+            .end = remaps[i].jump_dst,
+            .handler = remaps[i].jump_dst,
+            .stack_depth = (usize)depths[i]
+        };
+        result = flush_handlers(
+            handlers,
+            open, &open_len,
+            &cursor, entry.start);
+        open[open_len++] = entry;
+        cursor = entry.start;
+    }
+    if (result)
+        result = flush_handlers(handlers, open, &open_len, &cursor, bc_len);
+
+    Nst_free(open);
+    Nst_free(depths);
+    return result;
+}
+
+// Adds to `handlers` the parts of the open `try` blocks before `up_to` that
+// are not covered by a nested block and closes the ones that end before it,
+// `cursor` is the start of the part of the innermost block not yet added
+static bool flush_handlers(Nst_DynArray *handlers, Nst_ExceptionEntry *open,
+                           usize *open_len, usize *cursor, usize up_to)
+{
+    while (*open_len > 0) {
+        Nst_ExceptionEntry *top = &open[*open_len - 1];
+        usize end = top->end < up_to ? top->end : up_to;
+        if (*cursor < end) {
+            Nst_ExceptionEntry entry = *top;
+            entry.start = *cursor;
+            entry.end = end;
+            if (!Nst_da_append(handlers, &entry))
+                return false;
+        }
+        *cursor = end;
+        if (top->end > up_to)
+            return true;
+        (*open_len)--;
+    }
+    return true;
+}
+
 static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
                             JumpRemap *remaps)
 {
@@ -145,6 +427,7 @@ static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
         Nst_Inst *inst = Nst_ilist_get_inst(ls, i);
         switch (inst->code) {
         case Nst_IC_NO_OP:
+        case Nst_IC_PUSH_CATCH:
             continue;
         case Nst_IC_POP_VAL:
             op_i = add_op(
@@ -186,11 +469,6 @@ static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
                 Nst_OP_THROW_ERR, (usize)inst->val, inst->span,
                 bc, op_i);
             break;
-        case Nst_IC_POP_CATCH:
-            op_i = add_op(
-                Nst_OP_POP_CATCH, (usize)inst->val, inst->span,
-                bc, op_i);
-            break;
         case Nst_IC_SET_VAL:
             op_i = add_op(
                 Nst_OP_SET_VAL, (usize)inst->val, inst->span,
@@ -216,6 +494,11 @@ static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
                 Nst_OP_CALL, (usize)inst->val, inst->span,
                 bc, op_i);
             break;
+        case Nst_IC_OP_TAIL_CALL:
+            op_i = add_op(
+                Nst_OP_TAIL_CALL, (usize)inst->val, inst->span,
+                bc, op_i);
+            break;
         case Nst_IC_OP_SEQ_CALL:
             op_i = add_op(
                 Nst_OP_SEQ_CALL, (usize)inst->val, inst->span,
@@ -311,6 +594,16 @@ static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
                 Nst_OP_UNPACK_SEQ, (usize)inst->val, inst->span,
                 bc, op_i);
             break;
+        case Nst_IC_PUSH_STACK_OP:
+            op_i = add_op(
+                Nst_OP_PUSH_STACK_OP, (usize)inst->val, inst->span,
+                bc, op_i);
+            break;
+        case Nst_IC_GET_STACK_OP:
+            op_i = add_op(
+                Nst_OP_GET_STACK_OP, (usize)inst->val, inst->span,
+                bc, op_i);
+            break;
         case Nst_IC_MAKE_FUNC:
             op_i = add_op(
                 Nst_OP_MAKE_FUNC, (usize)inst->val + obj_count, inst->span,
@@ -341,11 +634,6 @@ static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
                 Nst_OP_JUMPIF_IEND, remaps[i].jump_dst, inst->span,
                 bc, op_i);
             break;
-        case Nst_IC_PUSH_CATCH:
-            op_i = add_op(
-                Nst_OP_PUSH_CATCH, remaps[i].jump_dst, inst->span,
-                bc, op_i);
-            break;
         default:
             Nst_assert_c(false);
             break;
@@ -356,18 +644,12 @@ static void translate_ilist(Nst_Bytecode *bc, Nst_InstList *ls,
 static usize add_op(Nst_OpCode op, usize arg, Nst_Span span, Nst_Bytecode *bc,
                     usize op_i)
 {
-    if (arg > 0xffffff) {
+    // a single extension is enough for arguments up to 48 bits
+    Nst_assert((u64)arg >> 48 == 0);
+    if (arg > Nst_OP_ARG_MAX) {
         bc->positions[op_i] = span;
         bc->bytecode[op_i++] = JOIN_OP(Nst_OP_EXTEND_ARG, arg >> 24);
     }
-    if (arg > 0xffff) {
-        bc->positions[op_i] = span;
-        bc->bytecode[op_i++] = JOIN_OP(Nst_OP_EXTEND_ARG, arg >> 16);
-    }
-    if (arg > 0xff) {
-        bc->positions[op_i] = span;
-        bc->bytecode[op_i++] = JOIN_OP(Nst_OP_EXTEND_ARG, arg >> 8);
-    }
 
     bc->positions[op_i] = span;
     bc->bytecode[op_i++] = JOIN_OP(op, arg);
@@ -384,10 +666,103 @@ static bool assemble_func(Nst_FuncPrototype *func, Nst_Bytecode *bc)
         Nst_bc_destroy(func_bc);
         return false;
     }
+
+    bool capture_all = false;
+    Nst_Obj *outer_names = func_outer_names(func, &capture_all);
+    if (outer_names == NULL && !capture_all) {
+        Nst_dec_ref(func_obj);
+        return false;
+    }
+    if (outer_names != NULL) {
+        _Nst_func_set_outer_names(func_obj, outer_names);
+        Nst_dec_ref(outer_names);
+    }
+
     bc->objects[bc->obj_len++] = func_obj;
     return true;
 }
 
+// Returns an array with the names that the function may read from the local
+// variables of the function that creates it. When `_vars_` is accessed any
+// variable can be read and `capture_all` is set to `true` instead.
+static Nst_Obj *func_outer_names(Nst_FuncPrototype *func, bool *capture_all)
+{
+    Nst_Obj *names = Nst_map_new();
+    if (names == NULL)
+        return NULL;
+
+    if (!collect_names(&func->ilist, names, capture_all) || *capture_all) {
+        Nst_dec_ref(names);
+        return NULL;
+    }
+
+    // the arguments always hide the variables with the same name
+    for (usize i = 0, n = func->arg_num; i < n; i++)
+        Nst_ndec_ref(Nst_map_drop(names, func->arg_names[i]));
+
+    Nst_Obj *names_arr = Nst_array_new(Nst_map_len(names));
+    if (names_arr == NULL) {
+        Nst_dec_ref(names);
+        return NULL;
+    }
+
+    Nst_Obj *key;
+    usize idx = 0;
+    for (isize i = Nst_map_next(-1, names, &key, NULL);
+         i != -1;
+         i = Nst_map_next(i, names, &key, NULL))
+    {
+        Nst_seq_setf(names_arr, idx++, key);
+    }
+    Nst_dec_ref(names);
+    return names_arr;
+}
+
+// Adds to `names` the names read by the instructions of `ls` including the
+// ones of nested functions, since they capture them from this function
+static bool collect_names(Nst_InstList *ls, Nst_Obj *names, bool *capture_all)
+{
+    for (usize i = 0, n = Nst_ilist_len(ls); i < n; i++) {
+        Nst_InstCode code = Nst_ilist_get_inst(ls, i)->code;
+        if (code != Nst_IC_GET_VAL && code != Nst_IC_GET_STACK_OP)
+            continue;
+
+        Nst_Obj *name = Nst_ilist_get_inst_obj(ls, i);
+        if (Nst_obj_eq_c(name, Nst_s.o__vars_)) {
+            *capture_all = true;
+            return true;
+        }
+        if (!Nst_map_set(names, name, Nst_null()))
+            return false;
+    }
+
+    for (usize i = 0, n = ls->functions.len; i < n; i++) {
+        Nst_FuncPrototype *func = Nst_ilist_get_func(ls, i);
+        if (!collect_names(&func->ilist, names, capture_all))
+            return false;
+        if (*capture_all)
+            return true;
+    }
+    return true;
+}
+
+Nst_ExceptionEntry *Nst_bc_find_handler(Nst_Bytecode *bc, usize idx)
+{
+    usize lo = 0;
+    usize hi = bc->handler_len;
+    while (lo < hi) {
+        usize mid = lo + (hi - lo) / 2;
+        Nst_ExceptionEntry *entry = bc->handlers + mid;
+        if (idx < entry->start)
+            hi = mid;
+        else if (idx >= entry->end)
+            lo = mid + 1;
+        else
+            return entry;
+    }
+    return NULL;
+}
+
 void Nst_bc_destroy(Nst_Bytecode *bc)
 {
     if (bc == NULL)
@@ -401,6 +776,42 @@ void Nst_bc_destroy(Nst_Bytecode *bc)
     Nst_free(bc);
 }
 
+static void print_op(u64 op)
+{
+    switch (op) {
+    case Nst_TT_ADD:      Nst_print("+");  break;
+    case Nst_TT_SUB:      Nst_print("-");  break;
+    case Nst_TT_MUL:      Nst_print("*");  break;
+    case Nst_TT_DIV:      Nst_print("/");  break;
+    case Nst_TT_POW:      Nst_print("^");  break;
+    case Nst_TT_MOD:      Nst_print("%");  break;
+    case Nst_TT_B_AND:    Nst_print("&");  break;
+    case Nst_TT_B_OR:     Nst_print("|");  break;
+    case Nst_TT_LEN:      Nst_print("$");  break;
+    case Nst_TT_L_NOT:    Nst_print("!");  break;
+    case Nst_TT_B_NOT:    Nst_print("~");  break;
+    case Nst_TT_GT:       Nst_print(">");  break;
+    case Nst_TT_LT:       Nst_print("<");  break;
+    case Nst_TT_B_XOR:    Nst_print("^^"); break;
+    case Nst_TT_LSHIFT:   Nst_print("<<"); break;
+    case Nst_TT_RSHIFT:   Nst_print(">>"); break;
+    case Nst_TT_CONCAT:   Nst_print("><"); break;
+    case Nst_TT_L_AND:    Nst_print("&&"); break;
+    case Nst_TT_L_OR:     Nst_print("||"); break;
+    case Nst_TT_L_XOR:    Nst_print("&|"); break;
+    case Nst_TT_EQ:       Nst_print("=="); break;
+    case Nst_TT_NEQ:      Nst_print("!="); break;
+    case Nst_TT_GTE:      Nst_print(">="); break;
+    case Nst_TT_LTE:      Nst_print("<="); break;
+    case Nst_TT_NEG:      Nst_print("-:"); break;
+    case Nst_TT_STDOUT:   Nst_print(">>>");break;
+    case Nst_TT_STDIN:    Nst_print("<<<");break;
+    case Nst_TT_TYPEOF:   Nst_print("?::");break;
+    case Nst_TT_CONTAINS: Nst_print("<.>");break;
+    default: Nst_assert_c(false);
+    }
+}
+
 static void bc_print(Nst_Bytecode *bc, usize indent)
 {
     for (usize i = 0; i < indent; i++)
@@ -421,58 +832,15 @@ static void bc_print(Nst_Bytecode *bc, usize indent)
             Nst_print("    ");
         Nst_printf("%*zi  ", idx_width, i);
         Nst_Op op = bc->bytecode[i];
-        switch (Nst_OP_CODE(op)) {
-        case Nst_OP_POP_VAL:      Nst_print("pop    "); break;
-        case Nst_OP_FOR_START:    Nst_print("istart "); break;
-        case Nst_OP_FOR_NEXT:     Nst_print("inext  "); break;
-        case Nst_OP_RETURN_VAL:   Nst_print("ret    "); break;
-        case Nst_OP_RETURN_VARS:  Nst_print("retvar "); break;
-        case Nst_OP_SET_VAL_LOC:  Nst_print("setpop "); break;
-        case Nst_OP_SET_CONT_LOC: Nst_print("setcpop"); break;
-        case Nst_OP_THROW_ERR:    Nst_print("throw  "); break;
-        case Nst_OP_POP_CATCH:    Nst_print("poptry "); break;
-        case Nst_OP_SET_VAL:      Nst_print("set    "); break;
-        case Nst_OP_GET_VAL:      Nst_print("get    "); break;
-        case Nst_OP_PUSH_VAL:     Nst_print("push   "); break;
-        case Nst_OP_SET_CONT_VAL: Nst_print("setc   "); break;
-        case Nst_OP_CALL:         Nst_print("call   "); break;
-        case Nst_OP_SEQ_CALL:     Nst_print("callseq"); break;
-        case Nst_OP_CAST:         Nst_print("cast   "); break;
-        case Nst_OP_RANGE:        Nst_print("range  "); break;
-        case Nst_OP_STACK:        Nst_print("binop  "); break;
-        case Nst_OP_LOCAL:        Nst_print("uniop  "); break;
-        case Nst_OP_IMPORT:       Nst_print("import "); break;
-        case Nst_OP_EXTRACT:      Nst_print("extract"); break;
-        case Nst_OP_DEC_INT:      Nst_print("dec    "); break;
-        case Nst_OP_NEW_INT:      Nst_print("dupint "); break;
-        case Nst_OP_DUP:          Nst_print("dup    "); break;
-        case Nst_OP_ROT_2:        Nst_print("rot2   "); break;
-        case Nst_OP_ROT_3:        Nst_print("rot3   "); break;
-        case Nst_OP_MAKE_ARR:     Nst_print("mkarr  "); break;
-        case Nst_OP_MAKE_ARR_REP: Nst_print("fillarr"); break;
-        case Nst_OP_MAKE_VEC:     Nst_print("mkvec  "); break;
-        case Nst_OP_MAKE_VEC_REP: Nst_print("fillvec"); break;
-        case Nst_OP_MAKE_MAP:     Nst_print("mkmap  "); break;
-        case Nst_OP_MAKE_FUNC:    Nst_print("mkfunc "); break;
-        case Nst_OP_SAVE_ERROR:   Nst_print("geterr "); break;
-        case Nst_OP_UNPACK_SEQ:   Nst_print("unpack "); break;
-        case Nst_OP_EXTEND_ARG:   Nst_print("extend "); break;
-        case Nst_OP_JUMP:         Nst_print("jmp    "); break;
-        case Nst_OP_JUMPIF_T:     Nst_print("jmptrue"); break;
-        case Nst_OP_JUMPIF_F:     Nst_print("jmpflse"); break;
-        case Nst_OP_JUMPIF_ZERO:  Nst_print("jmpzero"); break;
-        case Nst_OP_JUMPIF_IEND:  Nst_print("jmpiend"); break;
-        case Nst_OP_PUSH_CATCH:   Nst_print("pushtry"); break;
-        default: Nst_assert_c(false);
-        }
+        Nst_printf("%-7s", Nst_op_name(Nst_OP_CODE(op)));
 
         if (extend_arg)
-            arg = arg << 8 | Nst_OP_ARG(op);
+            arg = arg << 24 | Nst_OP_ARG(op);
         else
             arg = Nst_OP_ARG(op);
         extend_arg = Nst_OP_CODE(op) == Nst_OP_EXTEND_ARG;
 
-        Nst_printf(" %3" PRIu8, Nst_OP_ARG(op));
+        Nst_printf(" %3" PRIu32, Nst_OP_ARG(op));
 
         if (arg != Nst_OP_ARG(op))
             Nst_printf(" (extended: %3" PRIu64 ")", arg);
@@ -480,46 +848,18 @@ static void bc_print(Nst_Bytecode *bc, usize indent)
             || Nst_OP_CODE(op) == Nst_OP_LOCAL)
         {
             Nst_print(" [");
-
-            switch (arg) {
-            case Nst_TT_ADD:      Nst_print("+");  break;
-            case Nst_TT_SUB:      Nst_print("-");  break;
-            case Nst_TT_MUL:      Nst_print("*");  break;
-            case Nst_TT_DIV:      Nst_print("/");  break;
-            case Nst_TT_POW:      Nst_print("^");  break;
-            case Nst_TT_MOD:      Nst_print("%");  break;
-            case Nst_TT_B_AND:    Nst_print("&");  break;
-            case Nst_TT_B_OR:     Nst_print("|");  break;
-            case Nst_TT_LEN:      Nst_print("$");  break;
-            case Nst_TT_L_NOT:    Nst_print("!");  break;
-            case Nst_TT_B_NOT:    Nst_print("~");  break;
-            case Nst_TT_GT:       Nst_print(">");  break;
-            case Nst_TT_LT:       Nst_print("<");  break;
-            case Nst_TT_B_XOR:    Nst_print("^^"); break;
-            case Nst_TT_LSHIFT:   Nst_print("<<"); break;
-            case Nst_TT_RSHIFT:   Nst_print(">>"); break;
-            case Nst_TT_CONCAT:   Nst_print("><"); break;
-            case Nst_TT_L_AND:    Nst_print("&&"); break;
-            case Nst_TT_L_OR:     Nst_print("||"); break;
-            case Nst_TT_L_XOR:    Nst_print("&|"); break;
-            case Nst_TT_EQ:       Nst_print("=="); break;
-            case Nst_TT_NEQ:      Nst_print("!="); break;
-            case Nst_TT_GTE:      Nst_print(">="); break;
-            case Nst_TT_LTE:      Nst_print("<="); break;
-            case Nst_TT_NEG:      Nst_print("-:"); break;
-            case Nst_TT_STDOUT:   Nst_print(">>>");break;
-            case Nst_TT_STDIN:    Nst_print("<<<");break;
-            case Nst_TT_TYPEOF:   Nst_print("?::");break;
-            case Nst_TT_CONTAINS: Nst_print("<.>");break;
-            default: Nst_assert_c(false);
-            }
+            print_op(arg);
             Nst_print("]");
         } else if (Nst_OP_CODE(op) == Nst_OP_PUSH_VAL
                    || Nst_OP_CODE(op) == Nst_OP_GET_VAL
                    || Nst_OP_CODE(op) == Nst_OP_SET_VAL
-                   || Nst_OP_CODE(op) == Nst_OP_SET_VAL_LOC)
+                   || Nst_OP_CODE(op) == Nst_OP_SET_VAL_LOC
+                   || Nst_OP_CODE(op) == Nst_OP_PUSH_STACK_OP
+                   || Nst_OP_CODE(op) == Nst_OP_GET_STACK_OP)
         {
-            Nst_Obj *obj = bc->objects[arg];
+            bool fused = Nst_OP_CODE(op) == Nst_OP_PUSH_STACK_OP
+                      || Nst_OP_CODE(op) == Nst_OP_GET_STACK_OP;
+            Nst_Obj *obj = bc->objects[fused ? Nst_INST_FUSED_OBJ(arg) : arg];
             Nst_printf(" [(%s) ", Nst_type_name(obj->type).value);
 
             Nst_Obj *s = Nst_obj_to_repr_str(obj);
@@ -530,9 +870,33 @@ static void bc_print(Nst_Bytecode *bc, usize indent)
                 Nst_dec_ref(s);
             }
             Nst_print("]");
+            if (fused) {
+                Nst_print(" [");
+                print_op(Nst_INST_FUSED_OP(arg));
+                Nst_print("]");
+            }
         }
         Nst_println("");
     }
+
+    if (bc->handler_len != 0) {
+        Nst_println("");
+        for (usize i = 0; i < indent; i++)
+            Nst_print("    ");
+        Nst_println("Exception table:");
+    }
+    for (usize i = 0, n = bc->handler_len; i < n; i++) {
+        for (usize j = 0; j < indent; j++)
+            Nst_print("    ");
+        Nst_ExceptionEntry *entry = bc->handlers + i;
+        Nst_printf(
+            "%*zi-%-*zi -> %*zi  depth %zi\n",
+            idx_width, entry->start,
+            idx_width, entry->end,
+            idx_width, entry->handler,
+            entry->stack_depth);
+    }
+
     Nst_println("");
     for (usize i = 0; i < indent; i++)
         Nst_print("    ");
@@ -572,3 +936,8 @@ void Nst_bc_print(Nst_Bytecode *bc)
 {
     bc_print(bc, 0);
 }
+
+const char *Nst_op_name(Nst_OpCode op)
+{
+    return op_names[op];
+}
@@ -22,6 +22,7 @@ static bool add_inst(Nst_InstCode inst, Nst_Span span);
 static bool add_inst_ex(Nst_InstCode inst, i64 val, Nst_Span span);
 static bool add_inst_obj(Nst_InstCode inst, Nst_Obj *obj, Nst_Span span);
 static Nst_Inst *get_inst(usize idx);
+static bool has_jumps_to_end(void);
 
 static void replace_placeholder_jumps(usize start, usize end, i64 loop_id,
                                       i64 continue_idx, i64 break_idx);
@@ -136,6 +137,17 @@ static Nst_Inst *get_inst(usize idx)
     return (Nst_Inst *)Nst_da_get(&c_state.ls.instructions, idx);
 }
 
+// check if any jump points past the last instruction
+static bool has_jumps_to_end(void)
+{
+    for (usize i = 0, n = c_state.ls.instructions.len; i < n; i++) {
+        Nst_Inst *inst = get_inst(i);
+        if (Nst_ic_is_jump(inst->code) && inst->val == CURR_LEN)
+            return true;
+    }
+    return false;
+}
+
 static void replace_placeholder_jumps(usize start, usize end, i64 loop_id,
                                       i64 continue_idx, i64 break_idx)
 {
@@ -173,7 +185,8 @@ Nst_InstList Nst_compile(Nst_Node *ast, bool is_module)
         if (!add_inst(Nst_IC_RETURN_VARS, ast->span))
             goto failure;
     } else if (c_state.ls.instructions.len == 0
-               || get_inst(LAST_INST)->code != Nst_IC_RETURN_VAL)
+               || get_inst(LAST_INST)->code != Nst_IC_RETURN_VAL
+               || has_jumps_to_end())
     {
         if (!add_inst_obj(Nst_IC_PUSH_VAL, Nst_c.Null_null, ast->span))
             goto failure;
@@ -404,15 +417,23 @@ static bool compile_s_for_as_lp(Nst_Node *node)
           [ITERATOR CODE]
           FOR_START
           POP_VAL
-    cond: FOR_NEXT
+    cond: FOR_NEXT unpack_count
           JUMPIF_IEND exit
           [ASSIGN_CODE name]
           [BODY CODE]
           JUMP cond
     exit: POP_VAL
           [CODE CONTINUATION]
+
+    When the values are unpacked `unpack_count` is the number of names and
+    the assignment code starts with UNPACK_SEQ, otherwise it is zero
     */
 
+    Nst_Node *assignment = node->v.s_for_lp.assignment;
+    usize unpack_count = 0;
+    if (assignment->type == Nst_NT_E_SEQ_LITERAL)
+        unpack_count = assignment->v.e_seq_literal.values.len;
+
     if (!compile_node(node->v.s_for_lp.iterator))
         return false;
 
@@ -422,13 +443,13 @@ static bool compile_s_for_as_lp(Nst_Node *node)
         return false;
 
     i64 cond_idx = CURR_LEN;
-    if (!add_inst(Nst_IC_FOR_NEXT, node->span))
+    if (!add_inst_ex(Nst_IC_FOR_NEXT, unpack_count, node->span))
         return false;
     if (!add_inst(Nst_IC_JUMPIF_IEND, node->v.s_for_lp.iterator->span))
         return false;
     usize jumpif_iend_exit = LAST_INST;
 
-    if (!compile_e_unpacking_assignment(node->v.s_for_lp.assignment))
+    if (!compile_e_unpacking_assignment(assignment))
         return false;
 
     i64 start = CURR_LEN;
@@ -617,13 +638,32 @@ static bool compile_s_return(Nst_Node *node)
     [EXPR CODE]
     RETURN_VAL
 
-    Pops all values from the stack until it finds a nullptr
+    Calls whose result is returned directly become OP_TAIL_CALL, this
+    includes the calls at the end of the branches of an if expression
     */
     if (node->v.s_return.value == NULL) {
         if (!add_inst_obj(Nst_IC_PUSH_VAL, Nst_c.Null_null, node->span))
             return false;
-    } else if (!compile_node(node->v.s_return.value))
+        return add_inst(Nst_IC_RETURN_VAL, node->span);
+    }
+
+    usize start = (usize)CURR_LEN;
+    if (!compile_node(node->v.s_return.value))
         return false;
+    usize end = (usize)CURR_LEN;
+
+    for (usize i = start; i < end; i++) {
+        Nst_Inst *inst = get_inst(i);
+        if (inst->code != Nst_IC_OP_CALL)
+            continue;
+        if (i + 1 == end) {
+            inst->code = Nst_IC_OP_TAIL_CALL;
+            continue;
+        }
+        Nst_Inst *next = get_inst(i + 1);
+        if (next->code == Nst_IC_JUMP && next->val == (i64)end)
+            inst->code = Nst_IC_OP_TAIL_CALL;
+    }
 
     return add_inst(Nst_IC_RETURN_VAL, node->span);
 }
@@ -1248,17 +1288,18 @@ failure:
 static bool compile_s_try_catch(Nst_Node *node)
 {
     /*
-    Switch statement instructions
+    Try-catch statement instructions
 
                  PUSH_CATCH catch_start
                  [TRY BODY]
-                 POP_CATCH
                  JUMP catch_end
     catch_start: SAVE_ERROR
-                 POP_CATCH
                  SET_VAL_LOC err_name
                  [CATCH BODY]
     catch_end:   [CODE CONTINUATION]
+
+    PUSH_CATCH only marks the start of the `try` block, the assembler turns the
+    range [PUSH_CATCH, catch_start) into an entry of the exception table
     */
 
     if (!add_inst(Nst_IC_PUSH_CATCH, node->span))
@@ -1272,9 +1313,6 @@ static bool compile_s_try_catch(Nst_Node *node)
             return false;
     }
 
-    if (!add_inst(Nst_IC_POP_CATCH, node->span))
-        return false;
-
     if (!add_inst(Nst_IC_JUMP, node->span))
         return false;
     usize jump_catch_end = LAST_INST;
@@ -1282,8 +1320,6 @@ static bool compile_s_try_catch(Nst_Node *node)
 
     if (!add_inst(Nst_IC_SAVE_ERROR, node->span))
         return false;
-    if (!add_inst(Nst_IC_POP_CATCH, node->span))
-        return false;
     if (!add_inst_obj(
             Nst_IC_SET_VAL_LOC,
             node->v.s_try_catch.error_name,
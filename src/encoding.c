@@ -1739,7 +1739,10 @@ bool Nst_encoding_translate(Nst_Encoding *from, Nst_Encoding *to,
         if (*to_buf == NULL) {
             return false;
         }
-        memcpy(*to_buf, from_buf, from->ch_size * (from_len + 1));
+        // the terminator is written separately since from_buf is not
+        // required to have one
+        memcpy(*to_buf, from_buf, from->ch_size * from_len);
+        memset((u8 *)*to_buf + from->ch_size * from_len, 0, from->ch_size);
         if (to_len != NULL)
             *to_len = from_len;
         return true;
@@ -26,6 +26,8 @@ typedef struct _Nst_IOFileObj {
 } Nst_IOFileObj;
 
 #define IOFILE(ptr) ((Nst_IOFileObj *)(ptr))
+// size of the buffer used to encode the text written to a file
+#define FILE_WRITE_BUF_SIZE 4096
 
 static u32 io_result_ill_encoded_ch;
 static usize io_result_position;
@@ -64,6 +66,17 @@ Nst_Obj *Nst_iof_new(FILE *value, bool bin, bool read, bool write,
     if (isatty(obj->fd))
         Nst_SET_FLAG(obj, Nst_FLAG_IOFILE_IS_TTY);
 
+    // the BOM is added by the first write if the file is still empty, except
+    // for UTF-8 files
+    if (!bin && write && Nst_IOF_CAN_SEEK(obj)
+        && encoding != NULL
+        && encoding->bom != NULL
+        && encoding != &Nst_encoding_utf8
+        && encoding != &Nst_encoding_ext_utf8)
+    {
+        Nst_SET_FLAG(obj, Nst_FLAG_IOFILE_CHECK_BOM);
+    }
+
     return NstOBJ(obj);
 }
 
@@ -272,74 +285,160 @@ Nst_IOResult Nst_FILE_read(u8 *buf, usize buf_size, usize count,
     return Nst_IO_SUCCESS;
 }
 
-Nst_IOResult Nst_FILE_write(u8 *buf, usize buf_len, usize *count, Nst_Obj *f)
+// Writes the characters of `buf` that are valid in the encoding of `f` with a
+// single call to `fwrite`, the text of the string is already UTF-8
+static Nst_IOResult FILE_write_utf8(u8 *buf, usize buf_len, usize *count,
+                                    Nst_Obj *f)
 {
-    Nst_assert(f->type == Nst_t.IOFile);
-
-    if (Nst_IOF_IS_CLOSED(f))
-        return Nst_IO_CLOSED;
-
-    if (!Nst_IOF_CAN_WRITE(f))
-        return Nst_IO_OP_FAILED;
+    bool allow_surrogates = IOFILE(f)->encoding == &Nst_encoding_ext_utf8;
+    usize chars = 0;
+    usize i = 0;
+    u32 invalid_ch = 0;
+    bool is_valid = true;
+
+    while (i < buf_len) {
+        if (buf[i] < 0x80) {
+            i++;
+            chars++;
+            continue;
+        }
+        i32 ch_len = Nst_check_ext_utf8_bytes(buf + i, buf_len - i);
+        u32 ch = Nst_ext_utf8_to_utf32(buf + i);
+        if (ch > 0x10ffff
+            || (!allow_surrogates && ch >= 0xd800 && ch <= 0xdfff))
+        {
+            invalid_ch = ch;
+            is_valid = false;
+            break;
+        }
+        i += ch_len;
+        chars++;
+    }
 
-    if (Nst_IOF_IS_BIN(f)) {
-        usize written_bytes = fwrite(buf, 1, buf_len, IOFILE(f)->fp);
+    usize written_bytes = fwrite(buf, 1, i, IOFILE(f)->fp);
+    if (written_bytes != i) {
+        // count only the characters that were written completely
+        chars = 0;
+        for (usize j = 0; j < written_bytes; j++) {
+            if ((buf[j] & 0xc0) != 0x80)
+                chars++;
+        }
+        if (written_bytes < i && (buf[written_bytes] & 0xc0) == 0x80)
+            chars--;
         if (count != NULL)
-            *count = written_bytes;
-
-        if (written_bytes != buf_len)
-            return Nst_IO_ERROR;
-        return Nst_IO_SUCCESS;
+            *count = chars;
+        return Nst_IO_ERROR;
     }
 
-    // add BOM if it can be added except for UTF-8 files
-    if (Nst_IOF_CAN_SEEK(f)
-        && ftell((FILE *)IOFILE(f)->fp) == 0
-        && IOFILE(f)->encoding->bom != NULL
-        && IOFILE(f)->encoding != &Nst_encoding_utf8
-        && IOFILE(f)->encoding != &Nst_encoding_ext_utf8)
-    {
-        usize written_bytes = fwrite(
-            IOFILE(f)->encoding->bom,
-            1, IOFILE(f)->encoding->bom_size,
-            (FILE *)IOFILE(f)->fp);
-
-        if (written_bytes != IOFILE(f)->encoding->bom_size)
-            return Nst_IO_ERROR;
+    if (count != NULL)
+        *count = chars;
+    if (!is_valid) {
+        Nst_io_result_set_details(invalid_ch, i, IOFILE(f)->encoding->name);
+        return Nst_IO_INVALID_ENCODING;
     }
+    return Nst_IO_SUCCESS;
+}
 
+// Encodes `buf` into a buffer on the stack that is written to the file every
+// time it is full
+static Nst_IOResult FILE_write_encoded(u8 *buf, usize buf_len, usize *count,
+                                       Nst_Obj *f)
+{
+    Nst_FromUTF32Func from_utf32 = IOFILE(f)->encoding->from_utf32;
+    u8 out[FILE_WRITE_BUF_SIZE];
+    usize out_len = 0;
+    // characters already written to the file and the ones in `out`
     usize chars_written = 0;
-    u8 ch_buf[Nst_ENCODING_MULTIBYTE_MAX_SIZE];
-
+    usize chars_buffered = 0;
     usize initial_len = buf_len;
+
     while (buf_len > 0) {
+        if (out_len > FILE_WRITE_BUF_SIZE - Nst_ENCODING_MULTIBYTE_MAX_SIZE) {
+            if (fwrite(out, 1, out_len, IOFILE(f)->fp) != out_len) {
+                if (count != NULL)
+                    *count = chars_written;
+                return Nst_IO_ERROR;
+            }
+            chars_written += chars_buffered;
+            chars_buffered = 0;
+            out_len = 0;
+        }
+
         i32 ch_len = Nst_check_ext_utf8_bytes(buf, buf_len);
         u32 ch = Nst_ext_utf8_to_utf32(buf);
-        i32 ch_buf_len = IOFILE(f)->encoding->from_utf32(ch, ch_buf);
+        i32 ch_buf_len = from_utf32(ch, out + out_len);
         if (ch_buf_len < 0) {
+            // the characters before the invalid one are still written
+            if (fwrite(out, 1, out_len, IOFILE(f)->fp) != out_len) {
+                if (count != NULL)
+                    *count = chars_written;
+                return Nst_IO_ERROR;
+            }
             if (count != NULL)
-                *count = chars_written;
+                *count = chars_written + chars_buffered;
             Nst_io_result_set_details(
                 ch,
                 initial_len - buf_len,
                 IOFILE(f)->encoding->name);
             return Nst_IO_INVALID_ENCODING;
         }
-        usize written_char = fwrite(ch_buf, 1, ch_buf_len, IOFILE(f)->fp);
-        if (written_char != (usize)ch_buf_len) {
-            if (count != NULL)
-                *count = chars_written;
-            return Nst_IO_ERROR;
-        }
-        chars_written++;
+        out_len += ch_buf_len;
+        chars_buffered++;
         buf += ch_len;
         buf_len -= ch_len;
     }
+
+    if (fwrite(out, 1, out_len, IOFILE(f)->fp) != out_len) {
+        if (count != NULL)
+            *count = chars_written;
+        return Nst_IO_ERROR;
+    }
     if (count != NULL)
-        *count = chars_written;
+        *count = chars_written + chars_buffered;
     return Nst_IO_SUCCESS;
 }
 
+Nst_IOResult Nst_FILE_write(u8 *buf, usize buf_len, usize *count, Nst_Obj *f)
+{
+    Nst_assert(f->type == Nst_t.IOFile);
+
+    if (Nst_IOF_IS_CLOSED(f))
+        return Nst_IO_CLOSED;
+
+    if (!Nst_IOF_CAN_WRITE(f))
+        return Nst_IO_OP_FAILED;
+
+    if (Nst_IOF_IS_BIN(f)) {
+        usize written_bytes = fwrite(buf, 1, buf_len, IOFILE(f)->fp);
+        if (count != NULL)
+            *count = written_bytes;
+
+        if (written_bytes != buf_len)
+            return Nst_IO_ERROR;
+        return Nst_IO_SUCCESS;
+    }
+
+    if (Nst_HAS_FLAG(f, Nst_FLAG_IOFILE_CHECK_BOM)) {
+        Nst_DEL_FLAG(f, Nst_FLAG_IOFILE_CHECK_BOM);
+        if (ftell((FILE *)IOFILE(f)->fp) == 0) {
+            usize written_bytes = fwrite(
+                IOFILE(f)->encoding->bom,
+                1, IOFILE(f)->encoding->bom_size,
+                (FILE *)IOFILE(f)->fp);
+
+            if (written_bytes != IOFILE(f)->encoding->bom_size)
+                return Nst_IO_ERROR;
+        }
+    }
+
+    if (IOFILE(f)->encoding == &Nst_encoding_utf8
+        || IOFILE(f)->encoding == &Nst_encoding_ext_utf8)
+    {
+        return FILE_write_utf8(buf, buf_len, count, f);
+    }
+    return FILE_write_encoded(buf, buf_len, count, f);
+}
+
 Nst_IOResult Nst_FILE_flush(Nst_Obj *f)
 {
     Nst_assert(f->type == Nst_t.IOFile);
@@ -14,7 +14,8 @@ typedef struct _Nst_FuncObj {
     Nst_Obj **args;
     isize arg_num;
     Nst_Obj *mod_globals;
-    Nst_Obj *outer_vars;
+    Nst_Obj *outer_names;
+    Nst_Obj **outer_vals;
 } Nst_FuncObj;
 
 #define FUNC(ptr) ((Nst_FuncObj *)(ptr))
@@ -40,7 +41,8 @@ Nst_Obj *_Nst_func_new(Nst_Obj **arg_names, usize arg_num, Nst_Bytecode *bc)
     func->args = args;
     func->arg_num = arg_num;
     func->mod_globals = NULL;
-    func->outer_vars = NULL;
+    func->outer_names = NULL;
+    func->outer_vals = NULL;
 
     return NstOBJ(func);
 }
@@ -55,7 +57,8 @@ Nst_Obj *Nst_func_new_c(usize arg_num, Nst_NestCallable cbody)
     func->args = NULL;
     func->arg_num = arg_num;
     func->mod_globals = NULL;
-    func->outer_vars = NULL;
+    func->outer_names = NULL;
+    func->outer_vals = NULL;
 
     Nst_SET_FLAG(func, Nst_FLAG_FUNC_IS_C);
 
@@ -65,6 +68,32 @@ Nst_Obj *Nst_func_new_c(usize arg_num, Nst_NestCallable cbody)
     return NstOBJ(func);
 }
 
+// Creates a vector with the names of all the variables in `vars` except
+// for `_vars_` and `_globals_`
+static Nst_Obj *all_var_names(Nst_Obj *vars)
+{
+    Nst_Obj *names = Nst_vector_new(0);
+    if (names == NULL)
+        return NULL;
+
+    Nst_Obj *key;
+    for (isize i = Nst_map_next(-1, vars, &key, NULL);
+         i != -1;
+         i = Nst_map_next(i, vars, &key, NULL))
+    {
+        if (Nst_obj_eq_c(key, Nst_s.o__vars_)
+            || Nst_obj_eq_c(key, Nst_s.o__globals_))
+        {
+            continue;
+        }
+        if (!Nst_vector_append(names, key)) {
+            Nst_dec_ref(names);
+            return NULL;
+        }
+    }
+    return names;
+}
+
 Nst_Obj *_Nst_func_new_outer_vars(Nst_Obj *func, Nst_Obj *vars)
 {
     Nst_assert(func->type == Nst_t.Func);
@@ -73,14 +102,30 @@ Nst_Obj *_Nst_func_new_outer_vars(Nst_Obj *func, Nst_Obj *vars)
     if (Nst_FUNC_IS_C(func))
         return Nst_inc_ref(func);
 
+    Nst_Obj *outer_names = FUNC(func)->outer_names;
+    if (outer_names == NULL)
+        outer_names = all_var_names(vars);
+    else
+        Nst_inc_ref(outer_names);
+    if (outer_names == NULL)
+        return NULL;
+
     usize arg_num = FUNC(func)->arg_num;
+    usize outer_num = Nst_seq_len(outer_names);
     Nst_Obj **args = Nst_malloc_c(arg_num, Nst_Obj *);
-    if (args == NULL)
+    Nst_Obj **outer_vals = Nst_malloc_c(outer_num, Nst_Obj *);
+    if (args == NULL || outer_vals == NULL) {
+        Nst_free(args);
+        Nst_free(outer_vals);
+        Nst_dec_ref(outer_names);
         return NULL;
+    }
 
     Nst_FuncObj *new_func = Nst_obj_alloc(Nst_FuncObj, Nst_t.Func);
     if (new_func == NULL) {
         Nst_free(args);
+        Nst_free(outer_vals);
+        Nst_dec_ref(outer_names);
         return NULL;
     }
 
@@ -88,11 +133,18 @@ Nst_Obj *_Nst_func_new_outer_vars(Nst_Obj *func, Nst_Obj *vars)
     for (usize i = 0, n = arg_num; i < n; i++)
         Nst_inc_ref(args[i]);
 
+    // names that are not defined are left as `NULL` and are looked up in the
+    // global variables when the function is called
+    Nst_Obj **names = Nst_seq_objs(outer_names);
+    for (usize i = 0; i < outer_num; i++)
+        outer_vals[i] = Nst_map_get(vars, names[i]);
+
     new_func->body.bytecode = Nst_bc_copy(FUNC(func)->body.bytecode);
     new_func->args = args;
     new_func->arg_num = FUNC(func)->arg_num;
     new_func->mod_globals = Nst_ninc_ref(FUNC(func)->mod_globals);
-    new_func->outer_vars = Nst_inc_ref(vars);
+    new_func->outer_names = outer_names;
+    new_func->outer_vals = outer_vals;
 
     Nst_GGC_OBJ_INIT(new_func);
 
@@ -104,8 +156,13 @@ void _Nst_func_traverse(Nst_Obj *func)
     Nst_assert(func->type == Nst_t.Func);
     if (FUNC(func)->mod_globals != NULL)
         Nst_ggc_obj_reachable(FUNC(func)->mod_globals);
-    if (FUNC(func)->outer_vars != NULL)
-        Nst_ggc_obj_reachable(FUNC(func)->outer_vars);
+    if (FUNC(func)->outer_names == NULL || FUNC(func)->outer_vals == NULL)
+        return;
+    Nst_ggc_obj_reachable(FUNC(func)->outer_names);
+    for (usize i = 0, n = Nst_seq_len(FUNC(func)->outer_names); i < n; i++) {
+        if (FUNC(func)->outer_vals[i] != NULL)
+            Nst_ggc_obj_reachable(FUNC(func)->outer_vals[i]);
+    }
 }
 
 void _Nst_func_destroy(Nst_Obj *func)
@@ -120,8 +177,13 @@ void _Nst_func_destroy(Nst_Obj *func)
         Nst_bc_destroy(FUNC(func)->body.bytecode);
     if (FUNC(func)->mod_globals != NULL)
         Nst_dec_ref(FUNC(func)->mod_globals);
-    if (FUNC(func)->outer_vars != NULL)
-        Nst_dec_ref(FUNC(func)->outer_vars);
+    if (FUNC(func)->outer_vals != NULL) {
+        for (usize i = 0, n = Nst_seq_len(FUNC(func)->outer_names); i < n; i++)
+            Nst_ndec_ref(FUNC(func)->outer_vals[i]);
+        Nst_free(FUNC(func)->outer_vals);
+    }
+    if (FUNC(func)->outer_names != NULL)
+        Nst_dec_ref(FUNC(func)->outer_names);
 }
 
 void _Nst_func_set_mod_globals(Nst_Obj *func, Nst_Obj *globals)
@@ -135,6 +197,17 @@ void _Nst_func_set_mod_globals(Nst_Obj *func, Nst_Obj *globals)
     FUNC(func)->mod_globals = Nst_inc_ref(globals);
 }
 
+void _Nst_func_set_outer_names(Nst_Obj *func, Nst_Obj *names)
+{
+    Nst_assert(func->type == Nst_t.Func);
+    Nst_assert(names->type == Nst_t.Array);
+
+    if (Nst_FUNC_IS_C(func) || FUNC(func)->outer_names != NULL)
+        return;
+
+    FUNC(func)->outer_names = Nst_inc_ref(names);
+}
+
 usize Nst_func_arg_num(Nst_Obj *func)
 {
     Nst_assert(func->type == Nst_t.Func);
@@ -167,8 +240,14 @@ Nst_Obj *Nst_func_mod_globals(Nst_Obj *func)
     return FUNC(func)->mod_globals;
 }
 
-Nst_Obj *Nst_func_outer_vars(Nst_Obj *func)
+Nst_Obj *Nst_func_outer_names(Nst_Obj *func)
+{
+    Nst_assert(func->type == Nst_t.Func);
+    return FUNC(func)->outer_names;
+}
+
+Nst_Obj **Nst_func_outer_vals(Nst_Obj *func)
 {
     Nst_assert(func->type == Nst_t.Func);
-    return FUNC(func)->outer_vars;
+    return FUNC(func)->outer_vals;
 }
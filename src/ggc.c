@@ -1,127 +1,241 @@
+#include <string.h>
 #include "nest.h"
 
+#ifdef Nst_MSVC
+#include <windows.h>
+#else
+#include <time.h>
+#endif // !Nst_MSVC
+
 #define GGC_OBJ(obj) ((Nst_GGCObj *)(obj))
+#define GEN(id) (&ggc.gens[id])
+#define GEN_MIN_CAP 1024
+#define PAUSE_BUCKETS 32
+
+/**
+ * The lists of objects of the garbage collector, the ID is stored in the
+ * `ggc_gen` field of each object.
+ *
+ * @param GEN_NONE: the object is not tracked or it is being destroyed by a
+ * collection
+ * @param GEN_1: the first generation
+ * @param GEN_2: the second generation
+ * @param GEN_3: the third generation
+ * @param GEN_OLD_A: one of the two lists used for the old generation
+ * @param GEN_OLD_B: one of the two lists used for the old generation
+ * @param GEN_WHITE: the objects of the old generation that have not been
+ * found reachable during its collection
+ * @param GEN_GREY: the objects of the old generation that have been found
+ * reachable during its collection but have not been traversed yet
+ * @param GEN_UNREACHABLE: the objects that `collect_gen` found unreachable
+ */
+typedef enum _GenID {
+    GEN_NONE,
+    GEN_1,
+    GEN_2,
+    GEN_3,
+    GEN_OLD_A,
+    GEN_OLD_B,
+    GEN_WHITE,
+    GEN_GREY,
+    GEN_UNREACHABLE,
+    GEN_COUNT
+} GenID;
+
+/**
+ * The phases of a collection of the old generation.
+ *
+ * @param OLD_IDLE: no collection is in progress
+ * @param OLD_COPY: the reference counts are being copied
+ * @param OLD_SUBTRACT: the references between objects are being subtracted
+ * @param OLD_MARK: the objects reachable from outside the generation are
+ * being marked
+ */
+typedef enum _OldGenPhase {
+    OLD_IDLE,
+    OLD_COPY,
+    OLD_SUBTRACT,
+    OLD_MARK
+} OldGenPhase;
+
+/**
+ * The pause times of the garbage collector.
+ *
+ * @param hist: the number of pauses shorter than `1 << i` microseconds and
+ * at least half as long in each bucket `i`
+ * @param count: the total number of pauses
+ * @param total_ns: the total duration of the pauses in nanoseconds
+ * @param max_ns: the duration of the longest pause in nanoseconds
+ */
+typedef struct _PauseStats {
+    u64 hist[PAUSE_BUCKETS];
+    u64 count;
+    u64 total_ns;
+    u64 max_ns;
+} PauseStats;
 
 /**
  * The structure representing the garbage collector.
  *
- * @param gen1: the first generation
- * @param gen2: the second generation
- * @param gen3: the third generation
- * @param old_gen: the old generation
+ * @param gens: the lists of objects, indexed by `GenID`
+ * @param old_gen: the list of the old generation, while it is being collected
+ * it receives the objects that are promoted and the ones found reachable
+ * @param old_scan: the list of the objects of the old generation that are
+ * being collected, `GEN_NONE` when there is no collection in progress
+ * @param cursor: the index of the next object of `old_scan` to visit, the
+ * objects before it have already been visited in the current phase
+ * @param phase: the phase of the collection of the old generation
+ * @param visited: the number of objects visited by the collection of the old
+ * generation and of references found by traversals, it measures the work of
+ * each step
+ * @param step: the maximum number of objects and references visited by each
+ * step of the collection of the old generation, `0` for no limit
  * @param old_gen_pending: the number of objects in the old generation that
  * have been added since its last collection
- * @param allow_tracking: whether the tracking of new objects is allowed
+ * @param record_pauses: whether the pause times are recorded
+ * @param young_pauses: the pauses that only collected the young generations
+ * @param old_pauses: the pauses that included a step of the collection of the
+ * old generation
  */
 NstEXP typedef struct _Nst_GarbageCollector {
-    Nst_GGCList gen1;
-    Nst_GGCList gen2;
-    Nst_GGCList gen3;
-    Nst_GGCList old_gen;
+    Nst_GGCList gens[GEN_COUNT];
+    GenID old_gen;
+    GenID old_scan;
+    usize cursor;
+    OldGenPhase phase;
+    usize visited;
+    usize step;
     i64 old_gen_pending;
+    bool record_pauses;
+    PauseStats young_pauses;
+    PauseStats old_pauses;
 } Nst_GarbageCollector;
 
 static Nst_GarbageCollector ggc;
 
-static inline void move_obj(Nst_GGCObj *obj, Nst_GGCList *from, Nst_GGCList *to)
+static bool reserve_gen(Nst_GGCList *gen, usize size)
 {
-    if (from->len == 1) {
-        from->len = 0;
-        from->head = NULL;
-        from->tail = NULL;
-    } else {
-        // if it's the first object in the list
-        if (obj->p_prev == NULL)
-            from->head = GGC_OBJ(obj->p_next);
-        else
-            obj->p_prev->p_next = obj->p_next;
-
-        // if it's the last object in the list
-        if (obj->p_next == NULL)
-            from->tail = GGC_OBJ(obj->p_prev);
-        else
-            GGC_OBJ(obj->p_next)->p_prev = obj->p_prev;
-
-        from->len--;
-    }
+    if (size <= gen->cap)
+        return true;
+
+    usize new_cap = gen->cap < GEN_MIN_CAP ? GEN_MIN_CAP : gen->cap;
+    while (new_cap < size)
+        new_cap *= 2;
+
+    Nst_GGCObj **objs = (Nst_GGCObj **)Nst_raw_realloc(
+        gen->objs,
+        new_cap * sizeof(Nst_GGCObj *));
+    if (objs == NULL)
+        return false;
+    gen->objs = objs;
+    gen->cap = new_cap;
+    return true;
+}
 
-    if (to->len == 0)
-        to->head = obj;
-    else
-        to->tail->p_next = NstOBJ(obj);
-    obj->p_prev = NstOBJ(to->tail);
-    obj->p_next = NULL;
-    to->tail = obj;
-    to->len++;
+// Halves the capacity of a list when it is less than a quarter full
+static void shrink_gen(Nst_GGCList *gen)
+{
+    if (gen->cap <= GEN_MIN_CAP || gen->len >= gen->cap / 4)
+        return;
 
-    obj->ggc_list = to;
+    Nst_GGCObj **objs = (Nst_GGCObj **)Nst_raw_realloc(
+        gen->objs,
+        gen->cap / 2 * sizeof(Nst_GGCObj *));
+    if (objs == NULL)
+        return;
+    gen->objs = objs;
+    gen->cap /= 2;
 }
 
-static void move_list(Nst_GGCList *from, Nst_GGCList *to)
+static inline void set_obj(Nst_GGCList *gen, usize idx, Nst_GGCObj *obj)
 {
-    if (from->head == NULL)
-        return;
+    gen->objs[idx] = obj;
+    obj->ggc_idx = (u32)idx;
+}
 
-    for (Nst_GGCObj *cursor = from->head;
-        cursor != NULL;
-        cursor = GGC_OBJ(cursor->p_next))
-    {
-        cursor->ggc_list = to;
+/**
+ * Adds an object at the end of a list. When the list cannot grow the object
+ * is left untracked: it is freed only when its reference count reaches zero,
+ * which can leak cycles but never frees a reachable object.
+ */
+static inline void append_obj(Nst_GGCObj *obj, GenID to)
+{
+    Nst_GGCList *gen = GEN(to);
+    if (gen->len >= (usize)UINT32_MAX || !reserve_gen(gen, gen->len + 1)) {
+        obj->ggc_gen = GEN_NONE;
+        return;
     }
+    set_obj(gen, gen->len, obj);
+    gen->len++;
+    obj->ggc_gen = to;
+}
 
-    if (to->head == NULL) {
-        to->head = from->head;
-        to->tail = from->tail;
-        to->len = from->len;
-        from->head = NULL;
-        from->tail = NULL;
-        from->len = 0;
-        return;
+static inline void remove_obj(Nst_GGCObj *obj)
+{
+    Nst_GGCList *gen = GEN(obj->ggc_gen);
+    usize idx = obj->ggc_idx;
+
+    // the hole is filled with the last visited object so that the objects
+    // before the cursor are still the visited ones
+    if (obj->ggc_gen == ggc.old_scan && idx < ggc.cursor) {
+        ggc.cursor--;
+        set_obj(gen, idx, gen->objs[ggc.cursor]);
+        idx = ggc.cursor;
     }
 
-    from->head->p_prev = NstOBJ(to->tail);
-    to->tail->p_next = NstOBJ(from->head);
-    to->tail = from->tail;
-    to->len += from->len;
+    gen->len--;
+    if (idx != gen->len)
+        set_obj(gen, idx, gen->objs[gen->len]);
+}
+
+static inline void move_obj(Nst_GGCObj *obj, GenID to)
+{
+    remove_obj(obj);
+    append_obj(obj, to);
+}
+
+static void move_list(GenID from_id, GenID to_id)
+{
+    Nst_GGCList *from = GEN(from_id);
+    Nst_GGCList *to = GEN(to_id);
 
-    from->head = NULL;
-    from->tail = NULL;
+    reserve_gen(to, to->len + from->len);
+    for (usize i = 0; i < from->len; i++)
+        append_obj(from->objs[i], to_id);
     from->len = 0;
 }
 
 static inline void remove_objs_list(Nst_GGCList *gen)
 {
-    for (Nst_GGCObj *ob = gen->head; ob != NULL; ob = GGC_OBJ(ob->p_next)) {
-        ob->ggc_list = NULL;
-        Nst_SET_FLAG(ob, Nst_FLAG_GGC_PRESERVE_MEM);
+    for (usize i = 0; i < gen->len; i++) {
+        gen->objs[i]->ggc_gen = GEN_NONE;
+        Nst_SET_FLAG(gen->objs[i], Nst_FLAG_GGC_PRESERVE_MEM);
     }
 }
 
 static inline void call_objs_destructor(Nst_GGCList *gen)
 {
-    for (Nst_GGCObj *ob = gen->head; ob != NULL; ob = GGC_OBJ(ob->p_next)) {
-        Nst_assert_c(ob->ggc_list == NULL);
-        _Nst_obj_destroy(NstOBJ(ob));
+    for (usize i = 0; i < gen->len; i++) {
+        Nst_assert_c(gen->objs[i]->ggc_gen == GEN_NONE);
+        _Nst_obj_destroy(NstOBJ(gen->objs[i]));
     }
 }
 
 static inline void free_obj_memory(Nst_GGCList *gen)
 {
-    Nst_GGCObj *new_ob = NULL;
-    for (Nst_GGCObj *ob = gen->head; ob != NULL;) {
-        new_ob = GGC_OBJ(ob->p_next);
-        Nst_DEL_FLAG(ob, Nst_FLAG_GGC_PRESERVE_MEM);
-        _Nst_obj_free(NstOBJ(ob));
-        ob = new_ob;
+    for (usize i = 0; i < gen->len; i++) {
+        Nst_DEL_FLAG(gen->objs[i], Nst_FLAG_GGC_PRESERVE_MEM);
+        _Nst_obj_free(NstOBJ(gen->objs[i]));
     }
+    gen->len = 0;
 }
 
 /**
  * Object destruction process:
  *
- * 1. Remove the pointer in the objects pointing to the Nst_GGCList to NULL to
- *    signal that they are being deleted during a collection and to not remove
- *    the object from the list when it is freed.
+ * 1. Set the ggc_gen of the objects to GEN_NONE to signal that they are being
+ *    deleted during a collection and to not remove the object from the list
+ *    when it is freed.
  *    In this pass the Nst_FLAG_GGC_PRESERVE_MEM is also added to signal that
  *    the object's memory should not be freed even if the reference count
  *    reaches zero.
@@ -160,172 +274,396 @@ static inline void destroy_objects(Nst_GGCList *gen)
  * 7. Delete the unreachable objects.
 */
 
-static void collect_gen(Nst_GGCList *gen)
+static void collect_gen(GenID gen_id)
 {
+    Nst_GGCList *gen = GEN(gen_id);
     // Unreachable values
-    Nst_GGCList uv = { NULL, NULL, 0 };
+    Nst_GGCList *uv = GEN(GEN_UNREACHABLE);
 
-    Nst_GGCObj *ob = NULL;
-    Nst_GGCObj *new_ob = NULL;
-    for (ob = gen->head; ob != NULL; ob = GGC_OBJ(ob->p_next))
-        ob->ggc_ref_count = ob->ref_count;
+    // all the objects can be moved to the unreachable list and back without
+    // allocating memory
+    if (!reserve_gen(uv, gen->len))
+        return;
+
+    for (usize i = 0; i < gen->len; i++)
+        gen->objs[i]->ggc_ref_count = gen->objs[i]->ref_count;
 
-    for (ob = gen->head; ob != NULL; ob = GGC_OBJ(ob->p_next))
-        Nst_obj_traverse(NstOBJ(ob));
+    for (usize i = 0; i < gen->len; i++)
+        Nst_obj_traverse(NstOBJ(gen->objs[i]));
 
-    for (ob = gen->head; ob != NULL;) {
-        new_ob = GGC_OBJ(ob->p_next);
+    // the list is walked backwards since removing an object moves the last
+    // one in its place
+    for (usize i = gen->len; i-- > 0;) {
+        Nst_GGCObj *ob = gen->objs[i];
         if (ob->ggc_ref_count == 0) {
             Nst_DEL_FLAG(ob, Nst_FLAG_GGC_REACHABLE);
-            move_obj(ob, gen, &uv);
+            move_obj(ob, GEN_UNREACHABLE);
         }
-        ob = new_ob;
     }
 
     if (gen->len == 0) {
-        destroy_objects(&uv);
+        destroy_objects(uv);
         return;
     }
 
-    for (ob = gen->head; ob != NULL; ob = GGC_OBJ(ob->p_next))
-        Nst_obj_traverse(NstOBJ(ob));
+    usize traversed = 0;
+    for (; traversed < gen->len; traversed++)
+        Nst_obj_traverse(NstOBJ(gen->objs[traversed]));
 
     while (true) {
-        Nst_GGCObj *last_traversed = gen->tail;
-        for (ob = uv.head; ob != NULL;) {
-            new_ob = GGC_OBJ(ob->p_next);
+        for (usize i = uv->len; i-- > 0;) {
+            Nst_GGCObj *ob = uv->objs[i];
             if (Nst_HAS_FLAG(ob, Nst_FLAG_GGC_REACHABLE))
-                move_obj(ob, &uv, gen);
-            ob = new_ob;
+                move_obj(ob, gen_id);
         }
 
         // if no new objects were appended back to the reachable ones
-        if (last_traversed->p_next == NULL)
+        if (traversed == gen->len)
             break;
 
-        for (ob = GGC_OBJ(last_traversed->p_next);
-             ob != NULL;
-             ob = GGC_OBJ(ob->p_next))
-        {
+        for (; traversed < gen->len; traversed++)
+            Nst_obj_traverse(NstOBJ(gen->objs[traversed]));
+    }
+
+    destroy_objects(uv);
+}
+
+static u64 time_ns(void)
+{
+#ifdef Nst_MSVC
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (u64)(count.QuadPart / freq.QuadPart) * 1000000000
+         + (u64)(count.QuadPart % freq.QuadPart) * 1000000000
+         / (u64)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000 + (u64)ts.tv_nsec;
+#endif // !Nst_MSVC
+}
+
+static void record_pause(PauseStats *stats, u64 pause_ns)
+{
+    usize bucket = 0;
+    for (u64 us = pause_ns / 1000; us != 0; us >>= 1)
+        bucket++;
+    if (bucket >= PAUSE_BUCKETS)
+        bucket = PAUSE_BUCKETS - 1;
+
+    stats->hist[bucket]++;
+    stats->count++;
+    stats->total_ns += pause_ns;
+    if (pause_ns > stats->max_ns)
+        stats->max_ns = pause_ns;
+}
+
+/**
+ * Collection of the old generation:
+ *
+ * The old generation is collected in steps that visit at most `ggc.step`
+ * objects and references each, so that the program does not pause for the
+ * whole collection.
+ *
+ * 1. OLD_COPY: the ggc_ref_count of the objects is set to their ref_count.
+ * 2. OLD_SUBTRACT: the objects are traversed to subtract the references that
+ *    they have between each other.
+ * 3. OLD_MARK: the objects with a positive ggc_ref_count are referenced from
+ *    outside the generation and are put in the grey list, the others are put
+ *    in the white list. The objects in the grey list are traversed and moved
+ *    to the old generation, any object found by the traversal that is still
+ *    in old_scan or in the white list is moved to the grey list.
+ * 4. The white list is collected with collect_gen.
+ *
+ * The program runs between the steps and can change the references of the
+ * objects, which makes the counts and the marks approximate. The objects
+ * left in the white list are then only candidates: collect_gen checks them
+ * again using their current ref_count and frees only the ones that are
+ * referenced exclusively by other candidates. A candidate that gained a
+ * reference from any other object or from the stack is kept.
+ */
+
+static void old_gen_start(void)
+{
+    ggc.old_scan = ggc.old_gen;
+    ggc.old_gen = ggc.old_scan == GEN_OLD_A ? GEN_OLD_B : GEN_OLD_A;
+    ggc.cursor = 0;
+    ggc.phase = OLD_COPY;
+    ggc.old_gen_pending = 0;
+}
+
+static void old_gen_finish(void)
+{
+    ggc.phase = OLD_IDLE;
+    ggc.old_scan = GEN_NONE;
+    ggc.cursor = 0;
+
+    collect_gen(GEN_WHITE);
+    move_list(GEN_WHITE, ggc.old_gen);
+}
+
+static void old_gen_step(void)
+{
+    // the work of a step is measured as the number of objects visited plus
+    // the number of references found by their traversal
+    usize start = ggc.visited;
+    usize budget = ggc.step == 0 ? (usize)-1 : ggc.step;
+    Nst_GGCList *scan = GEN(ggc.old_scan);
+    Nst_GGCList *grey = GEN(GEN_GREY);
+
+    if (ggc.phase == OLD_COPY) {
+        while (ggc.visited - start < budget && ggc.cursor < scan->len) {
+            Nst_GGCObj *ob = scan->objs[ggc.cursor++];
+            ob->ggc_ref_count = ob->ref_count;
+            ggc.visited++;
+        }
+        if (ggc.cursor < scan->len)
+            return;
+        ggc.cursor = 0;
+        ggc.phase = OLD_SUBTRACT;
+    }
+
+    if (ggc.phase == OLD_SUBTRACT) {
+        while (ggc.visited - start < budget && ggc.cursor < scan->len) {
+            Nst_GGCObj *ob = scan->objs[ggc.cursor++];
             Nst_obj_traverse(NstOBJ(ob));
+            ggc.visited++;
         }
+        if (ggc.cursor < scan->len)
+            return;
+        ggc.cursor = 0;
+        ggc.phase = OLD_MARK;
     }
 
-    destroy_objects(&uv);
+    while (ggc.visited - start < budget) {
+        ggc.visited++;
+        if (grey->len != 0) {
+            Nst_GGCObj *ob = grey->objs[grey->len - 1];
+            Nst_obj_traverse(NstOBJ(ob));
+            move_obj(ob, ggc.old_gen);
+            continue;
+        }
+
+        if (ggc.cursor == scan->len) {
+            scan->len = 0;
+            old_gen_finish();
+            return;
+        }
+        // the objects are taken in order and their slots are left behind
+        // instead of being filled, the oldest objects usually reference the
+        // newer ones which can then skip the white list
+        Nst_GGCObj *ob = scan->objs[ggc.cursor++];
+        append_obj(ob, ob->ggc_ref_count > 0 ? GEN_GREY : GEN_WHITE);
+    }
 }
 
 void _Nst_ggc_quit(void)
 {
-    remove_objs_list(&ggc.gen1);
-    remove_objs_list(&ggc.gen2);
-    remove_objs_list(&ggc.gen3);
-    remove_objs_list(&ggc.old_gen);
-
-    call_objs_destructor(&ggc.gen1);
-    call_objs_destructor(&ggc.gen2);
-    call_objs_destructor(&ggc.gen3);
-    call_objs_destructor(&ggc.old_gen);
-
-    free_obj_memory(&ggc.gen1);
-    free_obj_memory(&ggc.gen2);
-    free_obj_memory(&ggc.gen3);
-    free_obj_memory(&ggc.old_gen);
+    // during OLD_MARK the slots before the cursor still point to the objects
+    // that have already been moved to another list
+    if (ggc.phase == OLD_MARK) {
+        Nst_GGCList *scan = GEN(ggc.old_scan);
+        memmove(
+            scan->objs,
+            scan->objs + ggc.cursor,
+            (scan->len - ggc.cursor) * sizeof(Nst_GGCObj *));
+        scan->len -= ggc.cursor;
+    }
+
+    ggc.phase = OLD_IDLE;
+    ggc.old_scan = GEN_NONE;
+    ggc.cursor = 0;
+
+    for (usize i = GEN_1; i < GEN_COUNT; i++)
+        remove_objs_list(GEN(i));
+    for (usize i = GEN_1; i < GEN_COUNT; i++)
+        call_objs_destructor(GEN(i));
+    for (usize i = GEN_1; i < GEN_COUNT; i++) {
+        free_obj_memory(GEN(i));
+        Nst_free(GEN(i)->objs);
+        GEN(i)->objs = NULL;
+        GEN(i)->cap = 0;
+    }
 }
 
 void _Nst_ggc_init(void)
 {
-    Nst_GGCList gen1 = { NULL, NULL, 0 };
-    Nst_GGCList gen2 = { NULL, NULL, 0 };
-    Nst_GGCList gen3 = { NULL, NULL, 0 };
-    Nst_GGCList old_gen = { NULL, NULL, 0 };
-    ggc.gen1 = gen1;
-    ggc.gen2 = gen2;
-    ggc.gen3 = gen3;
-    ggc.old_gen = old_gen;
+    for (usize i = 0; i < GEN_COUNT; i++) {
+        GEN(i)->objs = NULL;
+        GEN(i)->len = 0;
+        GEN(i)->cap = 0;
+    }
+    ggc.old_gen = GEN_OLD_A;
+    ggc.old_scan = GEN_NONE;
+    ggc.cursor = 0;
+    ggc.phase = OLD_IDLE;
+    ggc.visited = 0;
+    ggc.step = _Nst_OLD_GEN_STEP;
     ggc.old_gen_pending = 0;
+    ggc.record_pauses = false;
+    memset(&ggc.young_pauses, 0, sizeof(PauseStats));
+    memset(&ggc.old_pauses, 0, sizeof(PauseStats));
+}
+
+void _Nst_ggc_untrack_obj(Nst_GGCObj *obj)
+{
+    // objects that are being deleted by a collection are not in any list
+    if (obj->ggc_gen == GEN_NONE)
+        return;
+    remove_obj(obj);
+    obj->ggc_gen = GEN_NONE;
 }
 
 void Nst_ggc_obj_reachable(Nst_Obj *obj)
 {
-    if (Nst_HAS_FLAG(obj, Nst_FLAG_GGC_IS_SUPPORTED)) {
-        Nst_SET_FLAG(obj, Nst_FLAG_GGC_REACHABLE);
-        GGC_OBJ(obj)->ggc_ref_count--;
+    ggc.visited++;
+    if (!Nst_HAS_FLAG(obj, Nst_FLAG_GGC_IS_SUPPORTED))
+        return;
+
+    Nst_SET_FLAG(obj, Nst_FLAG_GGC_REACHABLE);
+    GGC_OBJ(obj)->ggc_ref_count--;
+
+    if (ggc.phase != OLD_MARK)
+        return;
+
+    u32 gen = GGC_OBJ(obj)->ggc_gen;
+    if (gen == ggc.old_scan || gen == GEN_WHITE)
+        move_obj(GGC_OBJ(obj), GEN_GREY);
+}
+
+void Nst_ggc_set_step(usize step)
+{
+    ggc.step = step;
+}
+
+void Nst_ggc_record_pauses(bool record)
+{
+    ggc.record_pauses = record;
+}
+
+static void print_pause_summary(const char *name, PauseStats *stats)
+{
+    Nst_printf(
+        "%-18s %10" PRIu64 " pauses, %10.3f ms total, %10.3f ms longest\n",
+        name,
+        stats->count,
+        (f64)stats->total_ns / 1e6,
+        (f64)stats->max_ns / 1e6);
+}
+
+void Nst_ggc_print_pauses(void)
+{
+    usize first = PAUSE_BUCKETS;
+    usize last = 0;
+    for (usize i = 0; i < PAUSE_BUCKETS; i++) {
+        if (ggc.young_pauses.hist[i] == 0 && ggc.old_pauses.hist[i] == 0)
+            continue;
+        if (first == PAUSE_BUCKETS)
+            first = i;
+        last = i;
+    }
+
+    Nst_println("\nGarbage collector pauses:");
+    print_pause_summary("young generations", &ggc.young_pauses);
+    print_pause_summary("old generation", &ggc.old_pauses);
+    if (first == PAUSE_BUCKETS)
+        return;
+
+    Nst_printf("\n%18s %18s %18s\n", "pause time", "young", "old");
+    for (usize i = first; i <= last; i++) {
+        Nst_printf(
+            "    < %10" PRIu64 " us %18" PRIu64 " %18" PRIu64 "\n",
+            (u64)1 << i,
+            ggc.young_pauses.hist[i],
+            ggc.old_pauses.hist[i]);
     }
 }
 
 void Nst_ggc_collect(void)
 {
-    if (ggc.gen1.len > _Nst_GEN1_MAX)
+    Nst_GGCList *gen1 = GEN(GEN_1);
+    Nst_GGCList *gen2 = GEN(GEN_2);
+    Nst_GGCList *gen3 = GEN(GEN_3);
+
+    if (gen1->len <= _Nst_GEN1_MAX)
         return;
 
-    usize old_gen_size = ggc.old_gen.len;
+    u64 start_ns = ggc.record_pauses ? time_ns() : 0;
+    bool has_collected_old_gen = false;
+
+    usize old_gen_size = GEN(ggc.old_gen)->len;
     // if the number of objects never checked in the old generation
-    // is more than 25% and there are at least 10 objects
-    if (old_gen_size > _Nst_OLD_GEN_MIN
+    // is more than 25% and there are at least 100 objects
+    if (ggc.phase == OLD_IDLE
+        && old_gen_size > _Nst_OLD_GEN_MIN
         && ggc.old_gen_pending >= (i64)old_gen_size >> 2)
     {
-        collect_gen(&ggc.old_gen);
-        ggc.old_gen_pending = 0;
+        old_gen_start();
+    }
+
+    if (ggc.phase != OLD_IDLE) {
+        old_gen_step();
+        has_collected_old_gen = true;
     }
 
     bool has_collected_gen1 = false;
     bool has_collected_gen2 = false;
 
     // Collect the generations if they are over their maximum value
-    if (ggc.gen1.len > _Nst_GEN1_MAX) {
-        collect_gen(&ggc.gen1);
+    if (gen1->len > _Nst_GEN1_MAX) {
+        collect_gen(GEN_1);
         has_collected_gen1 = true;
     }
 
-    if (ggc.gen2.len > _Nst_GEN2_MAX
+    if (gen2->len > _Nst_GEN2_MAX
         || (has_collected_gen1
-            && ggc.gen1.len + ggc.gen2.len > _Nst_GEN2_MAX))
+            && gen1->len + gen2->len > _Nst_GEN2_MAX))
     {
-        collect_gen(&ggc.gen2);
+        collect_gen(GEN_2);
         has_collected_gen2 = true;
     }
 
-    if (ggc.gen3.len > _Nst_GEN3_MAX
+    if (gen3->len > _Nst_GEN3_MAX
         || (has_collected_gen2
-            && ggc.gen2.len + ggc.gen3.len > _Nst_GEN3_MAX))
+            && gen2->len + gen3->len > _Nst_GEN3_MAX))
     {
-        collect_gen(&ggc.gen3);
-        ggc.old_gen_pending += ggc.gen3.len;
-        move_list(&ggc.gen3, &ggc.old_gen);
+        collect_gen(GEN_3);
+        ggc.old_gen_pending += gen3->len;
+        move_list(GEN_3, ggc.old_gen);
     }
 
     if (has_collected_gen2) {
-        if (ggc.gen2.len + ggc.gen3.len > _Nst_GEN3_MAX) {
-            ggc.old_gen_pending += ggc.gen2.len;
-            move_list(&ggc.gen2, &ggc.old_gen);
+        if (gen2->len + gen3->len > _Nst_GEN3_MAX) {
+            ggc.old_gen_pending += gen2->len;
+            move_list(GEN_2, ggc.old_gen);
         } else
-            move_list(&ggc.gen2, &ggc.gen3);
+            move_list(GEN_2, GEN_3);
     }
 
     if (has_collected_gen1) {
-        if (ggc.gen1.len + ggc.gen2.len > _Nst_GEN2_MAX) {
-            if (ggc.gen1.len + ggc.gen3.len > _Nst_GEN3_MAX) {
-                ggc.old_gen_pending += ggc.gen1.len;
-                move_list(&ggc.gen1, &ggc.old_gen);
+        if (gen1->len + gen2->len > _Nst_GEN2_MAX) {
+            if (gen1->len + gen3->len > _Nst_GEN3_MAX) {
+                ggc.old_gen_pending += gen1->len;
+                move_list(GEN_1, ggc.old_gen);
             } else
-                move_list(&ggc.gen1, &ggc.gen3);
+                move_list(GEN_1, GEN_3);
         } else
-            move_list(&ggc.gen1, &ggc.gen2);
+            move_list(GEN_1, GEN_2);
+    }
+
+    for (usize i = GEN_1; i < GEN_COUNT; i++)
+        shrink_gen(GEN(i));
+
+    if (ggc.record_pauses) {
+        record_pause(
+            has_collected_old_gen ? &ggc.old_pauses : &ggc.young_pauses,
+            time_ns() - start_ns);
     }
 }
 
 void Nst_ggc_track_obj(Nst_GGCObj *obj)
 {
     Nst_assert(Nst_type_trav(obj->type) != NULL);
-
-    if (ggc.gen1.len == 0)
-        ggc.gen1.head = obj;
-    else {
-        obj->p_prev = NstOBJ(ggc.gen1.tail);
-        ggc.gen1.tail->p_next = NstOBJ(obj);
-    }
-
-    ggc.gen1.tail = obj;
-    obj->ggc_list = &ggc.gen1;
-    ggc.gen1.len++;
+    append_obj(obj, GEN_1);
 }
@@ -75,6 +75,15 @@ bool _Nst_globals_init(void)
         "Iter",
         (Nst_ObjDstr)_Nst_iter_destroy,
         (Nst_ObjTrav)_Nst_iter_traverse);
+    Nst_t.IntArray = Nst_type_new(
+        "IntArray",
+        (Nst_ObjDstr)_Nst_typed_array_destroy);
+    Nst_t.RealArray = Nst_type_new(
+        "RealArray",
+        (Nst_ObjDstr)_Nst_typed_array_destroy);
+    Nst_t.ByteArray = Nst_type_new(
+        "ByteArray",
+        (Nst_ObjDstr)_Nst_typed_array_destroy);
 
     Nst_s.t_Type   = Nst_str_new((u8 *)"Type",   4, false);
     Nst_s.t_Int    = Nst_str_new((u8 *)"Int",    3, false);
@@ -90,6 +99,9 @@ bool _Nst_globals_init(void)
     Nst_s.t_Byte   = Nst_str_new((u8 *)"Byte",   4, false);
     Nst_s.t_IOFile = Nst_str_new((u8 *)"IOFile", 6, false);
     Nst_s.t_IEnd   = Nst_str_new((u8 *)"IEnd",   4, false);
+    Nst_s.t_IntArray  = Nst_str_new((u8 *)"IntArray",  8, false);
+    Nst_s.t_RealArray = Nst_str_new((u8 *)"RealArray", 9, false);
+    Nst_s.t_ByteArray = Nst_str_new((u8 *)"ByteArray", 9, false);
 
     Nst_s.c_true   = Nst_str_new((u8 *)"true",  4, false);
     Nst_s.c_false  = Nst_str_new((u8 *)"false", 5, false);
@@ -155,6 +167,12 @@ bool _Nst_globals_init(void)
     Nst_itf.seq_next  = Nst_func_new_c(1, Nst_iter_seq_next);
     Nst_itf.map_start = Nst_func_new_c(1, Nst_iter_map_start);
     Nst_itf.map_next  = Nst_func_new_c(1, Nst_iter_map_next);
+    Nst_itf.typed_array_start = Nst_func_new_c(
+        1,
+        Nst_iter_typed_array_start);
+    Nst_itf.typed_array_next  = Nst_func_new_c(
+        1,
+        Nst_iter_typed_array_next);
 
     if (Nst_error_occurred()) {
         Nst_error_clear();
@@ -180,6 +198,9 @@ void _Nst_globals_quit(void)
     Nst_ndec_ref(Nst_t.Byte);
     Nst_ndec_ref(Nst_t.IOFile);
     Nst_ndec_ref(Nst_t.IEnd);
+    Nst_ndec_ref(Nst_t.IntArray);
+    Nst_ndec_ref(Nst_t.RealArray);
+    Nst_ndec_ref(Nst_t.ByteArray);
 
     Nst_ndec_ref(Nst_s.t_Type);
     Nst_ndec_ref(Nst_s.t_Int);
@@ -195,6 +216,9 @@ void _Nst_globals_quit(void)
     Nst_ndec_ref(Nst_s.t_Byte);
     Nst_ndec_ref(Nst_s.t_IOFile);
     Nst_ndec_ref(Nst_s.t_IEnd);
+    Nst_ndec_ref(Nst_s.t_IntArray);
+    Nst_ndec_ref(Nst_s.t_RealArray);
+    Nst_ndec_ref(Nst_s.t_ByteArray);
 
     Nst_ndec_ref(Nst_s.c_true);
     Nst_ndec_ref(Nst_s.c_false);
@@ -246,6 +270,8 @@ void _Nst_globals_quit(void)
     Nst_ndec_ref(Nst_itf.seq_next);
     Nst_ndec_ref(Nst_itf.map_start);
     Nst_ndec_ref(Nst_itf.map_next);
+    Nst_ndec_ref(Nst_itf.typed_array_start);
+    Nst_ndec_ref(Nst_itf.typed_array_next);
 }
 
 Nst_Obj *Nst_true(void)
@@ -1,10 +1,25 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "nest.h"
 
-#define FNV_OFFSET_BASIS 0xcbf29ce484222325
-#define FNV_PRIME 0x00000100000001B3
+#if defined(Nst_MSVC) && defined(_Nst_ARCH_x64)
+#include <intrin.h>
+#pragma intrinsic(_umul128)
+#endif
+
 #define LOWER_HALF 0xffffffff
 
+// secrets of wyhash, see https://github.com/wangyi-fudan/wyhash
+#define WY_P0 0xa0761d6478bd642fULL
+#define WY_P1 0xe7037ed1a0b428dbULL
+#define WY_P2 0x8ebc6af09c88c6e3ULL
+#define WY_P3 0x589965cc75374cc3ULL
+
+static u64 hash_seed = 0;
+
 static i32 hash_str(Nst_Obj *str);
 static i32 hash_int(Nst_Obj *num);
 static i32 hash_byte(Nst_Obj *byte);
@@ -48,19 +63,103 @@ static i32 hash_ptr(void *ptr)
     return (i32)x == -1 ? -2 : (i32)x;
 }
 
-static i32 hash_str(Nst_Obj *str)
+// Multiplies `a` and `b` setting `a` to the lower half and `b` to the upper
+// half of the 128-bit result
+static inline void mul128(u64 *a, u64 *b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#elif defined(Nst_MSVC) && defined(_Nst_ARCH_x64)
+    *a = _umul128(*a, *b, b);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline u64 mix(u64 a, u64 b)
+{
+    mul128(&a, &b);
+    return a ^ b;
+}
+
+static inline u64 read64(const u8 *p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline u64 read32(const u8 *p)
+{
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// reads one to three bytes
+static inline u64 read_small(const u8 *p, usize len)
+{
+    return ((u64)p[0] << 16) | ((u64)p[len >> 1] << 8) | p[len - 1];
+}
+
+static u64 hash_bytes(const u8 *p, usize len, u64 seed)
 {
-    // taken from https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
-    i64 hash = FNV_OFFSET_BASIS;
-    u8 *s = Nst_str_value(str);
-    u8 *s_end = s + Nst_str_len(str);
-
-    while (s != s_end) {
-        hash ^= *s++;
-        hash *= FNV_PRIME;
+    // this is wyhash, which reads the input eight bytes at a time
+    u64 a, b;
+    seed ^= mix(seed ^ WY_P0, WY_P1);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            usize offset = (len >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + offset);
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - offset);
+        } else if (len > 0) {
+            a = read_small(p, len);
+            b = 0;
+        } else
+            a = b = 0;
+    } else {
+        usize i = len;
+        if (i > 48) {
+            u64 seed1 = seed, seed2 = seed;
+            do {
+                seed = mix(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+                seed1 = mix(read64(p + 16) ^ WY_P2, read64(p + 24) ^ seed1);
+                seed2 = mix(read64(p + 32) ^ WY_P3, read64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = mix(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
     }
 
-    return (i32)((hash >> 32) ^ (hash & LOWER_HALF));
+    a ^= WY_P1;
+    b ^= seed;
+    mul128(&a, &b);
+    return mix(a ^ WY_P0 ^ len, b ^ WY_P1);
+}
+
+static i32 hash_str(Nst_Obj *str)
+{
+    u64 hash = hash_bytes(Nst_str_value(str), Nst_str_len(str), hash_seed);
+    i32 folded = (i32)((hash >> 32) ^ (hash & LOWER_HALF));
+    return folded == -1 ? -2 : folded;
 }
 
 static i32 hash_int(Nst_Obj *num)
@@ -73,3 +172,48 @@ static i32 hash_byte(Nst_Obj *byte)
 {
     return (i32)(Nst_byte_u8(byte));
 }
+
+static u64 random_seed(void)
+{
+    // the seed does not need to be cryptographically secure, it only needs to
+    // be hard to predict from outside the process
+    u64 seed = (u64)time(NULL);
+    seed = mix(seed ^ WY_P0, (u64)clock() ^ WY_P1);
+    seed = mix(seed ^ WY_P2, (u64)(usize)&seed ^ WY_P3);
+    seed = mix(seed ^ WY_P1, (u64)(usize)&random_seed ^ WY_P0);
+    return seed;
+}
+
+bool _Nst_hash_init(void)
+{
+    const char *seed_str = getenv("NEST_HASHSEED");
+    if (seed_str == NULL || *seed_str == '\0') {
+        hash_seed = 0;
+        return true;
+    } else if (strcmp(seed_str, "random") == 0) {
+        hash_seed = random_seed();
+        return true;
+    }
+
+    // the error machinery is not ready yet since the global objects are
+    // created after the seed is chosen, the message is printed directly
+    char *end = NULL;
+    errno = 0;
+    u64 seed = (u64)strtoull(seed_str, &end, 10);
+    if (*seed_str < '0' || *seed_str > '9' || *end != '\0' || errno != 0) {
+        fprintf(
+            stderr,
+            "NEST_HASHSEED must be 'random' or an unsigned integer, got "
+            "'%.100s'\n",
+            seed_str);
+        fflush(stderr);
+        return false;
+    }
+    hash_seed = seed;
+    return true;
+}
+
+u64 Nst_hash_seed(void)
+{
+    return hash_seed;
+}
@@ -55,6 +55,13 @@ Nst_Inst *Nst_ilist_get_inst(Nst_InstList *list, usize idx)
 Nst_Obj *Nst_ilist_get_inst_obj(Nst_InstList *list, usize idx)
 {
     Nst_Inst *inst = Nst_ilist_get_inst(list, idx);
+    if (inst->code == Nst_IC_PUSH_STACK_OP
+        || inst->code == Nst_IC_GET_STACK_OP)
+    {
+        return NstOBJ(Nst_pa_get(
+            &list->objects,
+            Nst_INST_FUSED_OBJ(inst->val)));
+    }
     return NstOBJ(Nst_pa_get(&list->objects, (usize)inst->val));
 }
 
@@ -123,6 +130,42 @@ void Nst_fprototype_destroy(Nst_FuncPrototype *fp)
     Nst_ilist_destroy(&fp->ilist);
 }
 
+static void print_op(i64 op)
+{
+    switch (op) {
+    case Nst_TT_ADD:     Nst_print("+");  break;
+    case Nst_TT_SUB:     Nst_print("-");  break;
+    case Nst_TT_MUL:     Nst_print("*");  break;
+    case Nst_TT_DIV:     Nst_print("/");  break;
+    case Nst_TT_POW:     Nst_print("^");  break;
+    case Nst_TT_MOD:     Nst_print("%");  break;
+    case Nst_TT_B_AND:   Nst_print("&");  break;
+    case Nst_TT_B_OR:    Nst_print("|");  break;
+    case Nst_TT_LEN:     Nst_print("$");  break;
+    case Nst_TT_L_NOT:   Nst_print("!");  break;
+    case Nst_TT_B_NOT:   Nst_print("~");  break;
+    case Nst_TT_GT:      Nst_print(">");  break;
+    case Nst_TT_LT:      Nst_print("<");  break;
+    case Nst_TT_B_XOR:   Nst_print("^^"); break;
+    case Nst_TT_LSHIFT:  Nst_print("<<"); break;
+    case Nst_TT_RSHIFT:  Nst_print(">>"); break;
+    case Nst_TT_CONCAT:  Nst_print("><"); break;
+    case Nst_TT_L_AND:   Nst_print("&&"); break;
+    case Nst_TT_L_OR:    Nst_print("||"); break;
+    case Nst_TT_L_XOR:   Nst_print("&|"); break;
+    case Nst_TT_EQ:      Nst_print("=="); break;
+    case Nst_TT_NEQ:     Nst_print("!="); break;
+    case Nst_TT_GTE:     Nst_print(">="); break;
+    case Nst_TT_LTE:     Nst_print("<="); break;
+    case Nst_TT_NEG:     Nst_print("-:"); break;
+    case Nst_TT_STDOUT:  Nst_print(">>>");break;
+    case Nst_TT_STDIN:   Nst_print("<<<");break;
+    case Nst_TT_TYPEOF:  Nst_print("?::");break;
+    case Nst_TT_CONTAINS:Nst_print("<.>");break;
+    default: Nst_assert(false);
+    }
+}
+
 static void print_bytecode(Nst_InstList *ls, i32 indent)
 {
     usize tot_size = ls->instructions.len;
@@ -197,12 +240,12 @@ static void print_bytecode(Nst_InstList *ls, i32 indent)
         case Nst_IC_JUMPIF_ZERO:   Nst_print("JUMPIF_ZERO  "); break;
         case Nst_IC_THROW_ERR:     Nst_print("THROW_ERR    "); break;
         case Nst_IC_PUSH_CATCH:    Nst_print("PUSH_CATCH   "); break;
-        case Nst_IC_POP_CATCH:     Nst_print("POP_CATCH    "); break;
         case Nst_IC_SET_VAL:       Nst_print("SET_VAL      "); break;
         case Nst_IC_GET_VAL:       Nst_print("GET_VAL      "); break;
         case Nst_IC_PUSH_VAL:      Nst_print("PUSH_VAL     "); break;
         case Nst_IC_SET_CONT_VAL:  Nst_print("SET_CONT_VAL "); break;
         case Nst_IC_OP_CALL:       Nst_print("OP_CALL      "); break;
+        case Nst_IC_OP_TAIL_CALL:  Nst_print("OP_TAIL_CALL "); break;
         case Nst_IC_OP_SEQ_CALL:   Nst_print("OP_SEQ_CALL  "); break;
         case Nst_IC_OP_CAST:       Nst_print("OP_CAST      "); break;
         case Nst_IC_OP_RANGE:      Nst_print("OP_RANGE     "); break;
@@ -225,6 +268,8 @@ static void print_bytecode(Nst_InstList *ls, i32 indent)
         case Nst_IC_FOR_NEXT:      Nst_print("FOR_NEXT     "); break;
         case Nst_IC_SAVE_ERROR:    Nst_print("SAVE_ERROR   "); break;
         case Nst_IC_UNPACK_SEQ:    Nst_print("UNPACK_SEQ   "); break;
+        case Nst_IC_PUSH_STACK_OP: Nst_print("PUSH_STACK_OP"); break;
+        case Nst_IC_GET_STACK_OP:  Nst_print("GET_STACK_OP "); break;
         default: Nst_assert(false);
         }
 
@@ -243,13 +288,18 @@ static void print_bytecode(Nst_InstList *ls, i32 indent)
             || code == Nst_IC_SET_VAL_LOC)
         {
             Nst_printf(" %*" PRIi64, idx_width, inst->val);
+        } else if (code == Nst_IC_PUSH_STACK_OP
+                   || code == Nst_IC_GET_STACK_OP)
+        {
+            Nst_printf(" %*zi", idx_width, Nst_INST_FUSED_OBJ(inst->val));
         } else {
             Nst_println("");
             continue;
         }
 
         if (code == Nst_IC_PUSH_VAL || code == Nst_IC_GET_VAL
-            || code == Nst_IC_SET_VAL || code == Nst_IC_SET_VAL_LOC)
+            || code == Nst_IC_SET_VAL || code == Nst_IC_SET_VAL_LOC
+            || code == Nst_IC_PUSH_STACK_OP || code == Nst_IC_GET_STACK_OP)
         {
             Nst_Obj *obj = Nst_ilist_get_inst_obj(ls, i);
             Nst_Obj *s = Nst_obj_to_repr_str(obj);
@@ -262,6 +312,11 @@ static void print_bytecode(Nst_InstList *ls, i32 indent)
             Nst_fwrite(Nst_str_value(s), Nst_str_len(s), NULL, Nst_io.out);
             Nst_dec_ref(s);
             Nst_print("]");
+            if (code == Nst_IC_PUSH_STACK_OP || code == Nst_IC_GET_STACK_OP) {
+                Nst_print(" [");
+                print_op(Nst_INST_FUSED_OP(inst->val));
+                Nst_print("]");
+            }
         } else if (code == Nst_IC_MAKE_FUNC) {
             Nst_print("\n\n");
             for (i32 j = 0; j < indent + 1; j++)
@@ -271,39 +326,7 @@ static void print_bytecode(Nst_InstList *ls, i32 indent)
             print_bytecode(&func->ilist, indent + 1);
         } else if (code == Nst_IC_STACK_OP || code == Nst_IC_LOCAL_OP) {
             Nst_print(" [");
-
-            switch (inst->val) {
-            case Nst_TT_ADD:     Nst_print("+");  break;
-            case Nst_TT_SUB:     Nst_print("-");  break;
-            case Nst_TT_MUL:     Nst_print("*");  break;
-            case Nst_TT_DIV:     Nst_print("/");  break;
-            case Nst_TT_POW:     Nst_print("^");  break;
-            case Nst_TT_MOD:     Nst_print("%");  break;
-            case Nst_TT_B_AND:   Nst_print("&");  break;
-            case Nst_TT_B_OR:    Nst_print("|");  break;
-            case Nst_TT_LEN:     Nst_print("$");  break;
-            case Nst_TT_L_NOT:   Nst_print("!");  break;
-            case Nst_TT_B_NOT:   Nst_print("~");  break;
-            case Nst_TT_GT:      Nst_print(">");  break;
-            case Nst_TT_LT:      Nst_print("<");  break;
-            case Nst_TT_B_XOR:   Nst_print("^^"); break;
-            case Nst_TT_LSHIFT:  Nst_print("<<"); break;
-            case Nst_TT_RSHIFT:  Nst_print(">>"); break;
-            case Nst_TT_CONCAT:  Nst_print("><"); break;
-            case Nst_TT_L_AND:   Nst_print("&&"); break;
-            case Nst_TT_L_OR:    Nst_print("||"); break;
-            case Nst_TT_L_XOR:   Nst_print("&|"); break;
-            case Nst_TT_EQ:      Nst_print("=="); break;
-            case Nst_TT_NEQ:     Nst_print("!="); break;
-            case Nst_TT_GTE:     Nst_print(">="); break;
-            case Nst_TT_LTE:     Nst_print("<="); break;
-            case Nst_TT_NEG:     Nst_print("-:"); break;
-            case Nst_TT_STDOUT:  Nst_print(">>>");break;
-            case Nst_TT_STDIN:   Nst_print("<<<");break;
-            case Nst_TT_TYPEOF:  Nst_print("?::");break;
-            case Nst_TT_CONTAINS:Nst_print("<.>");break;
-            default: Nst_assert(false);
-            }
+            print_op(inst->val);
             Nst_print("]");
         }
         Nst_println("");
@@ -13,13 +13,23 @@
 #else
 
 #include <linux/limits.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #endif // !Nst_MSVC
 
-#define CHECK_V_STACK(size) Nst_assert(i_state.v_stack.len >= size)
+#define CHECK_V_STACK(size)                                                   \
+    Nst_assert(i_state.v_stack.len >= i_state.vstack_base + (size))
 #define FAST_TOP (i_state.v_stack.stack[i_state.v_stack.len - 1])
+#define FAST_AT(n) (i_state.v_stack.stack[i_state.v_stack.len - (n)])
+#define OP_COUNT (sizeof(inst_func) / sizeof(inst_func[0]))
+#define OP_PAIRS_PRINTED 20
+#define FOR_UNPACK_MAX 16
+#define PROFILE_INTERVAL_US 1000
+#define PROFILE_MAX_FRAMES 256
+#define PROFILE_LINES_PRINTED 20
 #define OP_OBJ (op_objs[op_arg])
+#define QUICKEN_MAX_DEOPTS 8
 
 typedef enum _InstResult {
     INST_FAILED = -1,
@@ -27,13 +37,47 @@ typedef enum _InstResult {
     INST_NEW_FUNC = 1
 } OpResult;
 
+// A line executed by a frame when a sample was taken, `text` is `NULL` when
+// the instruction has no position
+typedef struct _ProfFrame {
+    Nst_SourceText *text;
+    i32 line;
+} ProfFrame;
+
+// A distinct sequence of frames and the number of samples that contained it,
+// the frames are stored in the table starting from `start`
+typedef struct _ProfEntry {
+    u64 hash;
+    u64 count;
+    usize start;
+    usize len;
+} ProfEntry;
+
+// An open addressing hash table of frame sequences, `cap` is always a power
+// of two and an entry is empty when its count is zero
+typedef struct _ProfTable {
+    ProfEntry *entries;
+    usize len;
+    usize cap;
+    Nst_DynArray frames;
+} ProfTable;
+
 // run the code until the current function completes executing code
 static bool complete_function(void);
+static bool run_frames(void);
 static bool type_check(Nst_Obj *obj, Nst_Obj *type);
 
 static inline void destroy_call(Nst_FuncCall *call);
+static void count_op(i32 *prev_ops, Nst_OpCode op);
+static void print_op_pairs(void);
+static bool profile_start(void);
+static void profile_stop(const char *path);
+static void take_sample(i64 idx);
+static inline void shrink_stacks(void);
 static inline bool unwind_error(usize initial_stack_size);
 
+static bool init_func_vt(Nst_VarTable *vt, Nst_Obj *func, usize arg_num,
+                         Nst_Obj **args);
 static bool push_func(Nst_Obj *func, Nst_Span span, usize arg_num,
                       Nst_Obj **args, Nst_VarTable *vt);
 static Nst_Bytecode *compile_file(Nst_CLArgs *args);
@@ -42,6 +86,19 @@ static bool push_module(const char *filename);
 static inline Nst_Obj *pop_val(void);
 static inline void pop_and_destroy(void);
 static inline bool push_val(Nst_Obj *obj);
+static bool grow_v_stack(void);
+static void drop_vals(usize count);
+static Nst_Obj *call_c_func(Nst_Obj *func, usize arg_num, Nst_Obj **args);
+static Nst_Obj *call_c_func_on_stack(Nst_Obj *func, usize arg_num);
+static Nst_Obj *run_c_body(Nst_Obj *func, usize arg_num, Nst_Obj **args,
+                           usize args_start);
+static OpResult push_c_result(Nst_Obj *res, Nst_Obj *func);
+static bool for_next_unpacked(Nst_Obj *iter, OpResult *result);
+static OpResult fused_stack_op(Nst_Obj *ob2);
+static OpResult set_cont_val(bool loc);
+static inline void rewrite_op(Nst_OpCode code);
+static inline void quicken(Nst_OpCode code);
+static OpResult deopt(Nst_OpCode generic);
 
 static OpResult exe_pop_val(void);
 static OpResult exe_for_start(void);
@@ -51,12 +108,12 @@ static OpResult exe_return_vars(void);
 static OpResult exe_set_val_loc(void);
 static OpResult exe_set_cont_loc(void);
 static OpResult exe_throw_err(void);
-static OpResult exe_pop_catch(void);
 static OpResult exe_set_val(void);
 static OpResult exe_get_val(void);
 static OpResult exe_push_val(void);
 static OpResult exe_set_cont_val(void);
 static OpResult exe_op_call(void);
+static OpResult exe_op_tail_call(void);
 static OpResult exe_op_seq_call(void);
 static OpResult exe_op_cast(void);
 static OpResult exe_op_range(void);
@@ -77,55 +134,71 @@ static OpResult exe_make_map(void);
 static OpResult exe_make_func(void);
 static OpResult exe_save_error(void);
 static OpResult exe_unpack_seq(void);
+static OpResult exe_push_stack_op(void);
+static OpResult exe_get_stack_op(void);
 static OpResult exe_jump(void);
 static OpResult exe_jumpif_t(void);
 static OpResult exe_jumpif_f(void);
 static OpResult exe_jumpif_zero(void);
 static OpResult exe_jumpif_iend(void);
-static OpResult exe_push_catch(void);
+static OpResult exe_extract_seq_int(void);
+static OpResult exe_extract_map(void);
+static OpResult exe_extract_str_int(void);
+static OpResult exe_set_cont_seq_int(void);
+static OpResult exe_set_cont_map(void);
+static OpResult exe_set_cont_loc_seq_int(void);
+static OpResult exe_set_cont_loc_map(void);
 
 static OpResult (*inst_func[])(void) = {
-    [Nst_OP_POP_VAL]      = exe_pop_val,
-    [Nst_OP_FOR_START]    = exe_for_start,
-    [Nst_OP_FOR_NEXT]     = exe_for_next,
-    [Nst_OP_RETURN_VAL]   = exe_return_val,
-    [Nst_OP_RETURN_VARS]  = exe_return_vars,
-    [Nst_OP_SET_VAL_LOC]  = exe_set_val_loc,
-    [Nst_OP_SET_CONT_LOC] = exe_set_cont_loc,
-    [Nst_OP_THROW_ERR]    = exe_throw_err,
-    [Nst_OP_POP_CATCH]    = exe_pop_catch,
-    [Nst_OP_SET_VAL]      = exe_set_val,
-    [Nst_OP_GET_VAL]      = exe_get_val,
-    [Nst_OP_PUSH_VAL]     = exe_push_val,
-    [Nst_OP_SET_CONT_VAL] = exe_set_cont_val,
-    [Nst_OP_CALL]         = exe_op_call,
-    [Nst_OP_SEQ_CALL]     = exe_op_seq_call,
-    [Nst_OP_CAST]         = exe_op_cast,
-    [Nst_OP_RANGE]        = exe_op_range,
-    [Nst_OP_STACK]        = exe_stack_op,
-    [Nst_OP_LOCAL]        = exe_local_op,
-    [Nst_OP_IMPORT]       = exe_op_import,
-    [Nst_OP_EXTRACT]      = exe_op_extract,
-    [Nst_OP_DEC_INT]      = exe_dec_int,
-    [Nst_OP_NEW_INT]      = exe_new_int,
-    [Nst_OP_DUP]          = exe_dup,
-    [Nst_OP_ROT_2]        = exe_rot2,
-    [Nst_OP_ROT_3]        = exe_rot3,
-    [Nst_OP_MAKE_ARR]     = exe_make_arr,
-    [Nst_OP_MAKE_ARR_REP] = exe_make_arr_rep,
-    [Nst_OP_MAKE_VEC]     = exe_make_vec,
-    [Nst_OP_MAKE_VEC_REP] = exe_make_vec_rep,
-    [Nst_OP_MAKE_MAP]     = exe_make_map,
-    [Nst_OP_MAKE_FUNC]    = exe_make_func,
-    [Nst_OP_SAVE_ERROR]   = exe_save_error,
-    [Nst_OP_UNPACK_SEQ]   = exe_unpack_seq,
-    [Nst_OP_EXTEND_ARG]   = NULL,
-    [Nst_OP_JUMP]         = exe_jump,
-    [Nst_OP_JUMPIF_T]     = exe_jumpif_t,
-    [Nst_OP_JUMPIF_F]     = exe_jumpif_f,
-    [Nst_OP_JUMPIF_ZERO]  = exe_jumpif_zero,
-    [Nst_OP_JUMPIF_IEND]  = exe_jumpif_iend,
-    [Nst_OP_PUSH_CATCH]   = exe_push_catch,
+    [Nst_OP_POP_VAL]              = exe_pop_val,
+    [Nst_OP_FOR_START]            = exe_for_start,
+    [Nst_OP_FOR_NEXT]             = exe_for_next,
+    [Nst_OP_RETURN_VAL]           = exe_return_val,
+    [Nst_OP_RETURN_VARS]          = exe_return_vars,
+    [Nst_OP_SET_VAL_LOC]          = exe_set_val_loc,
+    [Nst_OP_SET_CONT_LOC]         = exe_set_cont_loc,
+    [Nst_OP_THROW_ERR]            = exe_throw_err,
+    [Nst_OP_SET_VAL]              = exe_set_val,
+    [Nst_OP_GET_VAL]              = exe_get_val,
+    [Nst_OP_PUSH_VAL]             = exe_push_val,
+    [Nst_OP_SET_CONT_VAL]         = exe_set_cont_val,
+    [Nst_OP_CALL]                 = exe_op_call,
+    [Nst_OP_TAIL_CALL]            = exe_op_tail_call,
+    [Nst_OP_SEQ_CALL]             = exe_op_seq_call,
+    [Nst_OP_CAST]                 = exe_op_cast,
+    [Nst_OP_RANGE]                = exe_op_range,
+    [Nst_OP_STACK]                = exe_stack_op,
+    [Nst_OP_LOCAL]                = exe_local_op,
+    [Nst_OP_IMPORT]               = exe_op_import,
+    [Nst_OP_EXTRACT]              = exe_op_extract,
+    [Nst_OP_DEC_INT]              = exe_dec_int,
+    [Nst_OP_NEW_INT]              = exe_new_int,
+    [Nst_OP_DUP]                  = exe_dup,
+    [Nst_OP_ROT_2]                = exe_rot2,
+    [Nst_OP_ROT_3]                = exe_rot3,
+    [Nst_OP_MAKE_ARR]             = exe_make_arr,
+    [Nst_OP_MAKE_ARR_REP]         = exe_make_arr_rep,
+    [Nst_OP_MAKE_VEC]             = exe_make_vec,
+    [Nst_OP_MAKE_VEC_REP]         = exe_make_vec_rep,
+    [Nst_OP_MAKE_MAP]             = exe_make_map,
+    [Nst_OP_MAKE_FUNC]            = exe_make_func,
+    [Nst_OP_SAVE_ERROR]           = exe_save_error,
+    [Nst_OP_UNPACK_SEQ]           = exe_unpack_seq,
+    [Nst_OP_PUSH_STACK_OP]        = exe_push_stack_op,
+    [Nst_OP_GET_STACK_OP]         = exe_get_stack_op,
+    [Nst_OP_EXTEND_ARG]           = NULL,
+    [Nst_OP_JUMP]                 = exe_jump,
+    [Nst_OP_JUMPIF_T]             = exe_jumpif_t,
+    [Nst_OP_JUMPIF_F]             = exe_jumpif_f,
+    [Nst_OP_JUMPIF_ZERO]          = exe_jumpif_zero,
+    [Nst_OP_JUMPIF_IEND]          = exe_jumpif_iend,
+    [Nst_OP_EXTRACT_SEQ_INT]      = exe_extract_seq_int,
+    [Nst_OP_EXTRACT_MAP]          = exe_extract_map,
+    [Nst_OP_EXTRACT_STR_INT]      = exe_extract_str_int,
+    [Nst_OP_SET_CONT_SEQ_INT]     = exe_set_cont_seq_int,
+    [Nst_OP_SET_CONT_MAP]         = exe_set_cont_map,
+    [Nst_OP_SET_CONT_LOC_SEQ_INT] = exe_set_cont_loc_seq_int,
+    [Nst_OP_SET_CONT_LOC_MAP]     = exe_set_cont_loc_map,
 };
 
 static Nst_Obj *(*stack_op_func[])(Nst_Obj *, Nst_Obj *) = {
@@ -174,6 +247,41 @@ static Nst_Obj **op_objs;
 
 static u64 state_init = 0;
 
+// C functions receive a pointer to their arguments inside the value stack, so
+// while any of them is running the stack cannot be reallocated. When it needs
+// to grow a new block is used and the old ones are freed once all the calls
+// return.
+static usize c_call_depth = 0;
+static usize c_args_start = 0;
+// The value of `c_call_depth` when the functions currently executed by the
+// interpreter loop were called, a C function called directly by one of them
+// runs at `frames_c_depth + 1`
+static usize frames_c_depth = 0;
+static Nst_PtrArray old_v_stacks;
+
+// The number of times each pair and triplet of instructions was executed,
+// allocated only when `print_op_pairs` is set in the program
+static u64 *op_pairs = NULL;
+static u64 *op_triplets = NULL;
+
+// When false calls in tail position create a new frame like any other call,
+// the callers then appear in the traceback of errors
+static bool tail_calls = true;
+
+// Incremented by the profiling timer, the sample is taken by the interpreter
+// between two instructions where the state is consistent and counts once for
+// each tick that elapsed while the instruction was running
+static volatile sig_atomic_t pending_ticks = 0;
+static u64 sample_count = 0;
+// The call stacks and the lines that were sampled
+static ProfTable prof_stacks;
+static ProfTable prof_lines;
+static ProfFrame sample_frames[PROFILE_MAX_FRAMES];
+
+#ifdef Nst_MSVC
+static HANDLE profile_timer = NULL;
+#endif // !Nst_MSVC
+
 #ifdef _Nst_ENABLE_LINE_DEBUGGER
 static Nst_Span prev_pos = { 0 };
 static u64 hit_count = 0;
@@ -187,6 +295,10 @@ bool Nst_init(void)
 
     Nst_error_set_color(Nst_supports_color());
     _Nst_error_init();
+    if (!_Nst_hash_init()) {
+        state_init = 0;
+        return false;
+    }
 
     if (!_Nst_globals_init())
         goto cleanup;
@@ -201,11 +313,11 @@ bool Nst_init(void)
     // error that might occur during initialization
     i_state.v_stack.stack = NULL;
     i_state.f_stack.stack = NULL;
-    i_state.c_stack.stack = NULL;
     i_state.func = NULL;
     i_state.vt.vars = NULL;
     i_state.vt.global_table = NULL;
     i_state.idx = -1;
+    i_state.vstack_base = 0;
     i_state.prog = NULL;
     op_arg = 0;
     op_objs = NULL;
@@ -213,9 +325,9 @@ bool Nst_init(void)
 
     if (!Nst_vstack_init(&i_state.v_stack))
         goto cleanup;
-    if (!Nst_fstack_init(&i_state.f_stack))
+    if (!Nst_pa_init(&old_v_stacks, 0))
         goto cleanup;
-    if (!Nst_cstack_init(&i_state.c_stack))
+    if (!Nst_fstack_init(&i_state.f_stack))
         goto cleanup;
 
     state_init = true;
@@ -243,8 +355,8 @@ void Nst_quit(void)
     Nst_error_clear();
 
     Nst_vstack_destroy(&i_state.v_stack);
+    Nst_pa_clear(&old_v_stacks, (Nst_Destructor)Nst_free);
     Nst_fstack_destroy(&i_state.f_stack);
-    Nst_cstack_destroy(&i_state.c_stack);
     Nst_ndec_ref(i_state.func);
     Nst_vt_destroy(&i_state.vt);
     i_state.idx = 0;
@@ -308,10 +420,44 @@ i32 Nst_run(Nst_Program *prog)
         return 1;
     }
 
+    tail_calls = !prog->no_tail_calls;
+    Nst_ggc_set_step(prog->gc_step);
+    Nst_ggc_record_pauses(prog->print_gc_stats);
+
+    if (prog->print_op_pairs) {
+        op_pairs = Nst_calloc_c(OP_COUNT * OP_COUNT, u64, NULL);
+        op_triplets = Nst_calloc_c(OP_COUNT * OP_COUNT * OP_COUNT, u64, NULL);
+        if (op_pairs == NULL || op_triplets == NULL) {
+            Nst_free(op_pairs);
+            Nst_free(op_triplets);
+            op_pairs = NULL;
+            op_triplets = NULL;
+            Nst_error_clear();
+        }
+    }
+
+    bool profiling = prog->profile_path != NULL && profile_start();
+
     signal(SIGINT, interrupt_handler);
     bool success = complete_function();
     signal(SIGINT, SIG_DFL);
 
+    if (profiling)
+        profile_stop(prog->profile_path);
+
+    if (op_pairs != NULL) {
+        print_op_pairs();
+        Nst_free(op_pairs);
+        Nst_free(op_triplets);
+        op_pairs = NULL;
+        op_triplets = NULL;
+    }
+
+    if (prog->print_gc_stats) {
+        Nst_ggc_print_pauses();
+        Nst_ggc_record_pauses(false);
+    }
+
     // Check for errors
     i32 exit_code = 0;
     if (!success) {
@@ -348,8 +494,10 @@ const Nst_InterpreterState *Nst_state(void)
     return (const Nst_InterpreterState *)&i_state;
 }
 
-static bool push_func(Nst_Obj *func, Nst_Span span, usize arg_num,
-                      Nst_Obj **args, Nst_VarTable *vt)
+// Creates the variable table of a call to `func`, the arguments are taken from
+// `args` or, if it is `NULL`, popped from the value stack
+static bool init_func_vt(Nst_VarTable *vt, Nst_Obj *func, usize arg_num,
+                         Nst_Obj **args)
 {
     usize func_arg_num = Nst_func_arg_num(func);
     if (func_arg_num < arg_num) {
@@ -358,76 +506,72 @@ static bool push_func(Nst_Obj *func, Nst_Span span, usize arg_num,
     }
 
     bool success;
-    Nst_VarTable new_vt;
-
-    if (vt != NULL) {
-        new_vt = *vt;
-    } else {
-        Nst_Obj *func_globals = Nst_func_mod_globals(func);
-        if (func_globals != NULL)
-            success = Nst_vt_init(&new_vt, func_globals, NULL, false);
-        else if (i_state.vt.global_table == NULL)
-            success = Nst_vt_init(&new_vt, i_state.vt.vars, NULL, false);
-        else {
-            success = Nst_vt_init(
-                &new_vt,
-                i_state.vt.global_table,
-                NULL, false);
-        }
+    Nst_Obj *func_globals = Nst_func_mod_globals(func);
+    if (func_globals != NULL)
+        success = Nst_vt_init(vt, func_globals, NULL, false);
+    else if (i_state.vt.global_table == NULL)
+        success = Nst_vt_init(vt, i_state.vt.vars, NULL, false);
+    else
+        success = Nst_vt_init(vt, i_state.vt.global_table, NULL, false);
 
-        if (!success)
-            return false;
+    if (!success)
+        return false;
 
-        // add the outer variables if needed
-        Nst_Obj *outer_vars = Nst_func_outer_vars(func);
-        if (vt == NULL && outer_vars != NULL) {
-            Nst_Obj *key;
-            Nst_Obj *val;
-            for (isize i = Nst_map_next(-1, outer_vars, &key, &val);
-                 i != -1;
-                 i = Nst_map_next(i, outer_vars, &key, &val))
-            {
-                if (!Nst_vt_set(new_vt, key, val)) {
-                    Nst_vt_destroy(&new_vt);
-                    return false;
-                }
+    // add the captured variables if needed
+    Nst_Obj **outer_vals = Nst_func_outer_vals(func);
+    if (outer_vals != NULL) {
+        Nst_Obj *outer_names = Nst_func_outer_names(func);
+        Nst_Obj **names = Nst_seq_objs(outer_names);
+        for (usize i = 0, n = Nst_seq_len(outer_names); i < n; i++) {
+            if (outer_vals[i] == NULL)
+                continue;
+            if (!Nst_vt_set(*vt, names[i], outer_vals[i])) {
+                Nst_vt_destroy(vt);
+                return false;
             }
         }
+    }
 
-        // add the given arguments
-        Nst_Obj **func_args = Nst_func_args(func);
-        if (vt == NULL && args != NULL) {
-            for (usize i = 0; i < arg_num; i++) {
-                if (!Nst_vt_set(new_vt, func_args[i], args[i])) {
-                    Nst_vt_destroy(&new_vt);
-                    return false;
-                }
+    // add the given arguments
+    Nst_Obj **func_args = Nst_func_args(func);
+    if (args != NULL) {
+        for (usize i = 0; i < arg_num; i++) {
+            if (!Nst_vt_set(*vt, func_args[i], args[i])) {
+                Nst_vt_destroy(vt);
+                return false;
             }
-        } else if (vt == NULL) {
-            for (usize i = 0; i < arg_num; i++) {
-                Nst_Obj *arg = pop_val();
-                if (!Nst_vt_set(new_vt, func_args[arg_num - i - 1], arg)) {
-                    Nst_dec_ref(arg);
-                    Nst_vt_destroy(&new_vt);
-                    return false;
-                }
+        }
+    } else {
+        for (usize i = 0; i < arg_num; i++) {
+            Nst_Obj *arg = pop_val();
+            if (!Nst_vt_set(*vt, func_args[arg_num - i - 1], arg)) {
                 Nst_dec_ref(arg);
+                Nst_vt_destroy(vt);
+                return false;
             }
+            Nst_dec_ref(arg);
         }
+    }
 
-        // fill the remaining ones with `null`
-        for (usize i = arg_num; i < func_arg_num; i++) {
-            if (!Nst_vt_set(new_vt, func_args[i], Nst_null())) {
-                Nst_vt_destroy(&new_vt);
-                return false;
-            }
+    // fill the remaining ones with `null`
+    for (usize i = arg_num; i < func_arg_num; i++) {
+        if (!Nst_vt_set(*vt, func_args[i], Nst_null())) {
+            Nst_vt_destroy(vt);
+            return false;
         }
     }
+    return true;
+}
+
+static bool push_func(Nst_Obj *func, Nst_Span span, usize arg_num,
+                      Nst_Obj **args, Nst_VarTable *vt)
+{
+    Nst_VarTable new_vt;
 
-    if (!push_val(NULL)) {
-        Nst_vt_destroy(&new_vt);
+    if (vt != NULL)
+        new_vt = *vt;
+    else if (!init_func_vt(&new_vt, func, arg_num, args))
         return false;
-    }
 
     if (i_state.func != NULL) {
         Nst_FuncCall call = {
@@ -435,12 +579,11 @@ static bool push_func(Nst_Obj *func, Nst_Span span, usize arg_num,
             .span = span,
             .vt = i_state.vt,
             .idx = i_state.idx,
-            .cstack_len = i_state.c_stack.len
+            .vstack_base = i_state.vstack_base
         };
 
         if (!Nst_fstack_push(&i_state.f_stack, call)) {
             Nst_vt_destroy(&new_vt);
-            pop_and_destroy();
             return false;
         }
     }
@@ -448,6 +591,7 @@ static bool push_func(Nst_Obj *func, Nst_Span span, usize arg_num,
     i_state.func = Nst_inc_ref(func);
     i_state.vt = new_vt;
     i_state.idx = 0;
+    i_state.vstack_base = i_state.v_stack.len;
     op_arg = 0;
     op_objs = NULL;
     bc = NULL;
@@ -546,6 +690,17 @@ static bool push_module(const char *filename)
 }
 
 static bool complete_function(void)
+{
+    usize prev_frames_c_depth = frames_c_depth;
+    frames_c_depth = c_call_depth;
+    bool result = run_frames();
+    frames_c_depth = prev_frames_c_depth;
+    return result;
+}
+
+// Executes the function on top of the call stack and the ones it calls until
+// it returns
+static bool run_frames(void)
 {
     usize initial_stack_size = i_state.f_stack.len;
 
@@ -554,6 +709,9 @@ static bool complete_function(void)
     Nst_Op *ops = bc->bytecode;
     bool extend_arg = false;
     op_objs = bc->objects;
+    // the last two instructions executed in the current function when the
+    // pairs are being counted
+    i32 prev_ops[2] = { -1, -1 };
 
     while (i_state.f_stack.len >= initial_stack_size) {
         if (i_state.idx >= (isize)bc_len) {
@@ -565,13 +723,15 @@ static bool complete_function(void)
             destroy_call(&call);
             if (i_state.f_stack.len < initial_stack_size)
                 return true;
+            prev_ops[0] = -1;
+            prev_ops[1] = -1;
             i_state.idx++;
             bc_len = bc->len;
             ops = bc->bytecode;
         }
 
         Nst_Op op = ops[i_state.idx];
-        op_arg = ((op_arg<<8) * extend_arg) | Nst_OP_ARG(op);
+        op_arg = ((op_arg<<24) * extend_arg) | Nst_OP_ARG(op);
         if (Nst_OP_CODE(op) == Nst_OP_EXTEND_ARG) {
             extend_arg = true;
             i_state.idx++;
@@ -579,6 +739,9 @@ static bool complete_function(void)
         }
         extend_arg = false;
 
+        if (op_pairs != NULL)
+            count_op(prev_ops, Nst_OP_CODE(op));
+
 #ifdef _Nst_ENABLE_LINE_DEBUGGER
         Nst_Span pos = Nst_state_span();
         if (pos.start_line != prev_pos.start_line || pos.text != prev_pos.text) {
@@ -595,8 +758,14 @@ static bool complete_function(void)
         prev_pos = pos;
 #endif // !_Nst_ENABLE_LINE_DEBUGGER
 
+        i64 inst_idx = i_state.idx;
         OpResult result = inst_func[Nst_OP_CODE(op)]();
 
+        // the sample is delayed when the instruction changes the function
+        // being executed
+        if (pending_ticks != 0 && result == INST_SUCCESS)
+            take_sample(inst_idx);
+
         if (interrupt) {
             interrupt = false;
             Nst_error_set(Nst_inc_ref(Nst_s.e_Interrupt), Nst_null_ref());
@@ -612,6 +781,8 @@ static bool complete_function(void)
             if (!unwind_error(initial_stack_size))
                 return false;
         }
+        prev_ops[0] = -1;
+        prev_ops[1] = -1;
         bc = Nst_func_nest_body(i_state.func);
         bc_len = bc->len;
         ops = bc->bytecode;
@@ -620,60 +791,463 @@ static bool complete_function(void)
     return true;
 }
 
-static inline void destroy_call(Nst_FuncCall *call)
+// Pairs are counted only between instructions of the same function since
+// they could not be fused otherwise
+static void count_op(i32 *prev_ops, Nst_OpCode op)
+{
+    if (prev_ops[1] != -1)
+        op_pairs[prev_ops[1] * OP_COUNT + op]++;
+    if (prev_ops[0] != -1) {
+        usize idx = (prev_ops[0] * OP_COUNT + prev_ops[1]) * OP_COUNT + op;
+        op_triplets[idx]++;
+    }
+    prev_ops[0] = prev_ops[1];
+    prev_ops[1] = (i32)op;
+}
+
+typedef struct _OpSequence {
+    u64 count;
+    usize idx;
+} OpSequence;
+
+static int compare_op_sequences(const void *a, const void *b)
+{
+    u64 count_a = ((const OpSequence *)a)->count;
+    u64 count_b = ((const OpSequence *)b)->count;
+    return count_a < count_b ? 1 : count_a > count_b ? -1 : 0;
+}
+
+static void print_op_sequences(u64 *counts, usize len, usize seq_len)
+{
+    OpSequence top[OP_PAIRS_PRINTED] = { 0 };
+    u64 total = 0;
+
+    // keep the most frequent sequences sorted in `top`
+    for (usize i = 0; i < len; i++) {
+        total += counts[i];
+        if (counts[i] <= top[OP_PAIRS_PRINTED - 1].count)
+            continue;
+        top[OP_PAIRS_PRINTED - 1].count = counts[i];
+        top[OP_PAIRS_PRINTED - 1].idx = i;
+        qsort(top, OP_PAIRS_PRINTED, sizeof(OpSequence), compare_op_sequences);
+    }
+
+    for (usize i = 0; i < OP_PAIRS_PRINTED && top[i].count != 0; i++) {
+        Nst_printf(
+            "%6.2f%% %12" PRIu64 " ",
+            (f64)top[i].count / (f64)total * 100.0,
+            top[i].count);
+        usize div = seq_len == 2 ? OP_COUNT : OP_COUNT * OP_COUNT;
+        for (usize j = 0; j < seq_len; j++) {
+            Nst_printf(" %-7s", Nst_op_name((Nst_OpCode)(top[i].idx / div)));
+            top[i].idx %= div;
+            div /= OP_COUNT;
+        }
+        Nst_println("");
+    }
+}
+
+static void print_op_pairs(void)
+{
+    Nst_println("\nMost frequent instruction pairs:");
+    print_op_sequences(op_pairs, OP_COUNT * OP_COUNT, 2);
+    Nst_println("\nMost frequent instruction triplets:");
+    print_op_sequences(op_triplets, OP_COUNT * OP_COUNT * OP_COUNT, 3);
+}
+
+#ifdef Nst_MSVC
+
+static VOID CALLBACK profile_timer_callback(PVOID param, BOOLEAN fired)
+{
+    Nst_UNUSED(param);
+    Nst_UNUSED(fired);
+    pending_ticks++;
+}
+
+#else
+
+static void profile_handler(int sig)
+{
+    Nst_UNUSED(sig);
+    pending_ticks++;
+}
+
+#endif // !Nst_MSVC
+
+static bool prof_table_init(ProfTable *table)
 {
-    while (i_state.c_stack.len > call->cstack_len)
-        Nst_cstack_pop(&i_state.c_stack);
+    table->entries = Nst_calloc_c(256, ProfEntry, NULL);
+    if (table->entries == NULL)
+        return false;
+    table->len = 0;
+    table->cap = 256;
+    if (!Nst_da_init(&table->frames, sizeof(ProfFrame), 256)) {
+        Nst_free(table->entries);
+        table->entries = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void prof_table_destroy(ProfTable *table)
+{
+    Nst_free(table->entries);
+    table->entries = NULL;
+    Nst_da_clear(&table->frames, NULL);
+}
 
+static inline ProfFrame *prof_entry_frames(ProfTable *table, ProfEntry *entry)
+{
+    return (ProfFrame *)table->frames.data + entry->start;
+}
+
+static u64 hash_frames(ProfFrame *frames, usize len)
+{
+    // FNV-1a over the fields of the frames
+    u64 hash = 14695981039346656037ULL;
+    for (usize i = 0; i < len; i++) {
+        hash = (hash ^ (u64)(usize)frames[i].text) * 1099511628211ULL;
+        hash = (hash ^ (u64)(u32)frames[i].line) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool prof_table_grow(ProfTable *table)
+{
+    usize new_cap = table->cap * 2;
+    ProfEntry *new_entries = Nst_calloc_c(new_cap, ProfEntry, NULL);
+    if (new_entries == NULL)
+        return false;
+
+    for (usize i = 0; i < table->cap; i++) {
+        ProfEntry entry = table->entries[i];
+        if (entry.count == 0)
+            continue;
+        usize j = (usize)entry.hash & (new_cap - 1);
+        while (new_entries[j].count != 0)
+            j = (j + 1) & (new_cap - 1);
+        new_entries[j] = entry;
+    }
+    Nst_free(table->entries);
+    table->entries = new_entries;
+    table->cap = new_cap;
+    return true;
+}
+
+// Add `weight` samples to the table, the frames are copied only the first time
+// the sequence is found
+static bool prof_table_add(ProfTable *table, ProfFrame *frames, usize len,
+                           u64 weight)
+{
+    if (table->len >= table->cap / 2 && !prof_table_grow(table))
+        return false;
+
+    u64 hash = hash_frames(frames, len);
+    usize mask = table->cap - 1;
+    usize i = (usize)hash & mask;
+    for (; table->entries[i].count != 0; i = (i + 1) & mask) {
+        ProfEntry *entry = &table->entries[i];
+        if (entry->hash != hash || entry->len != len)
+            continue;
+        ProfFrame *entry_frames = prof_entry_frames(table, entry);
+        usize j = 0;
+        while (j < len && entry_frames[j].text == frames[j].text
+               && entry_frames[j].line == frames[j].line)
+        {
+            j++;
+        }
+        if (j == len) {
+            entry->count += weight;
+            return true;
+        }
+    }
+
+    if (!Nst_da_reserve(&table->frames, len))
+        return false;
+    ProfEntry *entry = &table->entries[i];
+    entry->hash = hash;
+    entry->count = weight;
+    entry->start = table->frames.len;
+    entry->len = len;
+    for (usize j = 0; j < len; j++)
+        Nst_da_append(&table->frames, &frames[j]);
+    table->len++;
+    return true;
+}
+
+static bool profile_start(void)
+{
+    pending_ticks = 0;
+    sample_count = 0;
+    if (!prof_table_init(&prof_stacks)) {
+        Nst_error_clear();
+        return false;
+    }
+    if (!prof_table_init(&prof_lines)) {
+        prof_table_destroy(&prof_stacks);
+        Nst_error_clear();
+        return false;
+    }
+
+#ifdef Nst_MSVC
+    DWORD interval = PROFILE_INTERVAL_US / 1000;
+    if (CreateTimerQueueTimer(
+            &profile_timer, NULL,
+            profile_timer_callback, NULL,
+            interval, interval,
+            WT_EXECUTEINTIMERTHREAD))
+    {
+        return true;
+    }
+#else
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profile_handler;
+    // system calls interrupted by the timer are restarted so that the program
+    // behaves in the same way when it is profiled
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = PROFILE_INTERVAL_US;
+    timer.it_value = timer.it_interval;
+
+    if (sigaction(SIGPROF, &action, NULL) == 0
+        && setitimer(ITIMER_PROF, &timer, NULL) == 0)
+    {
+        return true;
+    }
+    signal(SIGPROF, SIG_IGN);
+#endif // !Nst_MSVC
+
+    Nst_printf("Could not start the profiler\n");
+    prof_table_destroy(&prof_stacks);
+    prof_table_destroy(&prof_lines);
+    return false;
+}
+
+static ProfFrame frame_at(Nst_Obj *func, i64 idx)
+{
+    ProfFrame frame = { .text = NULL, .line = 0 };
+    Nst_Bytecode *func_bc = Nst_func_nest_body(func);
+    if (idx >= 0 && (usize)idx < func_bc->len) {
+        frame.text = func_bc->positions[idx].text;
+        frame.line = func_bc->positions[idx].start_line;
+    }
+    return frame;
+}
+
+// Record the call stack with the current function executing the instruction
+// at `idx` once for each pending tick, the outermost calls of very deep stacks
+// are dropped
+static void take_sample(i64 idx)
+{
+    u64 ticks = (u64)pending_ticks;
+    pending_ticks = 0;
+
+    usize calls_len = i_state.f_stack.len;
+    usize first_call = 0;
+    if (calls_len >= PROFILE_MAX_FRAMES)
+        first_call = calls_len - PROFILE_MAX_FRAMES + 1;
+
+    usize len = 0;
+    for (usize i = first_call; i < calls_len; i++) {
+        Nst_FuncCall *call = &i_state.f_stack.stack[i];
+        sample_frames[len++] = frame_at(call->func, call->idx);
+    }
+    sample_frames[len++] = frame_at(i_state.func, idx);
+
+    sample_count += ticks;
+    if (!prof_table_add(&prof_stacks, sample_frames, len, ticks)
+        || !prof_table_add(&prof_lines, &sample_frames[len - 1], 1, ticks))
+    {
+        Nst_error_clear();
+    }
+}
+
+// Semicolons separate the frames and a space separates the count in the folded
+// format, in the path of the file they are replaced with underscores
+static void fprint_frame(FILE *file, ProfFrame frame)
+{
+    if (frame.text == NULL) {
+        fputc('?', file);
+        return;
+    }
+
+    const char *path = frame.text->path == NULL
+                     ? "<string>"
+                     : frame.text->path;
+    for (; *path != '\0'; path++) {
+        if (*path == ';' || *path == ' ')
+            fputc('_', file);
+        else
+            fputc(*path, file);
+    }
+    fprintf(file, ":%" PRIi32, frame.line + 1);
+}
+
+// Write the stacks in the folded format used by flame graph tools, one stack
+// per line with the frames separated by semicolons and followed by the count
+static bool write_folded_stacks(const char *path)
+{
+    FILE *file = Nst_fopen_unicode(path, "w");
+    if (file == NULL) {
+        Nst_error_clear();
+        return false;
+    }
+
+    for (usize i = 0; i < prof_stacks.cap; i++) {
+        ProfEntry *entry = &prof_stacks.entries[i];
+        if (entry->count == 0)
+            continue;
+        ProfFrame *frames = prof_entry_frames(&prof_stacks, entry);
+        for (usize j = 0; j < entry->len; j++) {
+            if (j != 0)
+                fputc(';', file);
+            fprint_frame(file, frames[j]);
+        }
+        fprintf(file, " %" PRIu64 "\n", entry->count);
+    }
+    return fclose(file) == 0;
+}
+
+static int compare_prof_entries(const void *a, const void *b)
+{
+    u64 count_a = ((const ProfEntry *)a)->count;
+    u64 count_b = ((const ProfEntry *)b)->count;
+    return count_a < count_b ? 1 : count_a > count_b ? -1 : 0;
+}
+
+static void print_hot_lines(void)
+{
+    Nst_printf("\nMost sampled lines (%" PRIu64 " samples):\n", sample_count);
+    if (sample_count == 0)
+        return;
+
+    // the entries are not needed as a hash table anymore
+    qsort(
+        prof_lines.entries,
+        prof_lines.cap,
+        sizeof(ProfEntry),
+        compare_prof_entries);
+
+    usize printed = prof_lines.len < PROFILE_LINES_PRINTED
+                  ? prof_lines.len
+                  : PROFILE_LINES_PRINTED;
+    for (usize i = 0; i < printed; i++) {
+        ProfEntry *entry = &prof_lines.entries[i];
+        ProfFrame frame = *prof_entry_frames(&prof_lines, entry);
+        Nst_printf(
+            "%6.2f%% %10" PRIu64 "  ",
+            (f64)entry->count / (f64)sample_count * 100.0,
+            entry->count);
+        if (frame.text == NULL) {
+            Nst_println("?");
+            continue;
+        }
+
+        const char *line = frame.text->lines[frame.line];
+        while (*line == ' ' || *line == '\t')
+            line++;
+        Nst_printf(
+            "%s:%" PRIi32 "  %.*s\n",
+            frame.text->path == NULL ? "<string>" : frame.text->path,
+            frame.line + 1,
+            (int)strcspn(line, "\r\n"),
+            line);
+    }
+}
+
+static void profile_stop(const char *path)
+{
+    // the timer is stopped before restoring the handler since the default
+    // action of SIGPROF terminates the process
+#ifdef Nst_MSVC
+    DeleteTimerQueueTimer(NULL, profile_timer, INVALID_HANDLE_VALUE);
+    profile_timer = NULL;
+#else
+    struct itimerval timer = { 0 };
+    setitimer(ITIMER_PROF, &timer, NULL);
+    signal(SIGPROF, SIG_IGN);
+#endif // !Nst_MSVC
+    pending_ticks = 0;
+
+    if (!write_folded_stacks(path))
+        Nst_printf("Could not write the profile to '%s'\n", path);
+    print_hot_lines();
+
+    prof_table_destroy(&prof_stacks);
+    prof_table_destroy(&prof_lines);
+}
+
+static inline void destroy_call(Nst_FuncCall *call)
+{
     Nst_vt_destroy(&i_state.vt);
     Nst_dec_ref(i_state.func);
     i_state.func = call->func;
     i_state.vt = call->vt;
     i_state.idx = call->idx;
+    i_state.vstack_base = call->vstack_base;
 
     bc = Nst_func_nest_body(i_state.func);
     op_objs = bc->objects;
+    shrink_stacks();
+}
+
+// The stacks are not shrunk when values are popped but only when a function
+// returns and most of their memory is unused
+static inline void shrink_stacks(void)
+{
+    // the arguments of C functions point inside the value stack
+    if (c_call_depth == 0
+        && i_state.v_stack.len < i_state.v_stack.cap >> 3)
+    {
+        Nst_vstack_shrink(&i_state.v_stack);
+    }
+    if (i_state.f_stack.len < i_state.f_stack.cap >> 3)
+        Nst_fstack_shrink(&i_state.f_stack);
 }
 
+// Looks for the `catch` block of the error in the exception tables of the
+// functions being executed, starting from the current one. The frames of the
+// functions without one are removed. Returns `false` when the error is not
+// caught by the functions started by the current call to `complete_function`.
 static inline bool unwind_error(usize initial_stack_size)
 {
     Nst_error_add_span(Nst_state_span());
 
-    Nst_CatchFrame top_catch = Nst_cstack_peek(&i_state.c_stack);
-    if (Nst_error_get()->error_name == Nst_c.Null_null
-        || Nst_error_get()->error_msg == Nst_c.Null_null)
-    {
-        top_catch.f_stack_len = 0;
-        top_catch.v_stack_len = 0;
-        top_catch.idx = -1;
-    }
+    // errors with a `null` name and message exit the program and cannot be
+    // caught
+    bool can_catch = Nst_error_get()->error_name != Nst_c.Null_null
+                  && Nst_error_get()->error_msg != Nst_c.Null_null;
+
+    while (true) {
+        Nst_Bytecode *func_bc = Nst_func_nest_body(i_state.func);
+        Nst_ExceptionEntry *entry = can_catch
+            ? Nst_bc_find_handler(func_bc, (usize)i_state.idx)
+            : NULL;
+        if (entry != NULL) {
+            usize depth = i_state.vstack_base + entry->stack_depth;
+            drop_vals(i_state.v_stack.len - depth);
+            i_state.idx = (i64)entry->handler;
+            return true;
+        }
 
-    usize end_size = top_catch.f_stack_len + 1;
-    if (end_size < initial_stack_size)
-        end_size = initial_stack_size;
+        if (i_state.f_stack.len == 0) {
+            drop_vals(i_state.v_stack.len);
+            return false;
+        }
 
-    while (i_state.f_stack.len >= end_size) {
+        bool is_initial = i_state.f_stack.len == initial_stack_size;
         Nst_FuncCall call = Nst_fstack_pop(&i_state.f_stack);
         Nst_error_add_span(call.span);
 
+        drop_vals(i_state.v_stack.len - i_state.vstack_base);
         destroy_call(&call);
-        Nst_Obj *obj = pop_val();
-
-        while (obj != NULL) {
-            Nst_dec_ref(obj);
-            obj = pop_val();
-        }
+        if (is_initial)
+            return false;
     }
-
-    if (top_catch.f_stack_len < initial_stack_size)
-        return false;
-
-    while (i_state.v_stack.len > top_catch.v_stack_len)
-        Nst_ndec_ref(pop_val());
-    if (top_catch.idx == -1)
-        return false;
-    i_state.idx = top_catch.idx;
-    return true;
 }
 
 static inline Nst_Obj *pop_val(void)
@@ -681,25 +1255,7 @@ static inline Nst_Obj *pop_val(void)
     if (i_state.v_stack.len == 0)
         return NULL;
 
-    Nst_Obj *val = i_state.v_stack.stack[--i_state.v_stack.len];
-
-    if (i_state.v_stack.cap <= _Nst_V_STACK_MIN_SIZE)
-        return val;
-
-    if (i_state.v_stack.cap >> 2 < i_state.v_stack.len)
-        return val;
-
-    Nst_assert(i_state.v_stack.len <= i_state.v_stack.cap);
-
-    i_state.v_stack.stack = Nst_realloc(
-        i_state.v_stack.stack,
-        (i_state.v_stack.cap >> 1),
-        sizeof(Nst_Obj *),
-        i_state.v_stack.cap);
-
-    i_state.v_stack.cap >>= 1;
-
-    return val;
+    return i_state.v_stack.stack[--i_state.v_stack.len];
 }
 
 static inline void pop_and_destroy(void)
@@ -709,10 +1265,20 @@ static inline void pop_and_destroy(void)
 
 static inline bool push_val(Nst_Obj *obj)
 {
-    if (i_state.v_stack.len >= i_state.v_stack.cap) {
+    if (i_state.v_stack.len >= i_state.v_stack.cap && !grow_v_stack())
+        return false;
+
+    i_state.v_stack.stack[i_state.v_stack.len++] = Nst_ninc_ref(obj);
+    return true;
+}
+
+static bool grow_v_stack(void)
+{
+    usize cap = i_state.v_stack.cap;
+    if (c_call_depth == 0) {
         void *new_stack = Nst_realloc(
             i_state.v_stack.stack,
-            i_state.v_stack.cap * 2,
+            cap * 2,
             sizeof(Nst_Obj *),
             0);
 
@@ -721,12 +1287,97 @@ static inline bool push_val(Nst_Obj *obj)
 
         i_state.v_stack.stack = new_stack;
         i_state.v_stack.cap *= 2;
+        return true;
     }
 
-    i_state.v_stack.stack[i_state.v_stack.len++] = Nst_ninc_ref(obj);
+    Nst_Obj **new_stack = Nst_malloc_c(cap * 2, Nst_Obj *);
+    if (new_stack == NULL)
+        return false;
+    if (!Nst_pa_append(&old_v_stacks, i_state.v_stack.stack)) {
+        Nst_free(new_stack);
+        return false;
+    }
+    memcpy(new_stack, i_state.v_stack.stack, cap * sizeof(Nst_Obj *));
+    i_state.v_stack.stack = new_stack;
+    i_state.v_stack.cap *= 2;
     return true;
 }
 
+// Removes `count` values from the top of the stack without shrinking it
+static void drop_vals(usize count)
+{
+    Nst_Obj **top = i_state.v_stack.stack + i_state.v_stack.len;
+    for (usize i = 1; i <= count; i++)
+        Nst_ndec_ref(top[-(isize)i]);
+    i_state.v_stack.len -= count;
+}
+
+// Calls a function with a C body. `args` is passed as is when the function
+// expects exactly `arg_num` arguments, otherwise they are copied to the stack
+// and padded with `null`.
+static Nst_Obj *call_c_func(Nst_Obj *func, usize arg_num, Nst_Obj **args)
+{
+    // the arguments are not on the stack, they start at its top
+    if (Nst_func_arg_num(func) == arg_num)
+        return run_c_body(func, arg_num, args, i_state.v_stack.len);
+
+    for (usize i = 0; i < arg_num; i++) {
+        if (!push_val(args[i])) {
+            drop_vals(i);
+            return NULL;
+        }
+    }
+    return call_c_func_on_stack(func, arg_num);
+}
+
+// Calls a function with a C body passing the `arg_num` values on top of the
+// stack, padded with `null`, as its arguments. The arguments are removed from
+// the stack when the function returns.
+static Nst_Obj *call_c_func_on_stack(Nst_Obj *func, usize arg_num)
+{
+    usize tot_args = Nst_func_arg_num(func);
+    if (tot_args < arg_num) {
+        Nst_error_set_call(_Nst_WRONG_ARG_NUM(tot_args, arg_num));
+        drop_vals(arg_num);
+        return NULL;
+    }
+
+    for (usize i = arg_num; i < tot_args; i++) {
+        if (!push_val(Nst_c.Null_null)) {
+            drop_vals(i);
+            return NULL;
+        }
+    }
+
+    usize args_start = i_state.v_stack.len - tot_args;
+    Nst_Obj *res = run_c_body(
+        func,
+        tot_args,
+        tot_args == 0 ? NULL : i_state.v_stack.stack + args_start,
+        args_start);
+    drop_vals(tot_args);
+    return res;
+}
+
+// Runs the body of a C function. `args_start` is the index in the value stack
+// where the arguments begin, or the length of the stack when they are stored
+// elsewhere, and is used by `Nst_coroutine_yield` to find the values of the
+// frame that is yielding.
+static Nst_Obj *run_c_body(Nst_Obj *func, usize arg_num, Nst_Obj **args,
+                           usize args_start)
+{
+    usize prev_args_start = c_args_start;
+    c_args_start = args_start;
+    c_call_depth++;
+    Nst_Obj *res = Nst_func_c_body(func)(arg_num, args);
+    c_call_depth--;
+    c_args_start = prev_args_start;
+
+    if (c_call_depth == 0 && old_v_stacks.len != 0)
+        Nst_pa_clear(&old_v_stacks, (Nst_Destructor)Nst_free);
+    return res;
+}
+
 Nst_Obj *Nst_run_module(const char *filename)
 {
     char buf[PATH_MAX];
@@ -752,43 +1403,8 @@ Nst_Obj *Nst_run_module(const char *filename)
 Nst_Obj *Nst_func_call(Nst_Obj *func, usize arg_num, Nst_Obj **args)
 {
     Nst_assert(func->type == Nst_t.Func);
-    if (Nst_FUNC_IS_C(func)) {
-        usize tot_args = Nst_func_arg_num(func);
-
-        if (tot_args < arg_num) {
-            Nst_error_set_call(
-                _Nst_WRONG_ARG_NUM(tot_args, arg_num));
-            return NULL;
-        }
-
-        usize null_args = tot_args - arg_num;
-
-        Nst_Obj **all_args = NULL;
-        Nst_Obj *stack_args[10]; // for up to 10 arguments this array is used
-
-        if (tot_args == 0)
-            all_args = NULL;
-        else if (null_args == 0)
-            all_args = args;
-        else if (tot_args <= 10) {
-            memcpy(stack_args, args, arg_num * sizeof(Nst_Obj *));
-            all_args = stack_args;
-        } else {
-            all_args = Nst_malloc_c(tot_args, Nst_Obj *);
-            if (args == NULL)
-                return NULL;
-            memcpy(all_args, args, arg_num * sizeof(Nst_Obj *));
-        }
-
-        for (usize i = 0; all_args && i < null_args; i++)
-            all_args[arg_num + i] = Nst_inc_ref(Nst_c.Null_null);
-
-        Nst_Obj *res = Nst_func_c_body(func)(tot_args, all_args);
-        if (all_args != stack_args && all_args != args)
-            Nst_free(all_args);
-
-        return res;
-    }
+    if (Nst_FUNC_IS_C(func))
+        return call_c_func(func, arg_num, args);
 
     bool result = push_func(func, Nst_span_empty(), arg_num, args, NULL);
     if (!result)
@@ -800,21 +1416,33 @@ Nst_Obj *Nst_func_call(Nst_Obj *func, usize arg_num, Nst_Obj **args)
 Nst_Obj *Nst_coroutine_yield(Nst_ObjRef **out_stack, usize *out_stack_size,
                              i64 *out_idx, Nst_VarTable *out_vt)
 {
-    usize stack_size = 0;
-    for (i64 i = (i64)i_state.v_stack.len - 1; i >= 0; i--) {
-        if (i_state.v_stack.stack[i] == NULL)
-            break;
-        stack_size++;
+    // the values of another C function would be moved with the ones of the
+    // frame if it was called between the function and the one yielding
+    if (c_call_depth != frames_c_depth + 1) {
+        Nst_error_setc_call(
+            "a coroutine can yield only from a function it calls directly");
+        return NULL;
     }
+
+    // the arguments of the function that is yielding are above the values
+    // that are saved
+    usize top = c_args_start;
+    usize frame_start = i_state.vstack_base;
+    usize stack_size = top - frame_start;
     *out_stack_size = stack_size;
 
     if (out_stack == NULL)
-        return NULL;
-
-    for (usize i = 0; i < stack_size; i++)
-        out_stack[stack_size - i - 1] = pop_val();
-    // remove the NULL of the function call
-    pop_val();
+        return i_state.func;
+
+    // the references are moved to `out_stack`
+    Nst_Obj **stack = i_state.v_stack.stack;
+    memcpy(out_stack, stack + frame_start, stack_size * sizeof(Nst_Obj *));
+    memmove(
+        stack + frame_start,
+        stack + top,
+        (i_state.v_stack.len - top) * sizeof(Nst_Obj *));
+    i_state.v_stack.len -= stack_size;
+    c_args_start = frame_start;
 
     *out_idx = i_state.idx;
     out_vt->vars = Nst_ninc_ref(i_state.vt.vars);
@@ -875,7 +1503,7 @@ static OpResult exe_for_inst(Nst_Obj *iter, Nst_Obj *func)
     Nst_assert(iter->type == Nst_t.Iter);
     if (Nst_FUNC_IS_C(func)) {
         Nst_Obj *iter_value = Nst_iter_value(iter);
-        Nst_Obj *res = Nst_func_c_body(func)(1, &iter_value);
+        Nst_Obj *res = call_c_func(func, 1, &iter_value);
         if (res == NULL || !push_val(res)) {
             Nst_ndec_ref(res);
             return INST_FAILED;
@@ -901,6 +1529,13 @@ static OpResult exe_for_start(void)
     }
     FAST_TOP = iter;
     Nst_dec_ref(iterable);
+
+    // the result of `start` is popped right after the instruction
+    if (Nst_ITER_IS_NATIVE(iter)) {
+        if (!Nst_iter_start(iter))
+            return INST_FAILED;
+        return push_val(Nst_c.Null_null) ? INST_SUCCESS : INST_FAILED;
+    }
     return exe_for_inst(iter, Nst_iter_start_func(iter));
 }
 
@@ -908,7 +1543,77 @@ static OpResult exe_for_next(void)
 {
     CHECK_V_STACK(1);
     Nst_Obj *iter = FAST_TOP;
-    return exe_for_inst(iter, Nst_iter_next_func(iter));
+    if (!Nst_ITER_IS_NATIVE(iter))
+        return exe_for_inst(iter, Nst_iter_next_func(iter));
+
+    OpResult result;
+    if (op_arg != 0 && for_next_unpacked(iter, &result))
+        return result;
+
+    Nst_Obj *res = Nst_iter_next(iter);
+    if (res == NULL || !push_val(res)) {
+        Nst_ndec_ref(res);
+        return INST_FAILED;
+    }
+    Nst_dec_ref(res);
+    return INST_SUCCESS;
+}
+
+// When the values of a for loop are unpacked FOR_NEXT is followed by
+// JUMPIF_IEND and UNPACK_SEQ. If the iterator can produce the values directly
+// they are pushed as UNPACK_SEQ would and both instructions are skipped,
+// otherwise `false` is returned and the iterator is not advanced.
+static bool for_next_unpacked(Nst_Obj *iter, OpResult *result)
+{
+    usize count = (usize)op_arg;
+    // the values are not written directly on the stack since getting them
+    // might call Nest functions that use it
+    Nst_Obj *values[FOR_UNPACK_MAX];
+    if (count > FOR_UNPACK_MAX)
+        return false;
+
+    // the instructions that are skipped are checked since the bytecode may not
+    // have been produced by the compiler
+    Nst_Op *ops = bc->bytecode;
+    usize idx = (usize)i_state.idx + 1;
+    while (idx < bc->len && Nst_OP_CODE(ops[idx]) == Nst_OP_EXTEND_ARG)
+        idx++;
+    if (idx + 1 >= bc->len
+        || Nst_OP_CODE(ops[idx]) != Nst_OP_JUMPIF_IEND
+        || Nst_OP_CODE(ops[idx + 1]) != Nst_OP_UNPACK_SEQ
+        || Nst_OP_ARG(ops[idx + 1]) != count)
+    {
+        return false;
+    }
+
+    Nst_IterUnpackResult res = Nst_iter_next_unpacked(iter, count, values);
+    if (res == Nst_UNPACK_UNSUPPORTED)
+        return false;
+    else if (res == Nst_UNPACK_FAILED) {
+        *result = INST_FAILED;
+        return true;
+    } else if (res == Nst_UNPACK_END) {
+        *result = push_val(Nst_c.IEnd_iend) ? INST_SUCCESS : INST_FAILED;
+        return true;
+    }
+
+    while (i_state.v_stack.len + count > i_state.v_stack.cap) {
+        if (!grow_v_stack()) {
+            for (usize i = 0; i < count; i++)
+                Nst_dec_ref(values[i]);
+            *result = INST_FAILED;
+            return true;
+        }
+    }
+    // the first value ends up on top
+    for (usize i = 0; i < count; i++)
+        i_state.v_stack.stack[i_state.v_stack.len++] = values[count - i - 1];
+
+    // continue after UNPACK_SEQ
+    i_state.idx = (i64)idx + 1;
+
+    *result = INST_SUCCESS;
+    return true;
 }
 
 static OpResult exe_jumpif_iend(void)
@@ -927,30 +1632,18 @@ static OpResult exe_return_val(void)
     CHECK_V_STACK(1);
 
     Nst_Obj *result = pop_val();
-    Nst_Obj *obj = pop_val();
+    drop_vals(i_state.v_stack.len - i_state.vstack_base);
 
-    while (obj != NULL) {
-        Nst_dec_ref(obj);
-        obj = pop_val();
-    }
-    if (!push_val(result)) {
-        Nst_dec_ref(result);
-        return INST_FAILED;
-    }
+    // the stack has room for the result since at least one value was popped
+    i_state.v_stack.stack[i_state.v_stack.len++] = result;
     i_state.idx = bc->len;
-    Nst_dec_ref(result);
     return INST_SUCCESS;
 }
 
 static OpResult exe_return_vars(void)
 {
     Nst_Obj *vars = i_state.vt.vars;
-    Nst_Obj *obj = pop_val();
-
-    while (obj != NULL) {
-        Nst_dec_ref(obj);
-        obj = pop_val();
-    }
+    drop_vals(i_state.v_stack.len - i_state.vstack_base);
 
     if (!push_val(vars))
         return INST_FAILED;
@@ -969,7 +1662,7 @@ static OpResult exe_set_val_loc(void)
 
 static OpResult exe_set_cont_loc(void)
 {
-    i32 res = exe_set_cont_val();
+    i32 res = set_cont_val(true);
     if (res == INST_FAILED)
         return INST_FAILED;
 
@@ -1042,6 +1735,14 @@ static OpResult exe_push_val(void)
 }
 
 static OpResult exe_set_cont_val(void)
+{
+    return set_cont_val(false);
+}
+
+// Sets the value of a container leaving it on the stack, `loc` tells which
+// specialized instruction replaces the current one, SET_CONT_LOC or
+// SET_CONT_VAL
+static OpResult set_cont_val(bool loc)
 {
     CHECK_V_STACK(3);
     Nst_Obj *idx = pop_val();
@@ -1059,17 +1760,33 @@ static OpResult exe_set_cont_val(void)
             goto end;
         }
 
+        quicken(loc ? Nst_OP_SET_CONT_LOC_SEQ_INT : Nst_OP_SET_CONT_SEQ_INT);
         if (!Nst_seq_set(cont, Nst_int_i64(idx), val))
             return_value = INST_FAILED;
         goto end;
     } else if (cont->type == Nst_t.Map) {
+        quicken(loc ? Nst_OP_SET_CONT_LOC_MAP : Nst_OP_SET_CONT_MAP);
         if (!Nst_map_set(cont, idx, val))
             return_value = INST_FAILED;
         goto end;
+    } else if (Nst_is_typed_array(cont)) {
+        if (idx->type != Nst_t.Int) {
+            Nst_error_setf_type(
+                "expected type 'Int', got '%s' instead",
+                Nst_type_name(idx->type).value);
+
+            return_value = INST_FAILED;
+            goto end;
+        }
+
+        if (!Nst_typed_array_set(cont, Nst_int_i64(idx), val))
+            return_value = INST_FAILED;
+        goto end;
     }
 
     Nst_error_setf_type(
-        "expected type 'Array', 'Vector', or 'Map', got '%s' instead",
+        "expected type 'Array', 'Vector', 'Map' or a typed array, got '%s' "
+        "instead",
         Nst_type_name(cont->type).value);
     return_value = INST_FAILED;
 
@@ -1079,82 +1796,19 @@ end:
     return return_value;
 }
 
-static OpResult call_c_func(bool is_seq_call, usize arg_num, Nst_Obj *args_seq,
-                            Nst_Obj *func)
+// Pushes the result of a C function on the stack and removes the reference to
+// the function
+static OpResult push_c_result(Nst_Obj *res, Nst_Obj *func)
 {
-    usize tot_args = Nst_func_arg_num(func);
-
-    if (tot_args < arg_num) {
-        Nst_error_set_call(
-            _Nst_WRONG_ARG_NUM(tot_args, arg_num));
-        Nst_dec_ref(func);
-        Nst_ndec_ref(args_seq);
-        return INST_FAILED;
-    }
-
-    usize null_args = tot_args - arg_num;
-
-    Nst_Obj **args;
-    Nst_Obj *stack_args[10]; // for up to 10 arguments this array is used
-
-    if (tot_args == 0)
-        args = NULL;
-    else if (is_seq_call && null_args == 0)
-        args = Nst_seq_objs(args_seq);
-    else if (is_seq_call && tot_args <= 10) {
-        memcpy(stack_args, Nst_seq_objs(args_seq), arg_num * sizeof(Nst_Obj *));
-        args = stack_args;
-    } else if (is_seq_call) {
-        args = Nst_malloc_c(tot_args, Nst_Obj *);
-        if (args == NULL) {
-            Nst_dec_ref(args_seq);
-            Nst_dec_ref(func);
-            return INST_FAILED;
-        }
-        memcpy(args, Nst_seq_objs(args_seq), arg_num * sizeof(Nst_Obj *));
-    } else if (tot_args <= 10) {
-        for (i64 i = (i64)arg_num - 1; i >= 0; i--)
-            stack_args[i] = pop_val();
-        args = stack_args;
-    } else {
-        args = Nst_malloc_c(tot_args, Nst_Obj *);
-        if (args == NULL) {
-            Nst_dec_ref(func);
-            return INST_FAILED;
-        }
-        for (i64 i = (i64)arg_num - 1; i >= 0; i--)
-            args[i] = pop_val();
-    }
-
-    for (usize i = 0; i < null_args; i++)
-        args[arg_num + i] = Nst_inc_ref(Nst_c.Null_null);
-
-    Nst_Obj *res = Nst_func_c_body(func)(tot_args, args);
-
-    if (!is_seq_call) {
-        for (usize i = 0; i < tot_args; i++)
-            Nst_dec_ref(args[i]);
-    } else {
-        for (usize i = 0; i < null_args; i++)
-            Nst_dec_ref(args[arg_num + i]);
-    }
-
-    if (args != stack_args && !is_seq_call)
-        Nst_free(args);
-
-    if (res == NULL) {
-        Nst_dec_ref(func);
+    Nst_dec_ref(func);
+    if (res == NULL)
         return INST_FAILED;
-    }
 
     if (!push_val(res)) {
         Nst_dec_ref(res);
-        Nst_dec_ref(func);
         return INST_FAILED;
     }
-
     Nst_dec_ref(res);
-    Nst_dec_ref(func);
     return INST_SUCCESS;
 }
 
@@ -1171,12 +1825,47 @@ static OpResult exe_op_call(void)
     }
 
     if (Nst_FUNC_IS_C(func))
-        return call_c_func(false, (usize)arg_num, NULL, func);
+        return push_c_result(call_c_func_on_stack(func, (usize)arg_num), func);
 
     bool result = push_func(func, Nst_state_span(), (usize)arg_num, NULL, NULL);
     return result ? INST_NEW_FUNC : INST_FAILED;
 }
 
+// A call followed by a return replaces the frame of the current function
+// instead of pushing a new one. The frames of the main program and of modules,
+// calls inside a `try` block and calls to C functions are handled as normal
+// calls.
+static OpResult exe_op_tail_call(void)
+{
+    CHECK_V_STACK(op_arg + 1);
+
+    Nst_Obj *func = FAST_TOP;
+    if (!tail_calls
+        || func->type != Nst_t.Func
+        || Nst_FUNC_IS_C(func)
+        || i_state.vt.global_table == NULL
+        || Nst_bc_find_handler(bc, (usize)i_state.idx) != NULL)
+    {
+        return exe_op_call();
+    }
+
+    func = pop_val();
+    Nst_VarTable new_vt;
+    if (!init_func_vt(&new_vt, func, (usize)op_arg, NULL)) {
+        Nst_dec_ref(func);
+        return INST_FAILED;
+    }
+
+    drop_vals(i_state.v_stack.len - i_state.vstack_base);
+    Nst_vt_destroy(&i_state.vt);
+    Nst_dec_ref(i_state.func);
+    i_state.func = func;
+    i_state.vt = new_vt;
+    i_state.idx = 0;
+    op_arg = 0;
+    return INST_NEW_FUNC;
+}
+
 static OpResult exe_op_seq_call(void)
 {
     CHECK_V_STACK(2);
@@ -1201,8 +1890,11 @@ static OpResult exe_op_seq_call(void)
     }
 
     usize arg_num = Nst_seq_len(args_seq);
-    if (Nst_FUNC_IS_C(func))
-        return call_c_func(true, arg_num, args_seq, func);
+    if (Nst_FUNC_IS_C(func)) {
+        Nst_Obj *res = call_c_func(func, arg_num, Nst_seq_objs(args_seq));
+        Nst_dec_ref(args_seq);
+        return push_c_result(res, func);
+    }
     bool result = push_func(
         func,
         Nst_state_span(),
@@ -1327,6 +2019,37 @@ static OpResult exe_stack_op(void)
     return INST_SUCCESS;
 }
 
+// Applies the operator of a fused instruction to the top of the stack and
+// `ob2`, a new reference is taken from `ob2`
+static OpResult fused_stack_op(Nst_Obj *ob2)
+{
+    Nst_Obj *ob1 = pop_val();
+    Nst_Obj *res = stack_op_func[Nst_INST_FUSED_OP(op_arg)](ob1, ob2);
+    Nst_dec_ref(ob1);
+    Nst_dec_ref(ob2);
+
+    if (res == NULL || !push_val(res)) {
+        Nst_ndec_ref(res);
+        return INST_FAILED;
+    }
+    Nst_dec_ref(res);
+    return INST_SUCCESS;
+}
+
+static OpResult exe_push_stack_op(void)
+{
+    CHECK_V_STACK(1);
+    Nst_Obj *obj = op_objs[Nst_INST_FUSED_OBJ(op_arg)];
+    return fused_stack_op(Nst_inc_ref(obj));
+}
+
+static OpResult exe_get_stack_op(void)
+{
+    CHECK_V_STACK(1);
+    Nst_Obj *obj = Nst_vt_get(i_state.vt, op_objs[Nst_INST_FUSED_OBJ(op_arg)]);
+    return fused_stack_op(obj == NULL ? Nst_null_ref() : obj);
+}
+
 static OpResult exe_local_op(void)
 {
     CHECK_V_STACK(1);
@@ -1381,11 +2104,13 @@ static OpResult exe_op_extract(void)
             goto end;
         }
 
+        quicken(Nst_OP_EXTRACT_SEQ_INT);
         res = Nst_seq_get(cont, Nst_int_i64(idx));
 
         if (res == NULL || !push_val(res))
             return_value = INST_FAILED;
     } else if (cont->type == Nst_t.Map) {
+        quicken(Nst_OP_EXTRACT_MAP);
         res = Nst_map_get(cont, idx);
 
         if (res == NULL && idx->hash == -1) {
@@ -1407,13 +2132,29 @@ static OpResult exe_op_extract(void)
             goto end;
         }
 
+        quicken(Nst_OP_EXTRACT_STR_INT);
         res = Nst_str_get_obj(cont, Nst_int_i64(idx));
 
+        if (res == NULL || !push_val(res))
+            return_value = INST_FAILED;
+    } else if (Nst_is_typed_array(cont)) {
+        if (idx->type != Nst_t.Int) {
+            Nst_error_setf_type(
+                "expected type 'Int', got '%s' instead",
+                Nst_type_name(idx->type).value);
+
+            return_value = INST_FAILED;
+            goto end;
+        }
+
+        res = Nst_typed_array_get(cont, Nst_int_i64(idx));
+
         if (res == NULL || !push_val(res))
             return_value = INST_FAILED;
     } else {
         Nst_error_setf_type(
-            "expected type 'Array', 'Vector', 'Map' or 'Str', got '%s' instead",
+            "expected type 'Array', 'Vector', 'Map', 'Str' or a typed array, "
+            "got '%s' instead",
             Nst_type_name(cont->type).value);
         return_value = INST_FAILED;
     }
@@ -1425,6 +2166,159 @@ end:
     return return_value;
 }
 
+// Rewrites the instruction being executed keeping its argument, which for the
+// instructions that can be quickened counts how many times they were
+// deoptimized
+static inline void rewrite_op(Nst_OpCode code)
+{
+    bc->bytecode[i_state.idx] = ((Nst_Op)code << 24) | (Nst_Op)op_arg;
+}
+
+// Specializes the instruction being executed unless it was deoptimized too
+// many times, in which case the types it sees change too often for the
+// rewrite to pay off
+static inline void quicken(Nst_OpCode code)
+{
+    if (op_arg < QUICKEN_MAX_DEOPTS)
+        rewrite_op(code);
+}
+
+// Restores the generic form of a quickened instruction whose guard failed and
+// executes it, the stack has not been modified yet
+static OpResult deopt(Nst_OpCode generic)
+{
+    op_arg++;
+    rewrite_op(generic);
+    return inst_func[generic]();
+}
+
+static inline bool is_seq_int_access(void)
+{
+    Nst_Obj *cont_t = FAST_AT(2)->type;
+    return (cont_t == Nst_t.Array || cont_t == Nst_t.Vector)
+        && FAST_TOP->type == Nst_t.Int;
+}
+
+static inline bool is_map_access(void)
+{
+    return FAST_AT(2)->type == Nst_t.Map;
+}
+
+static inline bool is_str_int_access(void)
+{
+    return FAST_AT(2)->type == Nst_t.Str && FAST_TOP->type == Nst_t.Int;
+}
+
+// Replaces the container and the index on the top of the stack with the
+// result of an extraction, a reference is taken from `res`
+static OpResult replace_cont_and_idx(Nst_Obj *res)
+{
+    Nst_Obj *cont = FAST_AT(2);
+    Nst_Obj *idx = FAST_TOP;
+    i_state.v_stack.len -= 2;
+
+    if (res != NULL)
+        i_state.v_stack.stack[i_state.v_stack.len++] = res;
+    Nst_dec_ref(cont);
+    Nst_dec_ref(idx);
+    return res == NULL ? INST_FAILED : INST_SUCCESS;
+}
+
+static OpResult exe_extract_seq_int(void)
+{
+    CHECK_V_STACK(2);
+    if (!is_seq_int_access())
+        return deopt(Nst_OP_EXTRACT);
+    return replace_cont_and_idx(
+        Nst_seq_get(FAST_AT(2), Nst_int_i64(FAST_TOP)));
+}
+
+static OpResult exe_extract_map(void)
+{
+    CHECK_V_STACK(2);
+    if (!is_map_access())
+        return deopt(Nst_OP_EXTRACT);
+
+    Nst_Obj *idx = FAST_TOP;
+    Nst_Obj *res = Nst_map_get(FAST_AT(2), idx);
+    if (res == NULL && idx->hash == -1) {
+        Nst_error_setf_type(
+            "type '%s' is not hashable",
+            Nst_type_name(idx->type).value);
+    } else if (res == NULL)
+        res = Nst_null_ref();
+    return replace_cont_and_idx(res);
+}
+
+static OpResult exe_extract_str_int(void)
+{
+    CHECK_V_STACK(2);
+    if (!is_str_int_access())
+        return deopt(Nst_OP_EXTRACT);
+    return replace_cont_and_idx(
+        Nst_str_get_obj(FAST_AT(2), Nst_int_i64(FAST_TOP)));
+}
+
+// Sets the value below the container and the index, which are popped, the
+// value is left on the stack
+static OpResult set_seq_int(void)
+{
+    Nst_Obj *idx = pop_val();
+    Nst_Obj *cont = pop_val();
+    bool res = Nst_seq_set(cont, Nst_int_i64(idx), FAST_TOP);
+    Nst_dec_ref(cont);
+    Nst_dec_ref(idx);
+    return res ? INST_SUCCESS : INST_FAILED;
+}
+
+static OpResult set_map(void)
+{
+    Nst_Obj *idx = pop_val();
+    Nst_Obj *cont = pop_val();
+    bool res = Nst_map_set(cont, idx, FAST_TOP);
+    Nst_dec_ref(cont);
+    Nst_dec_ref(idx);
+    return res ? INST_SUCCESS : INST_FAILED;
+}
+
+static OpResult exe_set_cont_seq_int(void)
+{
+    CHECK_V_STACK(3);
+    if (!is_seq_int_access())
+        return deopt(Nst_OP_SET_CONT_VAL);
+    return set_seq_int();
+}
+
+static OpResult exe_set_cont_map(void)
+{
+    CHECK_V_STACK(3);
+    if (!is_map_access())
+        return deopt(Nst_OP_SET_CONT_VAL);
+    return set_map();
+}
+
+static OpResult exe_set_cont_loc_seq_int(void)
+{
+    CHECK_V_STACK(3);
+    if (!is_seq_int_access())
+        return deopt(Nst_OP_SET_CONT_LOC);
+    if (set_seq_int() == INST_FAILED)
+        return INST_FAILED;
+    pop_and_destroy();
+    return INST_SUCCESS;
+}
+
+static OpResult exe_set_cont_loc_map(void)
+{
+    CHECK_V_STACK(3);
+    if (!is_map_access())
+        return deopt(Nst_OP_SET_CONT_LOC);
+    if (set_map() == INST_FAILED)
+        return INST_FAILED;
+    pop_and_destroy();
+    return INST_SUCCESS;
+}
+
 static OpResult exe_dec_int(void)
 {
     CHECK_V_STACK(1);
@@ -1614,39 +2508,22 @@ static OpResult exe_make_func(void)
     }
 
     _Nst_func_set_mod_globals(func, i_state.vt.global_table);
-    Nst_Obj *vars_copy = Nst_map_copy(i_state.vt.vars);
-    if (vars_copy == NULL)
-        return INST_FAILED;
 
-    Nst_ndec_ref(Nst_map_drop(vars_copy, Nst_s.o__vars_));
-    Nst_ndec_ref(Nst_map_drop(vars_copy, Nst_s.o__globals_));
-    Nst_Obj *new_func = _Nst_func_new_outer_vars(func, vars_copy);
-    Nst_dec_ref(vars_copy);
+    // a function that does not capture any variable can be shared
+    Nst_Obj *outer_names = Nst_func_outer_names(func);
+    if (outer_names != NULL && Nst_seq_len(outer_names) == 0)
+        return push_val(func) ? INST_SUCCESS : INST_FAILED;
+
+    Nst_Obj *new_func = _Nst_func_new_outer_vars(func, i_state.vt.vars);
     if (new_func == NULL || !push_val(new_func)) {
         Nst_ndec_ref(new_func);
         return INST_FAILED;
     }
+    Nst_dec_ref(new_func);
 
     return INST_SUCCESS;
 }
 
-static OpResult exe_push_catch(void)
-{
-    Nst_CatchFrame cf = {
-        .idx = (i64)op_arg,
-        .v_stack_len = i_state.v_stack.len,
-        .f_stack_len = i_state.f_stack.len
-    };
-    Nst_cstack_push(&i_state.c_stack, cf);
-    return INST_SUCCESS;
-}
-
-static OpResult exe_pop_catch(void)
-{
-    Nst_cstack_pop(&i_state.c_stack);
-    return INST_SUCCESS;
-}
-
 static OpResult exe_save_error(void)
 {
     Nst_assert(Nst_error_occurred());
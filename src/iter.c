@@ -8,6 +8,10 @@ typedef struct _Nst_IterObj {
     Nst_Obj *start;
     Nst_Obj *next;
     Nst_Obj *value;
+    // the bodies of `start` and `next` for native iterators
+    Nst_NestCallable start_c;
+    Nst_NestCallable next_c;
+    Nst_IterUnpackFunc unpack;
 } Nst_IterObj;
 
 #define ITER(ptr) ((Nst_IterObj *)(ptr))
@@ -22,6 +26,16 @@ typedef struct _IterContainer {
     Nst_Obj *obj;
 } _IterContainer;
 
+// Whether the function can be called passing its body only the value of the
+// iterator
+static inline bool is_native_func(Nst_Obj *func)
+{
+    return Nst_FUNC_IS_C(func) && Nst_func_arg_num(func) == 1;
+}
+
+static Nst_IterUnpackResult map_unpack(Nst_Obj *value, usize count,
+                                       Nst_Obj **out);
+
 static void destroy_iter_container(Nst_Obj *custom_obj)
 {
     Nst_dec_ref(((_IterContainer *)Nst_obj_custom_data(custom_obj))->obj);
@@ -50,6 +64,15 @@ Nst_ObjRef *Nst_iter_new(Nst_ObjRef *start, Nst_ObjRef *next,
     iter->start = start;
     iter->next  = next;
     iter->value = value;
+    iter->start_c = NULL;
+    iter->next_c  = NULL;
+    iter->unpack  = NULL;
+
+    if (is_native_func(start) && is_native_func(next)) {
+        iter->start_c = Nst_func_c_body(start);
+        iter->next_c  = Nst_func_c_body(next);
+        Nst_SET_FLAG(iter, Nst_FLAG_ITER_IS_NATIVE);
+    }
 
     return NstOBJ(iter);
 }
@@ -76,7 +99,11 @@ bool Nst_iter_start(Nst_Obj *iter)
 {
     Nst_assert(iter->type == Nst_t.Iter);
 
-    Nst_Obj *result = Nst_func_call(ITER(iter)->start, 1, &ITER(iter)->value);
+    Nst_Obj *result;
+    if (Nst_ITER_IS_NATIVE(iter))
+        result = ITER(iter)->start_c(1, &ITER(iter)->value);
+    else
+        result = Nst_func_call(ITER(iter)->start, 1, &ITER(iter)->value);
 
     if (result == NULL)
         return false;
@@ -89,9 +116,28 @@ Nst_Obj *Nst_iter_next(Nst_Obj *iter)
 {
     Nst_assert(iter->type == Nst_t.Iter);
 
+    if (Nst_ITER_IS_NATIVE(iter))
+        return ITER(iter)->next_c(1, &ITER(iter)->value);
     return Nst_func_call(ITER(iter)->next, 1, &ITER(iter)->value);
 }
 
+void Nst_iter_set_unpack(Nst_Obj *iter, Nst_IterUnpackFunc unpack)
+{
+    Nst_assert(iter->type == Nst_t.Iter);
+    Nst_assert(Nst_ITER_IS_NATIVE(iter));
+    ITER(iter)->unpack = unpack;
+}
+
+Nst_IterUnpackResult Nst_iter_next_unpacked(Nst_Obj *iter, usize count,
+                                            Nst_Obj **out)
+{
+    Nst_assert(iter->type == Nst_t.Iter);
+
+    if (ITER(iter)->unpack == NULL)
+        return Nst_UNPACK_UNSUPPORTED;
+    return ITER(iter)->unpack(ITER(iter)->value, count, out);
+}
+
 Nst_Obj *Nst_iter_start_func(Nst_Obj *iter)
 {
     Nst_assert(iter->type == Nst_t.Iter);
@@ -191,10 +237,34 @@ Nst_ObjRef *Nst_iter_map_new(Nst_Obj *map)
     if (map_data == NULL)
         return NULL;
 
-    return Nst_iter_new(
+    Nst_Obj *iter = Nst_iter_new(
         Nst_inc_ref(Nst_itf.map_start),
         Nst_inc_ref(Nst_itf.map_next),
         map_data);
+    if (iter != NULL)
+        Nst_iter_set_unpack(iter, map_unpack);
+    return iter;
+}
+
+Nst_ObjRef *Nst_iter_typed_array_new(Nst_Obj *arr)
+{
+    Nst_assert(Nst_is_typed_array(arr));
+    _IterContainer data = {
+        .idx = 0,
+        .obj = Nst_inc_ref(arr)
+    };
+
+    Nst_Obj *arr_data = Nst_obj_custom_ex(
+        _IterContainer,
+        &data,
+        destroy_iter_container);
+    if (arr_data == NULL)
+        return NULL;
+
+    return Nst_iter_new(
+        Nst_inc_ref(Nst_itf.typed_array_start),
+        Nst_inc_ref(Nst_itf.typed_array_next),
+        arr_data);
 }
 
 Nst_Obj *NstC Nst_iter_range_start(usize arg_num, Nst_Obj **args)
@@ -295,3 +365,44 @@ Nst_Obj *NstC Nst_iter_map_next(usize arg_num, Nst_Obj **args)
     data->idx = idx;
     return arr;
 }
+
+Nst_Obj *NstC Nst_iter_typed_array_start(usize arg_num, Nst_Obj **args)
+{
+    Nst_UNUSED(arg_num);
+    _IterContainer *data = Nst_obj_custom_data(args[0]);
+    data->idx = 0;
+    return Nst_null_ref();
+}
+
+Nst_Obj *NstC Nst_iter_typed_array_next(usize arg_num, Nst_Obj **args)
+{
+    Nst_UNUSED(arg_num);
+    _IterContainer *data = Nst_obj_custom_data(args[0]);
+    Nst_Obj *arr = data->obj;
+
+    if (data->idx >= (i64)Nst_typed_array_len(arr))
+        return Nst_iend_ref();
+
+    return Nst_typed_array_getf(arr, (usize)data->idx++);
+}
+
+// Unpacks the pairs of a map without creating the array returned by
+// `Nst_iter_map_next`
+static Nst_IterUnpackResult map_unpack(Nst_Obj *value, usize count,
+                                       Nst_Obj **out)
+{
+    if (count != 2)
+        return Nst_UNPACK_UNSUPPORTED;
+
+    _IterContainer *data = Nst_obj_custom_data(value);
+    Nst_Obj *key;
+    Nst_Obj *val;
+    isize idx = Nst_map_next((isize)data->idx, data->obj, &key, &val);
+    if (idx == -1)
+        return Nst_UNPACK_END;
+
+    data->idx = idx;
+    out[0] = Nst_inc_ref(key);
+    out[1] = Nst_inc_ref(val);
+    return Nst_UNPACK_SUCCESS;
+}
@@ -178,29 +178,8 @@ void _Nst_obj_free(Nst_Obj *obj)
 
     Nst_Obj *ob_t = obj->type;
 
-    if (Nst_HAS_FLAG(obj, Nst_FLAG_GGC_IS_SUPPORTED)) {
-        Nst_GGCObj *ggc_obj = GGC_OBJ(obj);
-        Nst_GGCList *ls = ggc_obj->ggc_list;
-
-        // if ls is NULL it means that the object is being deleted in a garbage
-        // collection
-        if (ls == NULL)
-            goto free_mem;
-
-        if (ls->head == ggc_obj)
-            ls->head = GGC_OBJ(ggc_obj->p_next);
-        else
-            ggc_obj->p_prev->p_next = ggc_obj->p_next;
-
-        if (ls->tail == ggc_obj)
-            ls->tail = GGC_OBJ(ggc_obj->p_prev);
-        else
-            GGC_OBJ(ggc_obj->p_next)->p_prev = ggc_obj->p_prev;
-
-        ls->len--;
-    }
-
-free_mem:
+    if (Nst_HAS_FLAG(obj, Nst_FLAG_GGC_IS_SUPPORTED))
+        _Nst_ggc_untrack_obj(GGC_OBJ(obj));
 
 // silences the warning of the expression being always true when _Nst_P_LEN_MAX
 // is 0 (e.g. when pools are disabled)
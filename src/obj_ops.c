@@ -20,6 +20,10 @@
      || obj->type == Nst_t.Byte)
 #define IS_INT(obj) (obj->type == Nst_t.Int || obj->type == Nst_t.Byte)
 #define IS_SEQ(obj) (obj->type == Nst_t.Array || obj->type == Nst_t.Vector)
+#define IS_TYPED_ARRAY(obj)                                                   \
+    (obj->type == Nst_t.IntArray                                              \
+     || obj->type == Nst_t.RealArray                                          \
+     || obj->type == Nst_t.ByteArray)
 #define ARE_TYPE(type_obj) (ob1->type == type_obj && ob2->type == type_obj)
 
 #define RETURN_STACK_OP_TYPE_ERROR(operand) do {                              \
@@ -51,6 +55,7 @@
 static Nst_Obj *seq_eq(Nst_Obj *seq1, Nst_Obj *seq2,
                        Nst_LList *containers);
 static Nst_Obj *map_eq(Nst_Obj *map1, Nst_Obj *map2, Nst_LList *containers);
+static Nst_Obj *typed_array_eq(Nst_Obj *arr1, Nst_Obj *arr2);
 
 bool Nst_obj_eq_c(Nst_Obj *ob1, Nst_Obj *ob2)
 {
@@ -100,10 +105,39 @@ Nst_Obj *Nst_obj_eq(Nst_Obj *ob1, Nst_Obj *ob2)
         Nst_Obj *res = map_eq(ob1, ob2, &containers);
         Nst_llist_empty(&containers, NULL);
         return res;
-    } else
+    } else if (IS_TYPED_ARRAY(ob1) && ob1->type == ob2->type)
+        return typed_array_eq(ob1, ob2);
+    else
         return Nst_false_ref();
 }
 
+static Nst_Obj *typed_array_eq(Nst_Obj *arr1, Nst_Obj *arr2)
+{
+    usize len = Nst_typed_array_len(arr1);
+    if (len != Nst_typed_array_len(arr2))
+        return Nst_false_ref();
+
+    if (arr1->type == Nst_t.IntArray) {
+        i64 *values1 = Nst_int_array_values(arr1);
+        i64 *values2 = Nst_int_array_values(arr2);
+        Nst_RETURN_BOOL(memcmp(values1, values2, len * sizeof(i64)) == 0);
+    } else if (arr1->type == Nst_t.ByteArray) {
+        u8 *values1 = Nst_byte_array_values(arr1);
+        u8 *values2 = Nst_byte_array_values(arr2);
+        Nst_RETURN_BOOL(memcmp(values1, values2, len) == 0);
+    }
+
+    f64 *values1 = Nst_real_array_values(arr1);
+    f64 *values2 = Nst_real_array_values(arr2);
+    for (usize i = 0; i < len; i++) {
+        if (isnan(values1[i]) || isnan(values2[i]))
+            return Nst_false_ref();
+        if (fabs(values1[i] - values2[i]) >= REAL_EPSILON)
+            return Nst_false_ref();
+    }
+    return Nst_true_ref();
+}
+
 static Nst_Obj *seq_eq(Nst_Obj *seq1, Nst_Obj *seq2,
                        Nst_LList *containers)
 {
@@ -771,6 +805,53 @@ Nst_Obj *_Nst_obj_str_cast_map(Nst_Obj *map_obj, Nst_LList *all_objs)
     return Nst_str_from_sb(&sb);
 }
 
+static Nst_Obj *typed_array_to_str(Nst_Obj *arr)
+{
+    usize len = Nst_typed_array_len(arr);
+
+    Nst_StrBuilder sb;
+    if (!Nst_sb_init(&sb, len * 3 + 12))
+        return NULL;
+
+    if (!Nst_sb_push_sv(&sb, Nst_type_name(arr->type))) {
+        Nst_sb_destroy(&sb);
+        return NULL;
+    }
+
+    if (len == 0) {
+        if (!Nst_sb_push_c(&sb, "{,}")) {
+            Nst_sb_destroy(&sb);
+            return NULL;
+        }
+        return Nst_str_from_sb(&sb);
+    }
+
+    Nst_sb_push_char(&sb, '{');
+    for (usize i = 0; i < len; i++) {
+        Nst_Obj *ob = Nst_typed_array_getf(arr, i);
+        if (ob == NULL) {
+            Nst_sb_destroy(&sb);
+            return NULL;
+        }
+        Nst_Obj *ob_str = Nst_obj_to_repr_str(ob);
+        Nst_dec_ref(ob);
+        if (ob_str == NULL) {
+            Nst_sb_destroy(&sb);
+            return NULL;
+        }
+
+        bool result = Nst_sb_push_str(&sb, ob_str)
+                   && Nst_sb_push_c(&sb, i == len - 1 ? "}" : ", ");
+        Nst_dec_ref(ob_str);
+        if (!result) {
+            Nst_sb_destroy(&sb);
+            return NULL;
+        }
+    }
+
+    return Nst_str_from_sb(&sb);
+}
+
 #ifndef Nst_MSVC
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
 #endif
@@ -823,7 +904,9 @@ static Nst_Obj *obj_to_str(Nst_Obj *ob)
         Nst_Obj *str = _Nst_obj_str_cast_map(ob, &all_objs);
         Nst_llist_empty(&all_objs, NULL);
         return str;
-    } else if (ob_t == Nst_t.Null)
+    } else if (IS_TYPED_ARRAY(ob))
+        return typed_array_to_str(ob);
+    else if (ob_t == Nst_t.Null)
         return Nst_inc_ref(Nst_s.c_null);
     else if (ob_t == Nst_t.IOFile) {
         const char *empty_val = "<IOFile[-----]>";
@@ -873,6 +956,8 @@ static Nst_Obj *obj_to_bool(Nst_Obj *ob)
         Nst_RETURN_BOOL(Nst_map_len(ob) != 0);
     else if (ob_t == Nst_t.Array || ob_t == Nst_t.Vector)
         Nst_RETURN_BOOL(Nst_seq_len(ob) != 0);
+    else if (IS_TYPED_ARRAY(ob))
+        Nst_RETURN_BOOL(Nst_typed_array_len(ob) != 0);
     else if (ob_t == Nst_t.Null)
         return Nst_false_ref();
     else if (ob_t == Nst_t.Byte)
@@ -962,6 +1047,28 @@ static Nst_Obj *seq_to_seq(Nst_Obj *ob, bool is_vect)
     return seq;
 }
 
+static Nst_Obj *typed_array_to_seq(Nst_Obj *ob, bool is_vect)
+{
+    usize arr_len = Nst_typed_array_len(ob);
+    Nst_Obj *seq = is_vect ? _Nst_vector_new_empty(arr_len)
+                           : _Nst_array_new_empty(arr_len);
+    if (seq == NULL)
+        return NULL;
+
+    Nst_Obj **objs = Nst_seq_objs(seq);
+    for (usize i = 0; i < arr_len; i++) {
+        objs[i] = Nst_typed_array_getf(ob, i);
+        if (objs[i] == NULL) {
+            for (usize j = i; j < arr_len; j++)
+                objs[j] = Nst_null_ref();
+            Nst_dec_ref(seq);
+            return NULL;
+        }
+    }
+
+    return seq;
+}
+
 static Nst_Obj *str_to_seq(Nst_Obj *ob, bool is_vect)
 {
     usize str_len = Nst_str_char_len(ob);
@@ -1059,9 +1166,118 @@ static Nst_Obj *obj_to_seq(Nst_Obj *ob, bool is_vect)
         return iter_to_seq(ob, is_vect);
     else if (ob_t == Nst_t.Map)
         return map_to_seq(ob, is_vect);
+    else if (IS_TYPED_ARRAY(ob))
+        return typed_array_to_seq(ob, is_vect);
     RETURN_CAST_TYPE_ERROR(is_vect ? Nst_t.Vector : Nst_t.Array);
 }
 
+static Nst_Obj *new_typed_array(usize len, Nst_Obj *type)
+{
+    if (type == Nst_t.IntArray)
+        return Nst_int_array_new(len);
+    else if (type == Nst_t.RealArray)
+        return Nst_real_array_new(len);
+    return Nst_byte_array_new(len);
+}
+
+static Nst_Obj *seq_to_typed_array(Nst_Obj *ob, Nst_Obj *type)
+{
+    usize seq_len = Nst_seq_len(ob);
+    Nst_Obj *arr = new_typed_array(seq_len, type);
+    if (arr == NULL)
+        return NULL;
+
+    Nst_Obj **objs = Nst_seq_objs(ob);
+    for (usize i = 0; i < seq_len; i++) {
+        if (!Nst_typed_array_set(arr, (i64)i, objs[i])) {
+            Nst_dec_ref(arr);
+            return NULL;
+        }
+    }
+    return arr;
+}
+
+static Nst_Obj *typed_array_to_typed_array(Nst_Obj *ob, Nst_Obj *type)
+{
+    usize arr_len = Nst_typed_array_len(ob);
+    Nst_Obj *arr = new_typed_array(arr_len, type);
+    if (arr == NULL)
+        return NULL;
+
+    for (usize i = 0; i < arr_len; i++) {
+        Nst_Obj *val = Nst_typed_array_getf(ob, i);
+        if (val == NULL || !Nst_typed_array_set(arr, (i64)i, val)) {
+            Nst_ndec_ref(val);
+            Nst_dec_ref(arr);
+            return NULL;
+        }
+        Nst_dec_ref(val);
+    }
+    return arr;
+}
+
+static Nst_Obj *iter_to_typed_array(Nst_Obj *ob, Nst_Obj *type)
+{
+    Nst_Obj *arr = new_typed_array(_Nst_VECTOR_MIN_CAP, type);
+    if (arr == NULL)
+        return NULL;
+
+    if (!Nst_iter_start(ob)) {
+        Nst_dec_ref(arr);
+        return NULL;
+    }
+
+    // the values are collected without boxing them in a Vector first, the
+    // array grows like a Vector and is shrunk to the right size at the end
+    usize len = 0;
+    usize cap = _Nst_VECTOR_MIN_CAP;
+    while (true) {
+        Nst_Obj *result = Nst_iter_next(ob);
+        if (result == NULL) {
+            Nst_dec_ref(arr);
+            return NULL;
+        } else if (result == Nst_c.IEnd_iend) {
+            Nst_dec_ref(result);
+            break;
+        }
+
+        if (len == cap) {
+            cap = (usize)(cap * _Nst_VECTOR_GROWTH_RATIO);
+            if (!_Nst_typed_array_resize(arr, cap)) {
+                Nst_dec_ref(result);
+                Nst_dec_ref(arr);
+                return NULL;
+            }
+        }
+
+        bool set_result = Nst_typed_array_set(arr, (i64)len++, result);
+        Nst_dec_ref(result);
+        if (!set_result) {
+            Nst_dec_ref(arr);
+            return NULL;
+        }
+    }
+
+    if (!_Nst_typed_array_resize(arr, len)) {
+        Nst_dec_ref(arr);
+        return NULL;
+    }
+    return arr;
+}
+
+static Nst_Obj *obj_to_typed_array(Nst_Obj *ob, Nst_Obj *type)
+{
+    Nst_Obj *ob_t = ob->type;
+
+    if (ob_t == Nst_t.Array || ob_t == Nst_t.Vector)
+        return seq_to_typed_array(ob, type);
+    else if (IS_TYPED_ARRAY(ob))
+        return typed_array_to_typed_array(ob, type);
+    else if (ob_t == Nst_t.Iter)
+        return iter_to_typed_array(ob, type);
+    RETURN_CAST_TYPE_ERROR(type);
+}
+
 static Nst_Obj *obj_to_iter(Nst_Obj *ob)
 {
     Nst_Obj *ob_t = ob->type;
@@ -1072,6 +1288,8 @@ static Nst_Obj *obj_to_iter(Nst_Obj *ob)
         return Nst_iter_seq_new(ob);
     else if (ob_t == Nst_t.Map)
         return Nst_iter_map_new(ob);
+    else if (IS_TYPED_ARRAY(ob))
+        return Nst_iter_typed_array_new(ob);
     else
         RETURN_CAST_TYPE_ERROR(Nst_t.Iter);
 }
@@ -1221,9 +1439,58 @@ Nst_Obj *Nst_obj_cast(Nst_Obj *ob, Nst_Obj *type)
         return obj_to_seq(ob, type == Nst_t.Vector);
     else if (type == Nst_t.Map)
         return obj_to_map(ob);
+    else if (type == Nst_t.IntArray
+             || type == Nst_t.RealArray
+             || type == Nst_t.ByteArray)
+    {
+        return obj_to_typed_array(ob, type);
+    }
     RETURN_CAST_TYPE_ERROR(type);
 }
 
+static Nst_Obj *typed_array_contains(Nst_Obj *arr, Nst_Obj *ob)
+{
+    if (!IS_NUM(ob))
+        return Nst_false_ref();
+
+    usize len = Nst_typed_array_len(arr);
+
+    if (arr->type != Nst_t.RealArray && IS_INT(ob)) {
+        i64 val = Nst_number_to_i64(ob);
+        if (arr->type == Nst_t.IntArray) {
+            i64 *values = Nst_int_array_values(arr);
+            for (usize i = 0; i < len; i++) {
+                if (values[i] == val)
+                    return Nst_true_ref();
+            }
+            return Nst_false_ref();
+        }
+
+        if (val < 0 || val > 255)
+            return Nst_false_ref();
+        Nst_RETURN_BOOL(
+            memchr(Nst_byte_array_values(arr), (int)val, len) != NULL);
+    }
+
+    f64 val = Nst_number_to_f64(ob);
+    if (isnan(val))
+        return Nst_false_ref();
+
+    for (usize i = 0; i < len; i++) {
+        f64 item;
+        if (arr->type == Nst_t.RealArray)
+            item = Nst_real_array_values(arr)[i];
+        else if (arr->type == Nst_t.IntArray)
+            item = (f64)Nst_int_array_values(arr)[i];
+        else
+            item = (f64)Nst_byte_array_values(arr)[i];
+
+        if (fabs(item - val) < REAL_EPSILON)
+            return Nst_true_ref();
+    }
+    return Nst_false_ref();
+}
+
 Nst_Obj *Nst_obj_contains(Nst_Obj *ob1, Nst_Obj *ob2)
 {
     if (ob1->type == Nst_t.Array || ob1->type == Nst_t.Vector) {
@@ -1247,7 +1514,9 @@ Nst_Obj *Nst_obj_contains(Nst_Obj *ob1, Nst_Obj *ob2)
     } else if (ob1->type == Nst_t.Str && ob2->type == Nst_t.Str) {
         isize idx = Nst_sv_lfind(Nst_sv_from_str(ob1), Nst_sv_from_str(ob2));
         Nst_RETURN_BOOL(idx != -1);
-    } else
+    } else if (IS_TYPED_ARRAY(ob1))
+        return typed_array_contains(ob1, ob2);
+    else
         RETURN_STACK_OP_TYPE_ERROR("<.>");
 }
 
@@ -1335,6 +1604,8 @@ Nst_Obj *Nst_obj_len(Nst_Obj *ob)
         return Nst_int_new(Nst_map_len(ob));
     else if (IS_SEQ(ob))
         return Nst_int_new(Nst_seq_len(ob));
+    else if (IS_TYPED_ARRAY(ob))
+        return Nst_int_new(Nst_typed_array_len(ob));
     else if (ob->type == Nst_t.Func)
         return Nst_int_new((i64)Nst_func_arg_num(ob));
     else
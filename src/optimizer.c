@@ -407,6 +407,10 @@ static bool remove_assign_loc_get_val(Nst_InstList *ls);
 static bool remove_push_jumpif(Nst_InstList *ls);
 static bool remove_dead_code(Nst_InstList *ls);
 static bool optimize_chained_jumps(Nst_InstList *ls);
+// replace the most frequent pairs of instructions with a single one, it must
+// be the last pass since the others do not handle the fused instructions
+static void fuse_instructions(Nst_InstList *ls);
+static void fuse_stack_ops(Nst_InstList *ls);
 
 static bool objs_eq(Nst_InstList *ls, usize idx1, usize idx2)
 {
@@ -427,6 +431,7 @@ void Nst_optimize_ilist(Nst_InstList *ls, bool optimize_builtins)
     if (optimize_builtins)
         replace_builtins(ls);
     optimize_inst_list(ls);
+    fuse_instructions(ls);
 }
 
 static void optimize_inst_list(Nst_InstList *ls)
@@ -473,6 +478,9 @@ static void replace_builtins(Nst_InstList *ls)
     replace_constant(ls, Nst_s.t_Iter, Nst_t.Iter);
     replace_constant(ls, Nst_s.t_Byte, Nst_t.Byte);
     replace_constant(ls, Nst_s.t_IOFile, Nst_t.IOFile);
+    replace_constant(ls, Nst_s.t_IntArray, Nst_t.IntArray);
+    replace_constant(ls, Nst_s.t_RealArray, Nst_t.RealArray);
+    replace_constant(ls, Nst_s.t_ByteArray, Nst_t.ByteArray);
     replace_constant(ls, Nst_s.c_true, Nst_c.Bool_true);
     replace_constant(ls, Nst_s.c_false, Nst_c.Bool_false);
     replace_constant(ls, Nst_s.c_null, Nst_c.Null_null);
@@ -974,3 +982,50 @@ static bool optimize_chained_jumps(Nst_InstList *ls)
     Nst_free(visited_jumps);
     return ret;
 }
+
+static void fuse_instructions(Nst_InstList *ls)
+{
+    fuse_stack_ops(ls);
+
+    for (usize i = 0, n = ls->functions.len; i < n; i++) {
+        Nst_FuncPrototype *func = Nst_ilist_get_func(ls, i);
+        fuse_instructions(&func->ilist);
+    }
+}
+
+static void fuse_stack_ops(Nst_InstList *ls)
+{
+    usize size = Nst_ilist_len(ls);
+    bool expect_stack_op = false;
+    usize val_idx = 0;
+
+    for (usize i = 0; i < size; i++) {
+        switch (inst_code(ls, i)) {
+        case Nst_IC_PUSH_VAL:
+        case Nst_IC_GET_VAL:
+            expect_stack_op = true;
+            val_idx = i;
+            break;
+        case Nst_IC_NO_OP:
+            break;
+        case Nst_IC_STACK_OP:
+            if (expect_stack_op && !has_jumps_to(ls, i, -1, -1)) {
+                Nst_Inst *val_inst = Nst_ilist_get_inst(ls, val_idx);
+                Nst_Inst *op_inst = Nst_ilist_get_inst(ls, i);
+                Nst_InstCode code = val_inst->code == Nst_IC_PUSH_VAL
+                                  ? Nst_IC_PUSH_STACK_OP
+                                  : Nst_IC_GET_STACK_OP;
+                // errors are thrown by the operator
+                val_inst->span = op_inst->span;
+                Nst_ilist_set_ex(
+                    ls, val_idx, code,
+                    Nst_INST_FUSED_VAL(val_inst->val, op_inst->val));
+                Nst_ilist_set(ls, i, Nst_IC_NO_OP);
+            }
+            // fallthrough
+        default:
+            expect_stack_op = false;
+            break;
+        }
+    }
+}
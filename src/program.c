@@ -37,6 +37,11 @@ Nst_ExecutionKind Nst_prog_init(Nst_Program *prog, Nst_CLArgs args)
     prog->main_func = NULL;
     prog->argv = NULL;
     prog->source_path = NULL;
+    prog->print_op_pairs = args.print_op_pairs;
+    prog->no_tail_calls = args.no_tail_calls;
+    prog->profile_path = args.profile_path;
+    prog->print_gc_stats = args.print_gc_stats;
+    prog->gc_step = args.gc_step;
 
     Nst_SourceText *src = Nst_source_load(&args);
     if (src == NULL)
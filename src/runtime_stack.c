@@ -1,7 +1,6 @@
 #include "nest.h"
 
 #define F_STACK_MIN_SIZE 128
-#define C_STACK_MIN_SIZE 4
 
 typedef struct _GenericStack {
     void *stack;
@@ -9,13 +8,16 @@ typedef struct _GenericStack {
     usize cap;
 } GenericStack;
 
+// The stacks are halved only when less than an eighth of their capacity is
+// used, this way they need to grow four times as much before reallocating
+// again
 static void shrink_stack(GenericStack *g_stack, usize min_size,
-                      usize unit_size)
+                         usize unit_size)
 {
     if (g_stack->cap <= min_size)
         return;
 
-    if (g_stack->cap >> 2 < g_stack->len)
+    if (g_stack->cap >> 3 <= g_stack->len)
         return;
 
     Nst_assert(g_stack->len <= g_stack->cap);
@@ -94,13 +96,7 @@ Nst_ObjRef *Nst_vstack_pop(Nst_ValueStack *v_stack)
     if (v_stack->len == 0)
         return NULL;
 
-    Nst_Obj *val = v_stack->stack[--v_stack->len];
-    shrink_stack(
-        (GenericStack *)v_stack,
-        _Nst_V_STACK_MIN_SIZE,
-        sizeof(Nst_Obj *));
-
-    return val;
+    return v_stack->stack[--v_stack->len];
 }
 
 Nst_Obj *Nst_vstack_peek(Nst_ValueStack *v_stack)
@@ -111,6 +107,14 @@ Nst_Obj *Nst_vstack_peek(Nst_ValueStack *v_stack)
     return v_stack->stack[v_stack->len - 1];
 }
 
+void Nst_vstack_shrink(Nst_ValueStack *v_stack)
+{
+    shrink_stack(
+        (GenericStack *)v_stack,
+        _Nst_V_STACK_MIN_SIZE,
+        sizeof(Nst_Obj *));
+}
+
 bool Nst_vstack_dup(Nst_ValueStack *v_stack)
 {
     if (v_stack->len != 0)
@@ -171,18 +175,13 @@ Nst_FuncCall Nst_fstack_pop(Nst_CallStack *f_stack)
         .vt.vars = NULL,
         .vt.global_table = NULL,
         .idx = 0,
-        .cstack_len = 0
+        .vstack_base = 0
     };
 
     if (f_stack->len == 0)
         return call;
 
-    call = f_stack->stack[--f_stack->len];
-    shrink_stack(
-        (GenericStack *)f_stack,
-        F_STACK_MIN_SIZE,
-        sizeof(Nst_FuncCall));
-    return call;
+    return f_stack->stack[--f_stack->len];
 }
 
 Nst_FuncCall Nst_fstack_peek(Nst_CallStack *f_stack)
@@ -194,7 +193,7 @@ Nst_FuncCall Nst_fstack_peek(Nst_CallStack *f_stack)
             .vt.vars = NULL,
             .vt.global_table = NULL,
             .idx = 0,
-            .cstack_len = 0
+            .vstack_base = 0
         };
         return ret_val;
     }
@@ -202,6 +201,14 @@ Nst_FuncCall Nst_fstack_peek(Nst_CallStack *f_stack)
     return f_stack->stack[f_stack->len - 1];
 }
 
+void Nst_fstack_shrink(Nst_CallStack *f_stack)
+{
+    shrink_stack(
+        (GenericStack *)f_stack,
+        F_STACK_MIN_SIZE,
+        sizeof(Nst_FuncCall));
+}
+
 void Nst_fstack_destroy(Nst_CallStack *f_stack)
 {
     if (f_stack->stack == NULL)
@@ -215,57 +222,3 @@ void Nst_fstack_destroy(Nst_CallStack *f_stack)
     Nst_free(f_stack->stack);
     f_stack->stack = NULL;
 }
-
-bool Nst_cstack_init(Nst_CatchStack *c_stack)
-{
-    return init_stack(
-        (GenericStack *)c_stack,
-        sizeof(Nst_CatchFrame),
-        C_STACK_MIN_SIZE);
-}
-
-bool Nst_cstack_push(Nst_CatchStack *c_stack, Nst_CatchFrame frame)
-{
-    bool result = expand_stack(
-        (GenericStack *)c_stack,
-        sizeof(Nst_CatchFrame));
-    if (!result)
-        return false;
-
-    usize idx = c_stack->len++;
-    c_stack->stack[idx] = frame;
-    return true;
-}
-
-Nst_CatchFrame Nst_cstack_peek(Nst_CatchStack *c_stack)
-{
-    if (c_stack->len == 0) {
-        Nst_CatchFrame frame = { 0, 0, -1 };
-        return frame;
-    }
-
-    return c_stack->stack[c_stack->len - 1];
-}
-
-Nst_CatchFrame Nst_cstack_pop(Nst_CatchStack *c_stack)
-{
-    Nst_CatchFrame frame = { 0, 0, -1 };
-    if (c_stack->len == 0)
-        return frame;
-
-    frame = c_stack->stack[--c_stack->len];
-    shrink_stack(
-        (GenericStack *)c_stack,
-        C_STACK_MIN_SIZE,
-        sizeof(Nst_CatchFrame));
-    return frame;
-}
-
-void Nst_cstack_destroy(Nst_CatchStack *c_stack)
-{
-    if (c_stack->stack == NULL)
-        return;
-
-    Nst_free(c_stack->stack);
-    c_stack->stack = NULL;
-}
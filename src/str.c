@@ -10,6 +10,8 @@
  * @param value: the value of the string
  * @param indexable_str: the string in UTF-16 or UTF-32 depending on the
  * characters it contains
+ * @param owner: the string that owns `value` when it is shared with a slice,
+ * `NULL` otherwise
  */
 NstEXP typedef struct _Nst_StrObj {
     Nst_OBJ_HEAD;
@@ -17,6 +19,7 @@ NstEXP typedef struct _Nst_StrObj {
     usize char_len;
     u8 *value;
     u8 *indexable_str;
+    Nst_Obj *owner;
 } Nst_StrObj;
 
 #define STR(ptr) ((Nst_StrObj *)(ptr))
@@ -105,6 +108,7 @@ Nst_ObjRef *_Nst_str_new_no_err(const char *value)
     str->len = strlen(value);
     str->value = (u8 *)value;
     str->indexable_str = NULL;
+    str->owner = NULL;
 
     str->type = Nst_t.Str;
     Nst_inc_ref(Nst_t.Str);
@@ -137,6 +141,7 @@ Nst_ObjRef *Nst_str_new_len(u8 *val, usize len, usize char_len, bool allocated)
     str->value = val;
     str->char_len = char_len;
     str->indexable_str = NULL;
+    str->owner = NULL;
 
     return NstOBJ(str);
 }
@@ -169,6 +174,70 @@ Nst_ObjRef *Nst_str_copy(Nst_Obj *src)
     return str;
 }
 
+static usize skip_chars(Nst_StrObj *str, usize byte_idx, usize count)
+{
+    if (Nst_HAS_FLAG(str, Nst_FLAG_STR_IS_ASCII) || str->len == str->char_len)
+        return byte_idx + count;
+
+    for (usize i = 0; i < count; i++) {
+        byte_idx += Nst_check_ext_utf8_bytes(
+            str->value + byte_idx,
+            str->len - byte_idx);
+    }
+    return byte_idx;
+}
+
+Nst_ObjRef *Nst_str_slice(Nst_Obj *str, usize start, usize stop)
+{
+    Nst_assert(str->type == Nst_t.Str);
+    Nst_assert(start <= stop && stop <= STR(str)->char_len);
+
+    usize char_len = stop - start;
+    usize start_byte = skip_chars(STR(str), 0, start);
+    usize stop_byte = stop == STR(str)->char_len
+        ? STR(str)->len
+        : skip_chars(STR(str), start_byte, char_len);
+    usize len = stop_byte - start_byte;
+    bool is_ascii = Nst_HAS_FLAG(str, Nst_FLAG_STR_IS_ASCII)
+                 || len == char_len;
+
+    Nst_Obj *owner = STR(str)->owner != NULL ? STR(str)->owner : str;
+    Nst_StrObj *slice;
+
+    // a slice that reaches the end of the string is still terminated by the
+    // NUL character of its buffer which can then be shared, this is done only
+    // when the slice is at least half of the buffer so that a small string
+    // cannot keep a much larger one alive
+    if (len != 0 && stop_byte == STR(str)->len
+        && len >= STR(owner)->len - len)
+    {
+        slice = STR(Nst_str_new_len(
+            STR(str)->value + start_byte,
+            len, char_len,
+            false));
+        if (slice == NULL)
+            return NULL;
+        slice->owner = Nst_inc_ref(owner);
+    } else {
+        u8 *buf = Nst_malloc_c(len + 1, u8);
+        if (buf == NULL)
+            return NULL;
+        memcpy(buf, STR(str)->value + start_byte, len);
+        buf[len] = '\0';
+        slice = STR(Nst_str_new_len(buf, len, char_len, true));
+        if (slice == NULL) {
+            Nst_free(buf);
+            return NULL;
+        }
+    }
+
+    if (is_ascii) {
+        Nst_SET_FLAG(slice, Nst_FLAG_STR_IS_ASCII);
+        Nst_SET_FLAG(slice, Nst_FLAG_STR_CAN_INDEX);
+    }
+    return NstOBJ(slice);
+}
+
 Nst_ObjRef *Nst_str_repr(Nst_Obj *src)
 {
     Nst_assert(src->type == Nst_t.Str);
@@ -310,6 +379,8 @@ void _Nst_str_destroy(Nst_Obj *str)
         Nst_free(STR(str)->value);
     if (STR(str)->indexable_str != NULL)
         Nst_free(STR(str)->indexable_str);
+    if (STR(str)->owner != NULL)
+        Nst_dec_ref(STR(str)->owner);
 }
 
 Nst_ObjRef *Nst_str_parse_int(Nst_Obj *str, i32 base)
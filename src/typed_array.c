@@ -0,0 +1,258 @@
+#include <string.h>
+#include "nest.h"
+
+#define assert_typed_array(arr) Nst_assert(Nst_is_typed_array(arr))
+
+typedef struct _Nst_TypedArrayObj {
+    Nst_OBJ_HEAD;
+    void *values;
+    usize len;
+} Nst_TypedArrayObj;
+
+#define TARR(ptr) ((Nst_TypedArrayObj *)(ptr))
+
+static usize elem_size(Nst_Obj *type);
+static Nst_ObjRef *new_typed_array(usize len, Nst_Obj *type);
+static bool set_value(Nst_Obj *arr, usize idx, Nst_Obj *val);
+
+static usize elem_size(Nst_Obj *type)
+{
+    if (type == Nst_t.IntArray)
+        return sizeof(i64);
+    else if (type == Nst_t.RealArray)
+        return sizeof(f64);
+    return sizeof(u8);
+}
+
+static Nst_ObjRef *new_typed_array(usize len, Nst_Obj *type)
+{
+    Nst_TypedArrayObj *arr = Nst_obj_alloc(Nst_TypedArrayObj, type);
+    if (arr == NULL)
+        return NULL;
+
+    void *values = Nst_calloc(len, elem_size(type), NULL);
+    if (values == NULL) {
+        Nst_free(arr);
+        return NULL;
+    }
+
+    arr->values = values;
+    arr->len = len;
+    return NstOBJ(arr);
+}
+
+Nst_ObjRef *Nst_int_array_new(usize len)
+{
+    return new_typed_array(len, Nst_t.IntArray);
+}
+
+Nst_ObjRef *Nst_real_array_new(usize len)
+{
+    return new_typed_array(len, Nst_t.RealArray);
+}
+
+Nst_ObjRef *Nst_byte_array_new(usize len)
+{
+    return new_typed_array(len, Nst_t.ByteArray);
+}
+
+Nst_ObjRef *Nst_byte_array_from_buf(u8 *values, usize len)
+{
+    Nst_assert(values != NULL || len == 0);
+    Nst_TypedArrayObj *arr = Nst_obj_alloc(
+        Nst_TypedArrayObj,
+        Nst_t.ByteArray);
+    if (arr == NULL) {
+        if (values != NULL)
+            Nst_free(values);
+        return NULL;
+    }
+
+    arr->values = values;
+    arr->len = len;
+    return NstOBJ(arr);
+}
+
+Nst_ObjRef *Nst_typed_array_copy(Nst_Obj *arr)
+{
+    assert_typed_array(arr);
+    Nst_Obj *new_arr = new_typed_array(TARR(arr)->len, arr->type);
+    if (new_arr == NULL)
+        return NULL;
+    memcpy(
+        TARR(new_arr)->values,
+        TARR(arr)->values,
+        TARR(arr)->len * elem_size(arr->type));
+    return new_arr;
+}
+
+void _Nst_typed_array_destroy(Nst_Obj *arr)
+{
+    assert_typed_array(arr);
+    if (TARR(arr)->values != NULL)
+        Nst_free(TARR(arr)->values);
+}
+
+bool _Nst_typed_array_resize(Nst_Obj *arr, usize len)
+{
+    assert_typed_array(arr);
+    // the buffer is kept when the array becomes empty since reallocating it
+    // to zero bytes would free it
+    if (len == 0) {
+        TARR(arr)->len = 0;
+        return true;
+    }
+
+    usize size = elem_size(arr->type);
+    void *values = Nst_crealloc(
+        TARR(arr)->values,
+        len, size,
+        TARR(arr)->len,
+        NULL);
+    if (values == NULL)
+        return false;
+    TARR(arr)->values = values;
+    TARR(arr)->len = len;
+    return true;
+}
+
+bool Nst_is_typed_array(Nst_Obj *obj)
+{
+    return obj->type == Nst_t.IntArray
+        || obj->type == Nst_t.RealArray
+        || obj->type == Nst_t.ByteArray;
+}
+
+Nst_Obj *Nst_typed_array_elem_type(Nst_Obj *arr)
+{
+    assert_typed_array(arr);
+    if (arr->type == Nst_t.IntArray)
+        return Nst_t.Int;
+    else if (arr->type == Nst_t.RealArray)
+        return Nst_t.Real;
+    return Nst_t.Byte;
+}
+
+usize Nst_typed_array_len(Nst_Obj *arr)
+{
+    assert_typed_array(arr);
+    return TARR(arr)->len;
+}
+
+usize Nst_typed_array_elem_size(Nst_Obj *arr)
+{
+    assert_typed_array(arr);
+    return elem_size(arr->type);
+}
+
+void *Nst_typed_array_values(Nst_Obj *arr)
+{
+    assert_typed_array(arr);
+    return TARR(arr)->values;
+}
+
+i64 *Nst_int_array_values(Nst_Obj *arr)
+{
+    Nst_assert(arr->type == Nst_t.IntArray);
+    return (i64 *)TARR(arr)->values;
+}
+
+f64 *Nst_real_array_values(Nst_Obj *arr)
+{
+    Nst_assert(arr->type == Nst_t.RealArray);
+    return (f64 *)TARR(arr)->values;
+}
+
+u8 *Nst_byte_array_values(Nst_Obj *arr)
+{
+    Nst_assert(arr->type == Nst_t.ByteArray);
+    return (u8 *)TARR(arr)->values;
+}
+
+static bool set_value(Nst_Obj *arr, usize idx, Nst_Obj *val)
+{
+    Nst_Obj *val_t = val->type;
+
+    if (arr->type == Nst_t.RealArray) {
+        if (val_t == Nst_t.Real)
+            ((f64 *)TARR(arr)->values)[idx] = Nst_real_f64(val);
+        else if (val_t == Nst_t.Int)
+            ((f64 *)TARR(arr)->values)[idx] = (f64)Nst_int_i64(val);
+        else if (val_t == Nst_t.Byte)
+            ((f64 *)TARR(arr)->values)[idx] = (f64)Nst_byte_u8(val);
+        else
+            goto type_error;
+        return true;
+    }
+
+    if (val_t != Nst_t.Int && val_t != Nst_t.Byte)
+        goto type_error;
+
+    if (arr->type == Nst_t.IntArray)
+        ((i64 *)TARR(arr)->values)[idx] = Nst_number_to_i64(val);
+    else if (val_t == Nst_t.Byte)
+        ((u8 *)TARR(arr)->values)[idx] = Nst_byte_u8(val);
+    else {
+        i64 int_val = Nst_int_i64(val);
+        if (int_val < 0 || int_val > 255) {
+            Nst_error_setf_value(
+                "value %" PRIi64 " out of range for 'ByteArray', it must be "
+                "between 0 and 255",
+                int_val);
+            return false;
+        }
+        ((u8 *)TARR(arr)->values)[idx] = (u8)int_val;
+    }
+    return true;
+
+type_error:
+    Nst_error_setf_type(
+        "invalid value of type '%s' for '%s'",
+        Nst_type_name(val_t).value,
+        Nst_type_name(arr->type).value);
+    return false;
+}
+
+bool Nst_typed_array_set(Nst_Obj *arr, i64 idx, Nst_Obj *val)
+{
+    assert_typed_array(arr);
+    if (idx < 0)
+        idx += TARR(arr)->len;
+
+    if (idx < 0 || idx >= (i64)TARR(arr)->len) {
+        Nst_error_setf_value(
+            "index %" PRIi64 " out of bounds for '%s' of size %zi",
+            idx, Nst_type_name(arr->type).value, TARR(arr)->len);
+        return false;
+    }
+
+    return set_value(arr, (usize)idx, val);
+}
+
+Nst_ObjRef *Nst_typed_array_get(Nst_Obj *arr, i64 idx)
+{
+    assert_typed_array(arr);
+    if (idx < 0)
+        idx += TARR(arr)->len;
+
+    if (idx < 0 || idx >= (i64)TARR(arr)->len) {
+        Nst_error_setf_value(
+            "index %" PRIi64 " out of bounds for '%s' of size %zi",
+            idx, Nst_type_name(arr->type).value, TARR(arr)->len);
+        return NULL;
+    }
+
+    return Nst_typed_array_getf(arr, (usize)idx);
+}
+
+Nst_ObjRef *Nst_typed_array_getf(Nst_Obj *arr, usize idx)
+{
+    assert_typed_array(arr);
+    Nst_assert(idx < TARR(arr)->len);
+
+    if (arr->type == Nst_t.IntArray)
+        return Nst_int_new(((i64 *)TARR(arr)->values)[idx]);
+    else if (arr->type == Nst_t.RealArray)
+        return Nst_real_new(((f64 *)TARR(arr)->values)[idx]);
+    return Nst_byte_new(((u8 *)TARR(arr)->values)[idx]);
+}
@@ -51,6 +51,9 @@ bool Nst_vt_init(Nst_VarTable *vt, Nst_Obj *global_table, Nst_Obj *args,
     Nst_map_set(vars, Nst_s.t_Iter,   Nst_t.Iter);
     Nst_map_set(vars, Nst_s.t_Byte,   Nst_t.Byte);
     Nst_map_set(vars, Nst_s.t_IOFile, Nst_t.IOFile);
+    Nst_map_set(vars, Nst_s.t_IntArray, Nst_t.IntArray);
+    Nst_map_set(vars, Nst_s.t_RealArray, Nst_t.RealArray);
+    Nst_map_set(vars, Nst_s.t_ByteArray, Nst_t.ByteArray);
 
     Nst_map_set(vars, Nst_s.c_true,  Nst_c.Bool_true);
     Nst_map_set(vars, Nst_s.c_false, Nst_c.Bool_false);
@@ -85,14 +88,16 @@ bool Nst_vt_set(Nst_VarTable vt, Nst_Obj *name, Nst_Obj *val)
 
 void Nst_vt_destroy(Nst_VarTable *vt)
 {
-    if (vt->vars != NULL) {
+    // the map may have already been destroyed by the garbage collector when
+    // the owner of the table is part of the same cycle
+    if (vt->vars != NULL && !Nst_HAS_FLAG(vt->vars, Nst_FLAG_OBJ_DESTROYED)) {
         Nst_Obj *vars = Nst_map_get(vt->vars, Nst_s.o__vars_);
         if (vars == vt->vars) {
             Nst_map_drop(vt->vars, Nst_s.o__vars_);
             Nst_ndec_ref(vars);
         }
-        Nst_dec_ref(vt->vars);
     }
+    Nst_ndec_ref(vt->vars);
     Nst_ndec_ref(vt->global_table);
     vt->vars = NULL;
     vt->global_table = NULL;
@@ -98,9 +98,25 @@ int main() {
 
     test_run(test_func_set_vt);
 
+    // ggc.h
+
+    test_run(test_ggc_collect);
+    test_run(test_ggc_collect_old_gen);
+    test_run(test_ggc_remove_objs);
+
     // hash.h
 
     test_run(test_obj_hash);
+    test_run(test_str_hash_quality);
+    test_run(test_str_hash_throughput);
+
+    // interpreter.h
+
+    test_run(test_run_profile);
+    test_run(test_run_profile_long_inst);
+    test_run(test_func_call_c);
+    test_run(test_func_call_c_nested);
+    test_run(test_run_large_function);
 
     // iter.h
 
@@ -158,6 +174,11 @@ int main() {
     test_run(test_crealloc);
     test_run(test_memset);
 
+    // runtime_stack.h
+
+    test_run(test_vstack_shrink);
+    test_run(test_fstack_push);
+
     // sequence.h
 
     test_run(test_seq_new);
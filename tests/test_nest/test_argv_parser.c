@@ -214,6 +214,63 @@ TestResult test_cl_args_parse(void)
     test_assert(Nst_cl_args_parse(&args) == 0);
     test_assert(args.no_default);
 
+    Nst_cl_args_init(&args, ARGS("--no-tail-calls", "file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(args.no_tail_calls);
+
+    Nst_cl_args_init(&args, ARGS("--op-pairs", "file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(args.print_op_pairs);
+
+    Nst_cl_args_init(&args, ARGS("--profile", "file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(str_eq((u8 *)args.profile_path, "profile.folded"));
+
+    Nst_cl_args_init(&args, ARGS("--profile=out.txt", "file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(str_eq((u8 *)args.profile_path, "out.txt"));
+
+    Nst_cl_args_init(&args, ARGS("file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(args.profile_path == NULL);
+
+    Nst_cl_args_init(&args, ARGS("--profile=", "file.nest"));
+    if (test_capture_begin()) {
+        i32 result = Nst_cl_args_parse(&args);
+        const char *msg = test_capture_end(NULL);
+        test_assert(str_starts_with(msg, "Invalid usage of the option: --profile"));
+        test_assert(result == -1);
+    }
+
+    Nst_cl_args_init(&args, ARGS("--gc-stats", "file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(args.print_gc_stats);
+    test_assert(args.gc_step == _Nst_OLD_GEN_STEP);
+
+    Nst_cl_args_init(&args, ARGS("--gc-step=250", "file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(args.gc_step == 250);
+
+    Nst_cl_args_init(&args, ARGS("--gc-step=0", "file.nest"));
+    test_assert(Nst_cl_args_parse(&args) == 0);
+    test_assert(args.gc_step == 0);
+
+    Nst_cl_args_init(&args, ARGS("--gc-step=", "file.nest"));
+    if (test_capture_begin()) {
+        i32 result = Nst_cl_args_parse(&args);
+        const char *msg = test_capture_end(NULL);
+        test_assert(str_starts_with(msg, "Invalid usage of the option: --gc-step"));
+        test_assert(result == -1);
+    }
+
+    Nst_cl_args_init(&args, ARGS("--gc-step=-1", "file.nest"));
+    if (test_capture_begin()) {
+        i32 result = Nst_cl_args_parse(&args);
+        const char *msg = test_capture_end(NULL);
+        test_assert(str_starts_with(msg, "Invalid usage of the option: --gc-step"));
+        test_assert(result == -1);
+    }
+
     Nst_cl_args_init(&args, ARGS("--no-default"));
     if (test_capture_begin()) {
         i32 result = Nst_cl_args_parse(&args);
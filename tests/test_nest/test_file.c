@@ -1,3 +1,5 @@
+#include <stdio.h>
+#include <string.h>
 #include "tests.h"
 
 TestResult test_FILE_read(void)
@@ -5,9 +7,108 @@ TestResult test_FILE_read(void)
     return TEST_NOT_IMPL;
 }
 
+// Writes `str` to a new temporary file and reads back its contents into
+// `out`, returning the number of bytes read or -1 on failure
+static isize write_and_read(const char *str, usize len, Nst_EncodingID enc,
+                            Nst_IOResult *result, usize *count, u8 *out,
+                            usize out_size)
+{
+    FILE *fp = tmpfile();
+    if (fp == NULL)
+        return -1;
+    Nst_Obj *f = Nst_iof_new(fp, false, false, true, Nst_encoding(enc));
+    if (f == NULL) {
+        fclose(fp);
+        return -1;
+    }
+    *result = Nst_fwrite((u8 *)str, len, count, f);
+    // a second write must not add the BOM again
+    if (*result == Nst_IO_SUCCESS)
+        *result = Nst_fwrite((u8 *)"", 0, NULL, f);
+    fflush(fp);
+    rewind(fp);
+    usize read_bytes = fread(out, 1, out_size, fp);
+    Nst_dec_ref(f);
+    return (isize)read_bytes;
+}
+
 TestResult test_FILE_write(void)
 {
-    return TEST_NOT_IMPL;
+    TEST_ENTER;
+    Nst_IOResult result;
+    usize count;
+    u8 out[16384];
+
+    // UTF-8 is written unchanged and without a BOM
+    const char *utf8 = "abc\xc3\xa8\xe2\x82\xac\xf0\x9f\x98\x80";
+    isize len = write_and_read(
+        utf8, strlen(utf8), Nst_EID_UTF8,
+        &result, &count,
+        out, sizeof(out));
+    test_assert(result == Nst_IO_SUCCESS);
+    test_assert(count == 6);
+    test_assert(len == (isize)strlen(utf8));
+    test_assert(memcmp(out, utf8, strlen(utf8)) == 0);
+
+    // surrogates are written only up to the invalid character
+    const char *surrogate = "ab\xed\xa0\x80" "c";
+    len = write_and_read(
+        surrogate, strlen(surrogate), Nst_EID_UTF8,
+        &result, &count,
+        out, sizeof(out));
+    test_assert(result == Nst_IO_INVALID_ENCODING);
+    test_assert(count == 2);
+    test_assert(len == 2 && memcmp(out, "ab", 2) == 0);
+
+    len = write_and_read(
+        surrogate, strlen(surrogate), Nst_EID_EXT_UTF8,
+        &result, &count,
+        out, sizeof(out));
+    test_assert(result == Nst_IO_SUCCESS);
+    test_assert(count == 4);
+    test_assert(len == (isize)strlen(surrogate));
+
+    // other encodings get the BOM once at the start of the file
+    len = write_and_read(
+        "a\xc3\xa8", 3, Nst_EID_UTF16LE,
+        &result, &count,
+        out, sizeof(out));
+    test_assert(result == Nst_IO_SUCCESS);
+    test_assert(count == 2);
+    test_assert(len == 6 && memcmp(out, "\xff\xfe" "a\0\xe8\0", 6) == 0);
+
+    // text longer than the internal buffer
+    char *latin1 = Nst_malloc_c(10000, char);
+    test_assert_or_exit(latin1 != NULL, {});
+    for (usize i = 0; i < 5000; i++) {
+        latin1[i * 2] = '\xc3';
+        latin1[i * 2 + 1] = '\xa8';
+    }
+    len = write_and_read(
+        latin1, 10000, Nst_EID_LATIN1,
+        &result, &count,
+        out, sizeof(out));
+    Nst_free(latin1);
+    test_assert(result == Nst_IO_SUCCESS);
+    test_assert(count == 5000);
+    test_assert(len == 5000);
+    for (usize i = 0; i < 5000 && len == 5000; i++) {
+        if (out[i] != 0xe8) {
+            test_assert(false);
+            break;
+        }
+    }
+
+    // characters that cannot be encoded stop the write
+    len = write_and_read(
+        "abcd\xc3\xa8", 6, Nst_EID_ASCII,
+        &result, &count,
+        out, sizeof(out));
+    test_assert(result == Nst_IO_INVALID_ENCODING);
+    test_assert(count == 4);
+    test_assert(len == 4 && memcmp(out, "abcd", 4) == 0);
+
+    TEST_EXIT;
 }
 
 TestResult test_FILE_flush(void)
@@ -0,0 +1,247 @@
+#include "tests.h"
+
+typedef struct _CycleObj {
+    Nst_OBJ_HEAD;
+    Nst_GGC_HEAD;
+    Nst_Obj *other;
+    bool watched;
+} CycleObj;
+
+static usize destroyed_count = 0;
+static usize watched_destroyed = 0;
+static usize watched_traversed = 0;
+
+static void cycle_destroy(Nst_Obj *obj)
+{
+    CycleObj *cycle = (CycleObj *)obj;
+    if (cycle->other != NULL)
+        Nst_dec_ref(cycle->other);
+    destroyed_count++;
+    if (cycle->watched)
+        watched_destroyed++;
+}
+
+static void cycle_traverse(Nst_Obj *obj)
+{
+    CycleObj *cycle = (CycleObj *)obj;
+    if (cycle->other != NULL)
+        Nst_ggc_obj_reachable(cycle->other);
+    if (cycle->watched)
+        watched_traversed++;
+}
+
+static Nst_Obj *cycle_type = NULL;
+
+static CycleObj *cycle_new(void)
+{
+    if (cycle_type == NULL) {
+        cycle_type = Nst_cont_type_new("Cycle", cycle_destroy, cycle_traverse);
+        if (cycle_type == NULL)
+            return NULL;
+    }
+    CycleObj *cycle = Nst_obj_alloc(CycleObj, cycle_type);
+    if (cycle == NULL)
+        return NULL;
+    cycle->other = NULL;
+    cycle->watched = false;
+    Nst_GGC_OBJ_INIT(cycle);
+    return cycle;
+}
+
+// Creates `count` pairs of objects that reference each other, only the
+// references of the cycles are left
+static bool make_cycles(usize count)
+{
+    for (usize i = 0; i < count; i++) {
+        CycleObj *a = cycle_new();
+        CycleObj *b = cycle_new();
+        if (a == NULL || b == NULL) {
+            if (a != NULL)
+                Nst_dec_ref(NstOBJ(a));
+            return false;
+        }
+        a->other = NstOBJ(b);
+        b->other = Nst_inc_ref(NstOBJ(a));
+        Nst_dec_ref(NstOBJ(a));
+    }
+    return true;
+}
+
+TestResult test_ggc_collect(void)
+{
+    TEST_ENTER;
+
+    CycleObj *kept = cycle_new();
+    test_assert_or_exit(kept != NULL, Nst_error_clear());
+    kept->other = Nst_inc_ref(NstOBJ(kept));
+
+    destroyed_count = 0;
+    test_assert_or_exit(make_cycles(_Nst_GEN1_MAX), Nst_error_clear());
+    test_assert(destroyed_count == 0);
+
+    Nst_ggc_collect();
+    test_assert(destroyed_count == _Nst_GEN1_MAX * 2);
+
+    // the cycle referenced from outside is kept alive
+    test_assert(kept->ref_count == 2);
+    test_assert(kept->other == NstOBJ(kept));
+    Nst_dec_ref(NstOBJ(kept));
+
+    TEST_EXIT;
+}
+
+TestResult test_ggc_remove_objs(void)
+{
+    TEST_ENTER;
+
+    // objects freed by their reference count leave the generation in an
+    // order that differs from the one in which they were added
+    CycleObj *objs[64] = { NULL };
+    for (usize i = 0; i < 64; i++) {
+        objs[i] = cycle_new();
+        test_assert_or_exit(objs[i] != NULL, {
+            for (usize j = 0; j < i; j++)
+                Nst_dec_ref(NstOBJ(objs[j]));
+            Nst_error_clear();
+        });
+        objs[i]->watched = true;
+    }
+    // the objects left are linked together in a chain
+    for (usize i = 0; i + 3 < 64; i += 3)
+        objs[i]->other = Nst_inc_ref(NstOBJ(objs[i + 3]));
+
+    watched_destroyed = 0;
+    for (usize i = 0; i < 64; i++) {
+        usize idx = (i * 37) % 64;
+        if (idx % 3 == 0)
+            continue;
+        Nst_dec_ref(NstOBJ(objs[idx]));
+        objs[idx] = NULL;
+    }
+    test_assert(watched_destroyed == 42);
+
+    destroyed_count = 0;
+    test_assert_or_exit(make_cycles(_Nst_GEN1_MAX), {
+        for (usize i = 0; i < 64; i += 3)
+            Nst_dec_ref(NstOBJ(objs[i]));
+        Nst_error_clear();
+    });
+    Nst_ggc_collect();
+    test_assert(destroyed_count == _Nst_GEN1_MAX * 2);
+    test_assert(watched_destroyed == 42);
+
+    for (usize i = 0; i < 64; i += 3) {
+        test_assert(objs[i]->ref_count == (i == 0 ? 1 : 2));
+        if (i + 3 < 64)
+            test_assert(objs[i]->other == NstOBJ(objs[i + 3]));
+    }
+
+    // the chain is freed starting from its head
+    Nst_dec_ref(NstOBJ(objs[0]));
+    for (usize i = 3; i < 64; i += 3)
+        Nst_dec_ref(NstOBJ(objs[i]));
+    test_assert(watched_destroyed == 64);
+
+    TEST_EXIT;
+}
+
+#define OLD_GEN_CYCLES 300
+#define OLD_GEN_ROUNDS 500
+#define OLD_GEN_LIVE 20
+
+static CycleObj *kept[OLD_GEN_CYCLES];
+static CycleObj **live = NULL;
+static usize live_len = 0;
+
+static void release_old_gen_objs(void)
+{
+    Nst_ggc_set_step(_Nst_OLD_GEN_STEP);
+    for (usize i = 0; i < OLD_GEN_CYCLES; i++) {
+        if (kept[i] != NULL)
+            Nst_dec_ref(NstOBJ(kept[i]));
+        kept[i] = NULL;
+    }
+    for (usize i = 0; i < live_len; i++)
+        Nst_dec_ref(NstOBJ(live[i]));
+    Nst_free(live);
+    live = NULL;
+    live_len = 0;
+    Nst_error_clear();
+}
+
+// Creates a pair of objects that reference each other and are watched, the
+// first one is returned with a reference from outside the cycle
+static CycleObj *watched_cycle_new(void)
+{
+    CycleObj *a = cycle_new();
+    CycleObj *b = cycle_new();
+    if (a == NULL || b == NULL) {
+        if (a != NULL)
+            Nst_dec_ref(NstOBJ(a));
+        return NULL;
+    }
+    a->watched = true;
+    b->watched = true;
+    a->other = NstOBJ(b);
+    b->other = Nst_inc_ref(NstOBJ(a));
+    return a;
+}
+
+TestResult test_ggc_collect_old_gen(void)
+{
+    TEST_ENTER;
+
+    live = Nst_malloc_c(OLD_GEN_ROUNDS * OLD_GEN_LIVE, CycleObj *);
+    test_assert_or_exit(live != NULL, Nst_error_clear());
+
+    Nst_ggc_set_step(50);
+    watched_destroyed = 0;
+
+    // the cycles are kept referenced until they reach the old generation
+    for (usize i = 0; i < OLD_GEN_CYCLES; i++) {
+        kept[i] = watched_cycle_new();
+        test_assert_or_exit(kept[i] != NULL, release_old_gen_objs());
+    }
+    for (usize i = 0; i < 4; i++) {
+        test_assert_or_exit(
+            make_cycles(_Nst_GEN1_MAX),
+            release_old_gen_objs());
+        Nst_ggc_collect();
+    }
+    test_assert(watched_destroyed == 0);
+
+    for (usize i = 0; i < OLD_GEN_CYCLES; i++) {
+        Nst_dec_ref(NstOBJ(kept[i]));
+        kept[i] = NULL;
+    }
+    test_assert(watched_destroyed == 0);
+
+    // objects that stay alive keep being promoted to the old generation so
+    // that it is collected again, the collections that traverse only some of
+    // the cycles show that it is done in steps
+    usize rounds = 0;
+    usize partial_rounds = 0;
+    while (watched_destroyed < OLD_GEN_CYCLES * 2 && rounds < OLD_GEN_ROUNDS) {
+        for (usize i = 0; i < OLD_GEN_LIVE; i++) {
+            live[live_len] = cycle_new();
+            test_assert_or_exit(
+                live[live_len] != NULL,
+                release_old_gen_objs());
+            live_len++;
+        }
+        test_assert_or_exit(
+            make_cycles(_Nst_GEN1_MAX),
+            release_old_gen_objs());
+        watched_traversed = 0;
+        Nst_ggc_collect();
+        rounds++;
+        if (watched_traversed > 0 && watched_traversed < OLD_GEN_CYCLES * 2)
+            partial_rounds++;
+    }
+    test_assert(watched_destroyed == OLD_GEN_CYCLES * 2);
+    test_assert(partial_rounds > 1);
+
+    release_old_gen_objs();
+
+    TEST_EXIT;
+}
@@ -1,6 +1,124 @@
+#include <stdio.h>
+#include <time.h>
 #include "tests.h"
 
+#define QUALITY_KEYS 100000
+#define QUALITY_BUCKETS 65536
+#define THROUGHPUT_BYTES (64 * 1024 * 1024)
+
+static i32 hash_c_str(const char *s)
+{
+    Nst_Obj *str = Nst_str_new_c(s);
+    if (str == NULL)
+        return -1;
+    i32 hash = Nst_obj_hash(str);
+    Nst_dec_ref(str);
+    return hash;
+}
+
 TestResult test_obj_hash(void)
 {
-    return TEST_NOT_IMPL;
+    TEST_ENTER;
+
+    // equal strings have the same hash regardless of their length
+    const char *strs[] = {
+        "", "a", "ab", "abc", "abcd", "abcdefgh", "abcdefghijklmnop",
+        "abcdefghijklmnopq",
+        "a string longer than forty-eight bytes that uses the main loop"
+    };
+    for (usize i = 0; i < sizeof(strs) / sizeof(strs[0]); i++) {
+        i32 hash = hash_c_str(strs[i]);
+        test_assert(hash != -1);
+        test_assert(hash == hash_c_str(strs[i]));
+        for (usize j = 0; j < i; j++)
+            test_assert(hash != hash_c_str(strs[j]));
+    }
+
+    // the hash is cached in the object
+    Nst_Obj *str = Nst_str_new_c("cached");
+    test_assert_or_exit(str != NULL, {});
+    test_assert(str->hash == -1);
+    i32 hash = Nst_obj_hash(str);
+    test_assert(str->hash == hash);
+    Nst_dec_ref(str);
+
+    Nst_Obj *num = Nst_int_new(10);
+    test_assert(Nst_obj_hash(num) == 10);
+    Nst_dec_ref(num);
+    num = Nst_int_new(-1);
+    test_assert(Nst_obj_hash(num) == -2);
+    Nst_dec_ref(num);
+
+    Nst_Obj *vec = Nst_vector_new(0);
+    test_assert(Nst_obj_hash(vec) == -1);
+    Nst_dec_ref(vec);
+
+    TEST_EXIT;
+}
+
+TestResult test_str_hash_quality(void)
+{
+    TEST_ENTER;
+    u32 *buckets = Nst_calloc_c(QUALITY_BUCKETS, u32, NULL);
+    test_assert_or_exit(buckets != NULL, {});
+
+    // keys that differ in a few characters, like the ones of real programs
+    char key[32];
+    for (i32 i = 0; i < QUALITY_KEYS; i++) {
+        sprintf(key, "key_%" PRIi32, i);
+        i32 hash = hash_c_str(key);
+        buckets[(u32)hash % QUALITY_BUCKETS]++;
+    }
+
+    // with a uniform hash the expected load is about 1.5 keys per bucket and
+    // the largest bucket should not hold more than a dozen keys
+    u32 max_load = 0;
+    u32 empty = 0;
+    for (i32 i = 0; i < QUALITY_BUCKETS; i++) {
+        if (buckets[i] > max_load)
+            max_load = buckets[i];
+        if (buckets[i] == 0)
+            empty++;
+    }
+    test_assert(max_load <= 12);
+    // a uniform distribution leaves e^-1.53 (about 21.6%) of buckets empty
+    test_assert(empty > QUALITY_BUCKETS / 5 && empty < QUALITY_BUCKETS / 4);
+
+    Nst_free(buckets);
+    TEST_EXIT;
+}
+
+TestResult test_str_hash_throughput(void)
+{
+    TEST_ENTER;
+    usize sizes[] = { 8, 64, 4096 };
+
+    for (usize i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        u8 *buf = Nst_malloc_c(sizes[i] + 1, u8);
+        test_assert_or_exit(buf != NULL, {});
+        for (usize j = 0; j < sizes[i]; j++)
+            buf[j] = (u8)('a' + j % 26);
+        buf[sizes[i]] = 0;
+
+        Nst_Obj *str = Nst_str_new_allocated(buf, sizes[i]);
+        test_assert_or_exit(str != NULL, Nst_free(buf));
+
+        usize iterations = THROUGHPUT_BYTES / sizes[i];
+        clock_t start = clock();
+        for (usize j = 0; j < iterations; j++) {
+            str->hash = -1;
+            Nst_obj_hash(str);
+        }
+        f64 seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+        Nst_dec_ref(str);
+
+        if (seconds > 0) {
+            Nst_printf(
+                " %zuB: %.0f MiB/s;",
+                sizes[i],
+                THROUGHPUT_BYTES / seconds / (1024 * 1024));
+        }
+    }
+
+    TEST_EXIT;
 }
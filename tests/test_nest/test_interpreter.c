@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tests.h"
+
+#define PROFILE_PATH "test_profile.folded"
+// the space and the semicolon cannot appear in a frame of the folded format
+#define PROFILE_PROG_PATH "test profile;prog.nest"
+#define PROFILE_PROG_FRAME "test_profile_prog.nest:1 "
+
+// Checks that a line is in the form `file:line;file:line;... count`, where a
+// frame can also be `?`
+static bool is_folded_line(const char *line)
+{
+    const char *count = strrchr(line, ' ');
+    if (count == NULL || count[1] == '\0')
+        return false;
+    for (const char *ch = count + 1; *ch != '\0'; ch++) {
+        if (*ch < '0' || *ch > '9')
+            return false;
+    }
+
+    const char *frame = line;
+    while (frame < count) {
+        const char *end = strchr(frame, ';');
+        if (end == NULL || end > count)
+            end = count;
+        // instructions without a position are written as a question mark
+        if (end - frame == 1 && *frame == '?') {
+            frame = end + 1;
+            continue;
+        }
+        // the path can contain colons, the line number follows the last one
+        const char *colon = end - 1;
+        while (colon > frame && *colon != ':')
+            colon--;
+        if (*colon != ':' || colon + 1 >= end)
+            return false;
+        for (const char *ch = colon + 1; ch < end; ch++) {
+            if (*ch < '0' || *ch > '9')
+                return false;
+        }
+        frame = end + 1;
+    }
+    return true;
+}
+
+// Runs a program with the arguments in `argv` checking that it succeeds and
+// prints the lines sampled by the profiler
+static bool run_profiled(int argc, char **argv)
+{
+    Nst_CLArgs args;
+    Nst_cl_args_init(&args, argc, argv);
+    if (Nst_cl_args_parse(&args) != 0)
+        return false;
+
+    Nst_Program prog;
+    if (Nst_prog_init(&prog, args) != Nst_EK_RUN) {
+        Nst_error_clear();
+        return false;
+    }
+
+    bool success = false;
+    if (test_capture_begin()) {
+        i32 result = Nst_run(&prog);
+        const char *msg = test_capture_end(NULL);
+        success = result == 0 && strstr(msg, "Most sampled lines") != NULL;
+    }
+    Nst_prog_destroy(&prog);
+    return success;
+}
+
+TestResult test_run_profile(void)
+{
+    TEST_ENTER;
+
+    char *argv[] = {
+        "nest",
+        "--profile=" PROFILE_PATH,
+        "-c",
+        "#count n [\n"
+        "    0 = s\n"
+        "    ... n [ s 1 + = s ]\n"
+        "    => s\n"
+        "]\n"
+        "1000000 @count"
+    };
+    test_assert_or_exit(
+        run_profiled(sizeof(argv) / sizeof(argv[0]), argv),
+        remove(PROFILE_PATH));
+
+    FILE *file = fopen(PROFILE_PATH, "r");
+    test_assert_or_exit(file != NULL, );
+
+    char line[256];
+    usize line_count = 0;
+    bool inner_frame = false;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        test_assert(is_folded_line(line));
+        // the loop in `count` is called from the last line of the program
+        if (strstr(line, "<string>:6;<string>:3 ") == line)
+            inner_frame = true;
+        line_count++;
+    }
+    fclose(file);
+    remove(PROFILE_PATH);
+
+    test_assert(line_count > 0);
+    test_assert(inner_frame);
+
+    TEST_EXIT;
+}
+
+TestResult test_run_profile_long_inst(void)
+{
+    TEST_ENTER;
+
+    // a single instruction that runs for many ticks of the profiler
+    FILE *prog_file = fopen(PROFILE_PROG_PATH, "w");
+    test_assert_or_exit(prog_file != NULL, );
+    fputs("Array :: (0 -> 3000000) = a\n", prog_file);
+    fclose(prog_file);
+
+    char *argv[] = { "nest", "--profile=" PROFILE_PATH, PROFILE_PROG_PATH };
+    bool result = run_profiled(sizeof(argv) / sizeof(argv[0]), argv);
+    remove(PROFILE_PROG_PATH);
+    test_assert_or_exit(result, remove(PROFILE_PATH));
+
+    FILE *file = fopen(PROFILE_PATH, "r");
+    test_assert_or_exit(file != NULL, );
+
+    char line[4096];
+    u64 samples = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        test_assert(is_folded_line(line));
+        char *frame = strstr(line, PROFILE_PROG_FRAME);
+        if (frame != NULL)
+            samples += strtoull(frame + strlen(PROFILE_PROG_FRAME), NULL, 10);
+    }
+    fclose(file);
+    remove(PROFILE_PATH);
+
+    // every tick that elapsed during the instruction is counted, not only
+    // the last one
+    test_assert(samples > 1);
+
+    TEST_EXIT;
+}
+
+#define C_ARG_NUM 12
+
+// Returns the sum of the arguments, that must be `Int` objects or `null`
+static Nst_Obj *sum_args(usize arg_num, Nst_Obj **args)
+{
+    if (arg_num != C_ARG_NUM) {
+        Nst_error_setc_call("wrong number of arguments");
+        return NULL;
+    }
+
+    i64 sum = 0;
+    for (usize i = 0; i < arg_num; i++) {
+        if (args[i] == Nst_null())
+            continue;
+        if (args[i]->type != Nst_t.Int) {
+            Nst_error_setc_type("expected an Int or null");
+            return NULL;
+        }
+        sum += Nst_int_i64(args[i]);
+    }
+    return Nst_int_new(sum);
+}
+
+static Nst_Obj *sum_func = NULL;
+static Nst_Obj *nested_func = NULL;
+
+// Takes a depth and two numbers, calls itself with a depth lower by one and
+// then checks that its own arguments have not changed
+static Nst_Obj *call_nested(usize arg_num, Nst_Obj **args)
+{
+    i64 depth = Nst_int_i64(args[0]);
+    Nst_Obj *a = args[1];
+    Nst_Obj *b = args[2];
+    if (depth == 0)
+        return Nst_func_call(sum_func, 3, args);
+
+    Nst_Obj *inner_depth = Nst_int_new(depth - 1);
+    if (inner_depth == NULL)
+        return NULL;
+    Nst_Obj *inner_args[3] = { inner_depth, a, b };
+    Nst_Obj *result = Nst_func_call(nested_func, 3, inner_args);
+    Nst_dec_ref(inner_depth);
+    if (result == NULL)
+        return NULL;
+
+    bool args_kept = Nst_int_i64(args[0]) == depth
+        && args[1] == a
+        && args[2] == b;
+    for (usize i = 3; i < arg_num; i++) {
+        if (args[i] != Nst_null())
+            args_kept = false;
+    }
+    if (!args_kept) {
+        Nst_dec_ref(result);
+        Nst_error_setc_value("the arguments have changed");
+        return NULL;
+    }
+    return result;
+}
+
+TestResult test_func_call_c(void)
+{
+    TEST_ENTER;
+
+    sum_func = Nst_func_new_c(C_ARG_NUM, sum_args);
+    test_assert_or_exit(sum_func != NULL, Nst_error_clear());
+
+    Nst_Obj *args[C_ARG_NUM];
+    for (usize i = 0; i < C_ARG_NUM; i++)
+        args[i] = Nst_int_new((i64)i + 1);
+
+    usize vstack_len = Nst_state()->v_stack.len;
+
+    // all the arguments are given
+    Nst_Obj *result = Nst_func_call(sum_func, C_ARG_NUM, args);
+    test_with(result != NULL) {
+        test_assert(Nst_int_i64(result) == 78);
+        Nst_dec_ref(result);
+    }
+    test_assert(Nst_state()->v_stack.len == vstack_len);
+
+    // the missing arguments are `null`
+    result = Nst_func_call(sum_func, 3, args);
+    test_with(result != NULL) {
+        test_assert(Nst_int_i64(result) == 6);
+        Nst_dec_ref(result);
+    }
+    test_assert(Nst_state()->v_stack.len == vstack_len);
+
+    result = Nst_func_call(sum_func, 0, NULL);
+    test_with(result != NULL) {
+        test_assert(Nst_int_i64(result) == 0);
+        Nst_dec_ref(result);
+    }
+    test_assert(Nst_state()->v_stack.len == vstack_len);
+
+    // too many arguments
+    Nst_Obj *extra_args[C_ARG_NUM + 1];
+    for (usize i = 0; i < C_ARG_NUM; i++)
+        extra_args[i] = args[i];
+    extra_args[C_ARG_NUM] = args[0];
+    // a successful assertion clears the error
+    test_assert(Nst_func_call(sum_func, C_ARG_NUM + 1, extra_args) == NULL && Nst_error_occurred());
+    test_assert(Nst_state()->v_stack.len == vstack_len);
+
+    // an error in the function removes its arguments as well
+    Nst_Obj *bad_args[2] = { args[0], Nst_true() };
+    test_assert(Nst_func_call(sum_func, 2, bad_args) == NULL && Nst_error_occurred());
+    test_assert(Nst_state()->v_stack.len == vstack_len);
+
+    for (usize i = 0; i < C_ARG_NUM; i++)
+        Nst_dec_ref(args[i]);
+    Nst_dec_ref(sum_func);
+    sum_func = NULL;
+
+    TEST_EXIT;
+}
+
+TestResult test_func_call_c_nested(void)
+{
+    TEST_ENTER;
+
+    sum_func = Nst_func_new_c(C_ARG_NUM, sum_args);
+    test_assert_or_exit(sum_func != NULL, Nst_error_clear());
+    nested_func = Nst_func_new_c(C_ARG_NUM, call_nested);
+    test_assert_or_exit(nested_func != NULL, {
+        Nst_dec_ref(sum_func);
+        Nst_error_clear();
+    });
+
+    usize vstack_len = Nst_state()->v_stack.len;
+
+    // every call puts its arguments on the stack, making it grow while the
+    // arguments of the outer calls are still in use
+    Nst_Obj *args[3] = { Nst_int_new(1000), Nst_int_new(2), Nst_int_new(3) };
+    Nst_Obj *result = Nst_func_call(nested_func, 3, args);
+    test_with(result != NULL) {
+        test_assert(Nst_int_i64(result) == 5);
+        Nst_dec_ref(result);
+    } else
+        Nst_error_clear();
+    test_assert(Nst_state()->v_stack.len == vstack_len);
+
+    for (usize i = 0; i < 3; i++)
+        Nst_dec_ref(args[i]);
+    Nst_dec_ref(nested_func);
+    Nst_dec_ref(sum_func);
+    nested_func = NULL;
+    sum_func = NULL;
+
+    TEST_EXIT;
+}
+
+#define LARGE_FUNC_CONSTS 70000
+#define LARGE_FUNC_LOCALS 300
+
+// Runs the code in `code` with `-c` and returns whether it succeeded
+static bool run_code(char *code)
+{
+    char *argv[] = { "nest", "-c", code };
+    Nst_CLArgs args;
+    Nst_cl_args_init(&args, sizeof(argv) / sizeof(argv[0]), argv);
+    if (Nst_cl_args_parse(&args) != 0)
+        return false;
+
+    Nst_Program prog;
+    if (Nst_prog_init(&prog, args) != Nst_EK_RUN) {
+        Nst_error_clear();
+        return false;
+    }
+
+    bool success = false;
+    if (test_capture_begin()) {
+        success = Nst_run(&prog) == 0;
+        test_capture_end(NULL);
+    }
+    Nst_prog_destroy(&prog);
+    return success;
+}
+
+TestResult test_run_large_function(void)
+{
+    TEST_ENTER;
+
+    // a function with more constants and locals than fit in 16 bits and in
+    // 8 bits respectively, the jumps around its body have large targets too
+    Nst_StrBuilder sb;
+    test_assert_or_exit(
+        Nst_sb_init(&sb, LARGE_FUNC_CONSTS * 8),
+        Nst_error_clear());
+
+    char line[64];
+    bool ok = Nst_sb_push_c(
+        &sb,
+        "#f run_body [\n"
+        "    0 = s\n"
+        "    run_body ? [\n"
+        "        {1");
+    for (usize i = 2; ok && i <= LARGE_FUNC_CONSTS; i++) {
+        sprintf(line, ", %zu", i);
+        ok = Nst_sb_push_c(&sb, line);
+    }
+    ok = ok && Nst_sb_push_c(&sb, "} = arr\n");
+    for (usize i = 1; ok && i <= LARGE_FUNC_LOCALS; i++) {
+        sprintf(line, "        %zu = v%zu\n", i, i);
+        ok = Nst_sb_push_c(&sb, line);
+    }
+    sprintf(
+        line,
+        "        arr.0 arr.-1 v1 v%i + + + = s\n",
+        LARGE_FUNC_LOCALS);
+    ok = ok && Nst_sb_push_c(&sb, line);
+    ok = ok && Nst_sb_push_c(
+        &sb,
+        "    ]\n"
+        "    0 = i\n"
+        "    ?.. i 3 < [\n"
+        "        s 1 + = s\n"
+        "        i 1 + = i\n"
+        "    ]\n"
+        "    => s\n"
+        "]\n");
+    // the first and the last constant and local and the three iterations of
+    // the loop
+    sprintf(
+        line,
+        "(true @f) %i != ? 'Test Error' !! 'wrong result'\n",
+        1 + LARGE_FUNC_CONSTS + 1 + LARGE_FUNC_LOCALS + 3);
+    ok = ok && Nst_sb_push_c(&sb, line);
+    ok = ok && Nst_sb_push_c(
+        &sb,
+        "(false @f) 3 != ? 'Test Error' !! 'wrong result'\n");
+    test_assert_or_exit(ok, {
+        Nst_sb_destroy(&sb);
+        Nst_error_clear();
+    });
+
+    test_assert(run_code((char *)sb.value));
+    Nst_sb_destroy(&sb);
+
+    TEST_EXIT;
+}
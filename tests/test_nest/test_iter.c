@@ -27,7 +27,32 @@ TestResult test_iter_get_val(void)
 
 TestResult test_iter_range_new(void)
 {
-    return TEST_NOT_IMPL;
+    TEST_ENTER;
+
+    Nst_Obj *iter = Nst_iter_range_new(0, 6, 2);
+    test_assert_or_exit(iter != NULL, {});
+    test_assert(Nst_ITER_IS_NATIVE(iter));
+    test_assert_or_exit(Nst_iter_start(iter), Nst_dec_ref(iter));
+
+    for (i64 i = 0; i < 6; i += 2) {
+        Nst_Obj *val = Nst_iter_next(iter);
+        test_assert_or_exit(val != NULL, Nst_dec_ref(iter));
+        test_assert(val->type == Nst_t.Int && Nst_int_i64(val) == i);
+        Nst_dec_ref(val);
+    }
+    Nst_Obj *end = Nst_iter_next(iter);
+    test_assert(end == Nst_c.IEnd_iend);
+    Nst_ndec_ref(end);
+
+    // restarting a native iterator resets its state
+    test_assert_or_exit(Nst_iter_start(iter), Nst_dec_ref(iter));
+    Nst_Obj *first = Nst_iter_next(iter);
+    test_assert(first != NULL && Nst_int_i64(first) == 0);
+    Nst_ndec_ref(first);
+
+    Nst_dec_ref(iter);
+
+    TEST_EXIT;
 }
 
 TestResult test_iter_seq_new(void)
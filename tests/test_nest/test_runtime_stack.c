@@ -0,0 +1,93 @@
+#include "tests.h"
+
+TestResult test_vstack_shrink(void)
+{
+    TEST_ENTER;
+
+    Nst_ValueStack v_stack;
+    test_assert_or_exit(Nst_vstack_init(&v_stack), Nst_error_clear());
+    test_assert(v_stack.cap == _Nst_V_STACK_MIN_SIZE);
+
+    for (usize i = 0; i < 1000; i++) {
+        test_assert_or_exit(
+            Nst_vstack_push(&v_stack, Nst_null()),
+            Nst_vstack_destroy(&v_stack));
+    }
+    usize cap = v_stack.cap;
+    test_assert(cap >= 1000);
+
+    // popping never shrinks the stack
+    for (usize i = 0; i < 1000; i++)
+        Nst_dec_ref(Nst_vstack_pop(&v_stack));
+    test_assert(v_stack.len == 0);
+    test_assert(v_stack.cap == cap);
+    test_assert(Nst_vstack_pop(&v_stack) == NULL);
+
+    // the capacity is halved while less than an eighth of it is used
+    Nst_vstack_push(&v_stack, Nst_null());
+    Nst_vstack_shrink(&v_stack);
+    test_assert(v_stack.cap == cap / 2);
+    while (v_stack.cap > _Nst_V_STACK_MIN_SIZE) {
+        cap = v_stack.cap;
+        Nst_vstack_shrink(&v_stack);
+        test_assert_or_exit(v_stack.cap < cap, Nst_vstack_destroy(&v_stack));
+    }
+    Nst_vstack_shrink(&v_stack);
+    test_assert(v_stack.cap == _Nst_V_STACK_MIN_SIZE);
+    test_assert(v_stack.len == 1);
+    test_assert(Nst_vstack_peek(&v_stack) == Nst_null());
+
+    // a stack that is used enough is not shrunk
+    while (v_stack.len < 300)
+        Nst_vstack_push(&v_stack, Nst_null());
+    cap = v_stack.cap;
+    Nst_vstack_shrink(&v_stack);
+    test_assert(v_stack.cap == cap);
+
+    Nst_vstack_destroy(&v_stack);
+
+    TEST_EXIT;
+}
+
+TestResult test_fstack_push(void)
+{
+    TEST_ENTER;
+
+    Nst_CallStack f_stack;
+    test_assert_or_exit(Nst_fstack_init(&f_stack), Nst_error_clear());
+
+    Nst_FuncCall call = {
+        .func = NULL,
+        .span = Nst_span_empty(),
+        .vt.vars = NULL,
+        .vt.global_table = NULL,
+        .idx = 0,
+        .vstack_base = 0
+    };
+
+    for (usize i = 0; i < f_stack.max_recursion_depth; i++) {
+        call.vstack_base = i * 2;
+        test_assert_or_exit(
+            Nst_fstack_push(&f_stack, call),
+            Nst_fstack_destroy(&f_stack));
+    }
+    usize cap = f_stack.cap;
+
+    // the maximum depth cannot be exceeded
+    test_assert(!Nst_fstack_push(&f_stack, call) && Nst_error_occurred());
+    test_assert(f_stack.len == f_stack.max_recursion_depth);
+
+    for (usize i = f_stack.len; i-- > 0;) {
+        Nst_FuncCall popped = Nst_fstack_pop(&f_stack);
+        test_assert(popped.vstack_base == i * 2);
+    }
+    test_assert(f_stack.cap == cap);
+    test_assert(Nst_fstack_pop(&f_stack).func == NULL);
+
+    Nst_fstack_shrink(&f_stack);
+    test_assert(f_stack.cap == cap / 2);
+
+    Nst_fstack_destroy(&f_stack);
+
+    TEST_EXIT;
+}
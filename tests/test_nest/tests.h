@@ -166,9 +166,25 @@ TestResult test_repr(void);
 
 TestResult test_func_set_vt(void);
 
+// ggc.h
+
+TestResult test_ggc_collect(void);
+TestResult test_ggc_collect_old_gen(void);
+TestResult test_ggc_remove_objs(void);
+
 // hash.h
 
 TestResult test_obj_hash(void);
+TestResult test_str_hash_quality(void);
+TestResult test_str_hash_throughput(void);
+
+// interpreter.h
+
+TestResult test_run_profile(void);
+TestResult test_run_profile_long_inst(void);
+TestResult test_func_call_c(void);
+TestResult test_func_call_c_nested(void);
+TestResult test_run_large_function(void);
 
 // iter.h
 
@@ -226,6 +242,11 @@ TestResult test_realloc(void);
 TestResult test_crealloc(void);
 TestResult test_memset(void);
 
+// runtime_stack.h
+
+TestResult test_vstack_shrink(void);
+TestResult test_fstack_push(void);
+
 // sequence.h
 
 TestResult test_seq_new(void);